@@ -354,6 +354,8 @@ enum class PackingStrategy : unsigned {
   Optimized, // Optimize packing of all elements together (all elements must be
              // present, in the same order, for identical placement of any
              // individual element)
+  MinimalRows, // Like Optimized, but search for the packing using the fewest
+               // rows, within a fixed search budget
   Invalid,
 };
 
@@ -86,6 +86,14 @@ public:
   bool IsEntryOrPatchConstantFunction(const llvm::Function *pFunc) const;
   llvm::SmallVector<llvm::Function *, 64> GetExportedFunctions();
 
+  // Lazy loading.
+  // Modules loaded with dxilutil::LoadModuleFromBitcodeLazy keep function
+  // bodies in bitcode until they are requested; metadata-derived state
+  // (resources, signatures, type annotations) is available regardless.
+  bool HasUnmaterializedFunctions() const;
+  void MaterializeFunction(llvm::Function *F);
+  void MaterializeAllFunctions();
+
   // Flags.
   unsigned GetGlobalFlags() const;
   void CollectShaderFlagsForModule();
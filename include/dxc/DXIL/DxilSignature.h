@@ -56,6 +56,11 @@ public:
 
   unsigned GetRowCount() const;
 
+  // Removes the elements whose index is set in Remove and renumbers the IDs
+  // of the remaining elements. Returns the new ID of every old element, or
+  // UINT_MAX for removed elements.
+  std::vector<unsigned> RemoveElements(const std::vector<bool> &Remove);
+
 private:
   DXIL::SigPointKind m_sigPointKind;
   std::vector<std::unique_ptr<DxilSignatureElement>> m_Elements;
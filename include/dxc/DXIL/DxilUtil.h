@@ -144,15 +144,26 @@ llvm::BasicBlock *GetSwitchSuccessorForCond(llvm::SwitchInst *Switch,
                                             llvm::ConstantInt *Cond);
 void MigrateDebugValue(llvm::Value *Old, llvm::Value *New);
 void TryScatterDebugValueToVectorElements(llvm::Value *Val);
-std::unique_ptr<llvm::Module> LoadModuleFromBitcode(llvm::StringRef BC,
-                                                    llvm::LLVMContext &Ctx,
-                                                    std::string &DiagStr);
-std::unique_ptr<llvm::Module> LoadModuleFromBitcode(llvm::MemoryBuffer *MB,
-                                                    llvm::LLVMContext &Ctx,
-                                                    std::string &DiagStr);
+// The module loaders below take bSkipDebugInfo for consumers that never look
+// at debug info: when set, DI metadata nodes, debug locations and calls to
+// llvm.dbg.* intrinsics are skipped in the bitcode instead of being loaded,
+// and the module comes back as if it had been compiled without debug info.
+std::unique_ptr<llvm::Module>
+LoadModuleFromBitcode(llvm::StringRef BC, llvm::LLVMContext &Ctx,
+                      std::string &DiagStr, bool bSkipDebugInfo = false);
+std::unique_ptr<llvm::Module>
+LoadModuleFromBitcode(llvm::MemoryBuffer *MB, llvm::LLVMContext &Ctx,
+                      std::string &DiagStr, bool bSkipDebugInfo = false);
 std::unique_ptr<llvm::Module>
 LoadModuleFromBitcodeLazy(std::unique_ptr<llvm::MemoryBuffer> &&MB,
-                          llvm::LLVMContext &Ctx, std::string &DiagStr);
+                          llvm::LLVMContext &Ctx, std::string &DiagStr,
+                          bool bSkipDebugInfo = false);
+// Lazily load a module, materializing all module-level metadata but leaving
+// function bodies to be materialized on demand. The bitcode in BC must outlive
+// the returned module.
+std::unique_ptr<llvm::Module>
+LoadModuleFromBitcodeLazy(llvm::StringRef BC, llvm::LLVMContext &Ctx,
+                          std::string &DiagStr, bool bSkipDebugInfo = false);
 void PrintDiagnosticHandler(const llvm::DiagnosticInfo &DI, void *Context);
 bool IsIntegerOrFloatingPointType(llvm::Type *Ty);
 // Returns true if type contains HLSL Object type (resource)
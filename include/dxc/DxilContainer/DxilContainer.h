@@ -306,6 +306,25 @@ struct DxilCompilerVersion {
 //      char ArgName[]; char NullTerm;
 //      char ArgValue[]; char NullTerm;
 //
+// ================ 4. Source Content Blocks ===========================
+//
+// Replaces Source Contents. The contents are grouped into blocks that are
+// compressed independently, so one source can be read without decompressing
+// the others. Readers that don't know this section see no contents.
+//
+//  DxilSourceInfo_SourceContentBlocks
+//
+//     DxilSourceInfo_SourceContentBlocksEntry (one per source, in the order
+//     of the Source Names section)
+//
+//     DxilSourceInfo_SourceContentBlock (one per block)
+//
+//     char BlockData[] (each block's data, at the offset given by its
+//     DxilSourceInfo_SourceContentBlock)
+//
+// Uncompressed, a block is the null-terminated contents of its sources,
+// back to back.
+//
 
 struct DxilSourceInfo {
   uint32_t
@@ -318,6 +337,7 @@ enum class DxilSourceInfoSectionType : uint16_t {
   SourceContents = 0,
   SourceNames = 1,
   Args = 2,
+  SourceContentBlocks = 3,
 };
 
 struct DxilSourceInfoSection {
@@ -399,6 +419,32 @@ struct DxilSourceInfo_SourceContentsEntry {
   // 4-byte boundary.
 };
 
+struct DxilSourceInfo_SourceContentBlocks {
+  uint32_t Flags;      // Reserved, must be set to 0.
+  uint32_t Count;      // The number of sources.
+  uint32_t BlockCount; // The number of blocks.
+  // Followed by `Count` DxilSourceInfo_SourceContentBlocksEntry, then
+  // `BlockCount` DxilSourceInfo_SourceContentBlock, then the block data.
+};
+
+struct DxilSourceInfo_SourceContentBlocksEntry {
+  uint32_t Block;              // Index of the block holding the content.
+  uint32_t Offset;             // Offset of the content in the uncompressed
+                               // block.
+  uint32_t ContentSizeInBytes; // Size of the content, *including* the null
+                               // terminator.
+};
+
+struct DxilSourceInfo_SourceContentBlock {
+  uint32_t Offset;      // Offset of the block data from the end of the block
+                        // table.
+  uint32_t SizeInBytes; // Size of the (compressed) block data.
+  uint32_t UncompressedSizeInBytes; // Size of the block when uncompressed.
+  uint16_t Flags;                   // Reserved, must be set to 0.
+  DxilSourceInfo_SourceContentsCompressType
+      CompressType; // The type of compression used for this block.
+};
+
 #pragma pack(pop)
 
 enum class DxilShaderPDBInfoVersion : uint16_t {
@@ -383,6 +383,17 @@ bool VerifyRootSignature(const DxilVersionedRootSignatureDesc *pDesc,
                          llvm::raw_ostream &DiagStream,
                          bool bAllowReservedRegisterSpace);
 
+// Variants taking a serialized root signature. Root signatures that pass
+// verification are cached by content, so verifying more shaders against the
+// same one neither deserializes nor re-verifies it. Deserialization errors
+// are thrown; verification errors are written to DiagStream.
+bool VerifySerializedRootSignatureWithShaderPSV(
+    const void *pRSData, uint32_t RSSize, DXIL::ShaderKind ShaderKind,
+    const void *pPSVData, uint32_t PSVSize, llvm::raw_ostream &DiagStream);
+bool VerifySerializedRootSignature(const void *pRSData, uint32_t RSSize,
+                                   llvm::raw_ostream &DiagStream,
+                                   bool bAllowReservedRegisterSpace);
+
 class DxilVersionedRootSignature {
   DxilVersionedRootSignatureDesc *m_pRootSignature;
 
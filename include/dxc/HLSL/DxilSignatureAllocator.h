@@ -172,9 +172,29 @@ public:
   unsigned PackPrefixStable(std::vector<PackElement *> elements,
                             unsigned startRow, unsigned numRows);
 
+  // Like PackOptimized, but searches for the placement of arbitrary and system
+  // value elements that uses the fewest rows. The search visits a bounded
+  // number of placements, so the result is deterministic, and the
+  // PackOptimized placement is kept unless fewer rows are used.
+  unsigned PackMinimalRows(std::vector<PackElement *> elements,
+                           unsigned startRow, unsigned numRows);
+
   bool UseMinPrecision() const { return m_bUseMinPrecision; }
 
 protected:
+  struct MinimalRowsSearch;
+
+  unsigned PackOptimizedImpl(std::vector<PackElement *> &elements,
+                             unsigned startRow, unsigned numRows,
+                             bool bMinimizeRows);
+  // Moves elements placed by PackGreedy to a placement using fewer rows, if
+  // one is found. initialRegisters holds the registers before PackGreedy and
+  // prevRowsUsed the rows used by elements placed before that.
+  unsigned RepackMinimalRows(const std::vector<PackElement *> &elements,
+                             const std::vector<PackedRegister> &initialRegisters,
+                             unsigned startRow, unsigned numRows,
+                             unsigned prevRowsUsed, unsigned greedyRowsUsed);
+
   std::vector<PackedRegister> m_Registers;
   bool m_bIgnoreIndexing;
   bool m_bUseMinPrecision;
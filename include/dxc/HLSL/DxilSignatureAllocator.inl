@@ -310,6 +310,13 @@ static_assert(DXIL::kMaxClipOrCullDistanceElementCount == 2,
 unsigned
 DxilSignatureAllocator::PackOptimized(std::vector<PackElement *> elements,
                                       unsigned startRow, unsigned numRows) {
+  return PackOptimizedImpl(elements, startRow, numRows,
+                           /*bMinimizeRows*/ false);
+}
+
+unsigned DxilSignatureAllocator::PackOptimizedImpl(
+    std::vector<PackElement *> &elements, unsigned startRow, unsigned numRows,
+    bool bMinimizeRows) {
   unsigned rowsUsed = 0;
 
   // Clip/Cull needs special handling due to limitations unique to these.
@@ -408,19 +415,31 @@ DxilSignatureAllocator::PackOptimized(std::vector<PackElement *> elements,
                         PackGreedy(indexedtessElements, startRow, numRows, 3));
   }
 
+  // Keep the registers as they are before arbitrary and system values are
+  // placed, to search from.
+  std::vector<PackedRegister> initialRegisters;
+  if (bMinimizeRows)
+    initialRegisters = m_Registers;
+
   // ==========
   // Allocate arbitrary
-  if (!arbElements.empty()) {
-    std::sort(arbElements.begin(), arbElements.end(), CmpElementsLess);
-    rowsUsed = std::max(rowsUsed, PackGreedy(arbElements, startRow, numRows));
-  }
+  std::sort(arbElements.begin(), arbElements.end(), CmpElementsLess);
+  unsigned arbRowsUsed = PackGreedy(arbElements, startRow, numRows);
 
   // ==========
   // Allocate system values
-  if (!svElements.empty()) {
-    std::sort(svElements.begin(), svElements.end(), CmpElementsLess);
-    rowsUsed = std::max(rowsUsed, PackGreedy(svElements, startRow, numRows));
+  std::sort(svElements.begin(), svElements.end(), CmpElementsLess);
+  unsigned svRowsUsed = PackGreedy(svElements, startRow, numRows);
+
+  unsigned greedyRowsUsed = std::max(arbRowsUsed, svRowsUsed);
+  if (bMinimizeRows && greedyRowsUsed > rowsUsed) {
+    // Search arbitrary and system values together, in the greedy order.
+    arbElements.insert(arbElements.end(), svElements.begin(),
+                       svElements.end());
+    greedyRowsUsed = RepackMinimalRows(arbElements, initialRegisters, startRow,
+                                       numRows, rowsUsed, greedyRowsUsed);
   }
+  rowsUsed = std::max(rowsUsed, greedyRowsUsed);
 
   // ==========
   // Allocate clip/cull
@@ -540,6 +559,167 @@ DxilSignatureAllocator::PackOptimized(std::vector<PackElement *> elements,
   return rowsUsed;
 }
 
+// Upper bound on the number of placements tried by PackMinimalRows for one
+// signature. Counting placements rather than time keeps the packing identical
+// from one compile to the next.
+static const unsigned kMinimalRowsSearchBudget = 1 << 16;
+
+// Depth-first branch and bound search used by RepackMinimalRows. Elements are
+// visited in order, and each tries every legal location ending before the
+// best row count found so far.
+struct DxilSignatureAllocator::MinimalRowsSearch {
+  typedef std::pair<unsigned, unsigned> Location;
+
+  DxilSignatureAllocator &Alloc;
+  const std::vector<PackElement *> &Elements;
+  unsigned StartRow, EndRow;
+  unsigned Budget;
+  unsigned BestRows;
+  std::vector<unsigned> RemainingComponents;
+  std::vector<Location> Current, Best;
+
+  MinimalRowsSearch(DxilSignatureAllocator &Alloc,
+                    const std::vector<PackElement *> &Elements,
+                    unsigned StartRow, unsigned EndRow, unsigned BestRows)
+      : Alloc(Alloc), Elements(Elements), StartRow(StartRow), EndRow(EndRow),
+        Budget(kMinimalRowsSearchBudget), BestRows(BestRows),
+        RemainingComponents(Elements.size() + 1, 0),
+        Current(Elements.size()) {
+    for (unsigned i = Elements.size(); i > 0; --i) {
+      const PackElement *SE = Elements[i - 1];
+      RemainingComponents[i - 1] =
+          RemainingComponents[i] + SE->GetRows() * SE->GetCols();
+    }
+  }
+
+  unsigned CountFreeComponents(unsigned endRow) const {
+    unsigned freeComponents = 0;
+    for (unsigned row = StartRow; row < endRow; ++row) {
+      for (unsigned i = 0; i < 4; ++i) {
+        if ((Alloc.m_Registers[row].Flags[i] & kEFOccupied) == 0)
+          ++freeComponents;
+      }
+    }
+    return freeComponents;
+  }
+
+  void Search(unsigned index, unsigned rowsUsed) {
+    if (index == Elements.size()) {
+      if (rowsUsed < BestRows) {
+        BestRows = rowsUsed;
+        Best = Current;
+      }
+      return;
+    }
+    // Give up on this branch if the remaining elements can't fit in the rows
+    // left below the best result.
+    if (BestRows <= StartRow + 1 ||
+        RemainingComponents[index] > CountFreeComponents(BestRows - 1))
+      return;
+
+    PackElement *SE = Elements[index];
+    unsigned rows = SE->GetRows();
+    unsigned cols = SE->GetCols();
+    // Rows past rowsUsed are all empty, so only the first of them is tried.
+    for (unsigned row = StartRow;
+         row <= rowsUsed && row + rows < BestRows && row + rows <= EndRow;
+         ++row) {
+      if (Alloc.DetectRowConflict(SE, row))
+        continue;
+      for (unsigned col = 0; col + cols <= 4; ++col) {
+        if (Alloc.DetectColConflict(SE, row, col))
+          continue;
+        if (Budget == 0)
+          return;
+        --Budget;
+        std::vector<PackedRegister> saved(Alloc.m_Registers.begin() + row,
+                                          Alloc.m_Registers.begin() + row +
+                                              rows);
+        Alloc.PlaceElement(SE, row, col);
+        Current[index] = Location(row, col);
+        Search(index + 1, std::max(rowsUsed, row + rows));
+        std::copy(saved.begin(), saved.end(), Alloc.m_Registers.begin() + row);
+        if (row + rows >= BestRows)
+          break;
+      }
+    }
+  }
+};
+
+unsigned DxilSignatureAllocator::RepackMinimalRows(
+    const std::vector<PackElement *> &elements,
+    const std::vector<PackedRegister> &initialRegisters, unsigned startRow,
+    unsigned numRows, unsigned prevRowsUsed, unsigned greedyRowsUsed) {
+  // Only complete placements are searched.
+  for (auto &SE : elements) {
+    if (!SE->IsAllocated())
+      return greedyRowsUsed;
+  }
+
+  std::vector<PackedRegister> greedyRegisters = initialRegisters;
+  greedyRegisters.swap(m_Registers);
+  unsigned endRow =
+      std::min(startRow + numRows, (unsigned)m_Registers.size());
+  MinimalRowsSearch search(*this, elements, startRow, endRow, greedyRowsUsed);
+  search.Search(0, std::max(startRow, prevRowsUsed));
+  if (search.Best.empty()) {
+    m_Registers.swap(greedyRegisters);
+    return greedyRowsUsed;
+  }
+
+  for (unsigned i = 0; i < elements.size(); ++i) {
+    PackElement *SE = elements[i];
+    unsigned row = search.Best[i].first;
+    unsigned col = search.Best[i].second;
+    PlaceElement(SE, row, col);
+    SE->SetLocation(row, col);
+  }
+  return search.BestRows;
+}
+
+unsigned
+DxilSignatureAllocator::PackMinimalRows(std::vector<PackElement *> elements,
+                                        unsigned startRow, unsigned numRows) {
+  // Pack as PackOptimized does first, since clip/cull and system generated
+  // values placed after the search may still end up using more rows.
+  std::vector<PackedRegister> initialRegisters = m_Registers;
+  unsigned optimizedRowsUsed = PackOptimizedImpl(elements, startRow, numRows,
+                                                 /*bMinimizeRows*/ false);
+  unsigned optimizedAllocated = 0;
+  std::vector<std::pair<unsigned, unsigned>> optimizedLocations;
+  optimizedLocations.reserve(elements.size());
+  for (auto &SE : elements) {
+    if (SE->IsAllocated()) {
+      optimizedLocations.emplace_back(SE->GetStartRow(), SE->GetStartCol());
+      ++optimizedAllocated;
+    } else {
+      optimizedLocations.emplace_back((uint32_t)-1, (uint32_t)-1);
+    }
+  }
+
+  std::vector<PackedRegister> optimizedRegisters = initialRegisters;
+  optimizedRegisters.swap(m_Registers);
+  unsigned rowsUsed = PackOptimizedImpl(elements, startRow, numRows,
+                                        /*bMinimizeRows*/ true);
+  unsigned allocated = 0;
+  for (auto &SE : elements) {
+    if (SE->IsAllocated())
+      ++allocated;
+  }
+  if (rowsUsed < optimizedRowsUsed && allocated >= optimizedAllocated)
+    return rowsUsed;
+
+  m_Registers.swap(optimizedRegisters);
+  for (unsigned i = 0; i < elements.size(); ++i) {
+    PackElement *SE = elements[i];
+    SE->ClearLocation();
+    if (optimizedLocations[i].first != (uint32_t)-1)
+      SE->SetLocation(optimizedLocations[i].first,
+                      optimizedLocations[i].second);
+  }
+  return optimizedRowsUsed;
+}
+
 unsigned
 DxilSignatureAllocator::PackPrefixStable(std::vector<PackElement *> elements,
                                          unsigned startRow, unsigned numRows) {
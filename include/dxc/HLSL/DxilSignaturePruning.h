@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilSignaturePruning.h                                                    //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Removes signature elements that are not used across a pipeline of         //
+// shader stages compiled together.                                          //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "dxc/DXIL/DxilConstants.h"
+#include "llvm/ADT/ArrayRef.h"
+
+#include <vector>
+
+namespace llvm {
+class Module;
+}
+
+namespace hlsl {
+
+// Removes arbitrary signature elements that no later stage reads from a
+// pipeline of DXIL modules, given in pipeline order (VS, HS, DS, GS, PS or
+// AS, MS, PS; any stage may be omitted). Stores to removed outputs are
+// erased, the code that only fed them is deleted, and the linked signatures
+// are repacked with the given strategy when the producer can match the
+// consumer's new layout, otherwise the remaining elements keep their
+// locations. Stages that do not share a signature are left alone, as are
+// geometry shaders with more than one output stream.
+//
+// Changed[i] is set when Stages[i] was modified; the view ID state and the
+// metadata of changed modules are updated. Returns the number of elements
+// removed from all signatures.
+unsigned PrunePipelineSignatures(llvm::ArrayRef<llvm::Module *> Stages,
+                                 DXIL::PackingStrategy Packing,
+                                 std::vector<bool> &Changed);
+
+} // namespace hlsl
@@ -12,11 +12,18 @@
 #pragma once
 
 #include "dxc/Support/Global.h"
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <map>
-#include <set>
+#include <vector>
 
 namespace hlsl {
 
+// Spans are kept sorted in a list of small sorted blocks rather than in a
+// node-based set, so there is no allocation per span and lookups are binary
+// searches over contiguous memory. Each block also tracks the largest free gap
+// between its spans, letting gap searches skip over densely packed blocks.
 template <typename T_index, typename T_element> class SpanAllocator {
 public:
   struct Span {
@@ -28,7 +35,64 @@ public:
     T_index start, end; // inclusive
     bool operator<(const Span &other) const { return end < other.start; }
   };
-  typedef std::set<Span> SpanSet;
+
+private:
+  static const size_t kMaxBlockSpans = 128;
+  struct Block {
+    std::vector<Span> Spans; // Sorted, disjoint and never empty.
+    T_index MaxGap;          // Largest free range between two Spans.
+  };
+  typedef std::vector<Block> BlockVector;
+
+  // Position of a span: index of its block and index within the block.
+  // The end position is {m_Blocks.size(), 0}.
+  struct SpanPos {
+    size_t B, I;
+  };
+
+public:
+  // Read-only view of all spans, in order.
+  class SpanList {
+  public:
+    class const_iterator {
+    public:
+      typedef std::forward_iterator_tag iterator_category;
+      typedef Span value_type;
+      typedef std::ptrdiff_t difference_type;
+      typedef const Span *pointer;
+      typedef const Span &reference;
+
+      const_iterator(const BlockVector &Blocks, size_t B)
+          : Blocks(&Blocks), B(B), I(0) {}
+      reference operator*() const { return (*Blocks)[B].Spans[I]; }
+      pointer operator->() const { return &**this; }
+      const_iterator &operator++() {
+        if (++I == (*Blocks)[B].Spans.size()) {
+          ++B;
+          I = 0;
+        }
+        return *this;
+      }
+      bool operator==(const const_iterator &other) const {
+        return B == other.B && I == other.I;
+      }
+      bool operator!=(const const_iterator &other) const {
+        return !(*this == other);
+      }
+
+    private:
+      const BlockVector *Blocks;
+      size_t B, I;
+    };
+
+    explicit SpanList(const BlockVector &Blocks) : Blocks(Blocks) {}
+    const_iterator begin() const { return const_iterator(Blocks, 0); }
+    const_iterator end() const { return const_iterator(Blocks, Blocks.size()); }
+    bool empty() const { return Blocks.empty(); }
+
+  private:
+    const BlockVector &Blocks;
+  };
 
 public:
   SpanAllocator(T_index Min, T_index Max)
@@ -42,7 +106,7 @@ public:
   bool IsFull() { return m_AllocationFull; }
   void SetUnbounded(const T_element *element) { m_Unbounded = element; }
   const T_element *GetUnbounded() const { return m_Unbounded; }
-  const SpanSet &GetSpans() const { return m_Spans; }
+  SpanList GetSpans() const { return SpanList(m_Blocks); }
 
   // Find size gap starting at pos, updating pos, and returning true if
   // successful
@@ -55,20 +119,20 @@ public:
     if (!UpdatePos(pos, size, align))
       return false;
     T_index end = pos + (size - 1);
-    auto next = m_Spans.lower_bound(Span(nullptr, pos, end));
-    if (next == m_Spans.end() || end < next->start)
+    SpanPos next = LowerBound(pos);
+    if (IsEnd(next) || end < At(next).start)
       return true; // it fits here
     return Find(size, next, pos, align);
   }
 
   // Finds the farthest position at which an element could be allocated.
   bool FindForUnbounded(T_index &pos, T_index align = 1) {
-    if (m_Spans.empty()) {
+    if (m_Blocks.empty()) {
       pos = m_Min;
       return UpdatePos(pos, /*size*/ 1, align);
     }
 
-    pos = m_Spans.crbegin()->end;
+    pos = Last().end;
     return IncPos(pos, /*inc*/ 1, /*size*/ 1, align);
   }
 
@@ -83,32 +147,28 @@ public:
     pos = m_FirstFree;
     if (!UpdatePos(pos, size, align))
       return false;
-    auto result = m_Spans.emplace(element, pos, pos + (size - 1));
-    if (result.second) {
-      AdvanceFirstFree(result.first);
+    SpanPos where;
+    if (TryInsert(element, pos, pos + (size - 1), where)) {
+      AdvanceFirstFree(where);
       return true;
     }
-    // Collision, find a gap from iterator
-    if (!Find(size, result.first, pos, align))
+    // Collision, find a gap from the conflicting span
+    if (!Find(size, where, pos, align))
       return false;
-    result = m_Spans.emplace(element, pos, pos + (size - 1));
-    return result.second;
+    return TryInsert(element, pos, pos + (size - 1), where);
   }
 
   bool AllocateUnbounded(const T_element *element, T_index &pos,
                          T_index align = 1) {
     if (m_AllocationFull)
       return false;
-    if (m_Spans.empty()) {
+    if (m_Blocks.empty()) {
       pos = m_Min;
       if (!UpdatePos(pos, /*size*/ 1, align))
         return false;
     } else {
       // This will allocate after the last span
-      auto it = m_Spans.end();
-      --it; // find last span
-      DXASSERT_NOMSG(it != m_Spans.end());
-      pos = it->end;
+      pos = Last().end;
       if (!IncPos(pos, /*inc*/ 1, /*size*/ 1, align))
         return false;
     }
@@ -123,10 +183,10 @@ public:
   const T_element *Insert(const T_element *element, T_index start,
                           T_index end) {
     DXASSERT_NOMSG(m_Min <= start && start <= end && end <= m_Max);
-    auto result = m_Spans.emplace(element, start, end);
-    if (!result.second)
-      return result.first->element;
-    AdvanceFirstFree(result.first);
+    SpanPos where;
+    if (!TryInsert(element, start, end, where))
+      return At(where).element;
+    AdvanceFirstFree(where);
     return nullptr;
   }
 
@@ -135,52 +195,146 @@ public:
   void ForceInsertAndClobber(const T_element *element, T_index start,
                              T_index end) {
     DXASSERT_NOMSG(m_Min <= start && start <= end && end <= m_Max);
-    for (;;) {
-      auto result = m_Spans.emplace(element, start, end);
-      if (result.second)
-        break;
+    SpanPos where;
+    while (!TryInsert(element, start, end, where)) {
       // Delete the spans we overlap with, but make sure our new span covers
       // what they covered.
-      start = std::min(result.first->start, start);
-      end = std::max(result.first->end, end);
-      m_Spans.erase(result.first);
+      start = std::min(At(where).start, start);
+      end = std::max(At(where).end, end);
+      Erase(where);
     }
   }
 
 private:
-  // Find size gap starting at iterator, updating pos, and returning true if
-  // successful
-  bool Find(T_index size, typename SpanSet::const_iterator it, T_index &pos,
-            T_index align = 1) {
-    pos = it->end;
-    if (!IncPos(pos, /*inc*/ 1, size, align))
-      return false;
-    for (++it;
-         it != m_Spans.end() && (it->start < pos || it->start - pos < size);
-         ++it) {
-      pos = it->end;
+  // Find size gap starting at the span at it, updating pos, and returning true
+  // if successful
+  bool Find(T_index size, SpanPos it, T_index &pos, T_index align = 1) {
+    for (;;) {
+      // If no gap between spans of this block can hold size, the search can't
+      // stop before its last span.
+      const Block &block = m_Blocks[it.B];
+      if (block.MaxGap < size)
+        it.I = block.Spans.size() - 1;
+      pos = At(it).end;
       if (!IncPos(pos, /*inc*/ 1, size, align))
         return false;
+      it = Next(it);
+      if (IsEnd(it) || !(At(it).start < pos || At(it).start - pos < size))
+        return true;
     }
-    return true;
   }
 
   // Advance m_FirstFree if it's in span
-  void AdvanceFirstFree(typename SpanSet::const_iterator it) {
-    if (it->start <= m_FirstFree && m_FirstFree <= it->end) {
-      for (; it != m_Spans.end();) {
-        if (it->end >= m_Max) {
+  void AdvanceFirstFree(SpanPos it) {
+    if (At(it).start <= m_FirstFree && m_FirstFree <= At(it).end) {
+      while (!IsEnd(it)) {
+        // Spans of a block without gaps are contiguous, go to the last one.
+        const Block &block = m_Blocks[it.B];
+        if (block.MaxGap == 0)
+          it.I = block.Spans.size() - 1;
+        if (At(it).end >= m_Max) {
           m_AllocationFull = true;
           break;
         }
-        m_FirstFree = it->end + 1;
-        ++it;
-        if (it != m_Spans.end() && m_FirstFree < it->start)
+        m_FirstFree = At(it).end + 1;
+        it = Next(it);
+        if (!IsEnd(it) && m_FirstFree < At(it).start)
           break;
       }
     }
   }
 
+  bool IsEnd(SpanPos it) const { return it.B == m_Blocks.size(); }
+  const Span &At(SpanPos it) const { return m_Blocks[it.B].Spans[it.I]; }
+  const Span &Last() const { return m_Blocks.back().Spans.back(); }
+  SpanPos Next(SpanPos it) const {
+    if (++it.I == m_Blocks[it.B].Spans.size()) {
+      ++it.B;
+      it.I = 0;
+    }
+    return it;
+  }
+
+  // First span that ends at or after pos.
+  SpanPos LowerBound(T_index pos) const {
+    auto block = std::lower_bound(
+        m_Blocks.begin(), m_Blocks.end(), pos,
+        [](const Block &B, T_index P) { return B.Spans.back().end < P; });
+    SpanPos it = {(size_t)(block - m_Blocks.begin()), 0};
+    if (IsEnd(it))
+      return it;
+    auto span = std::lower_bound(
+        block->Spans.begin(), block->Spans.end(), pos,
+        [](const Span &S, T_index P) { return S.end < P; });
+    it.I = span - block->Spans.begin();
+    return it;
+  }
+
+  // Inserts a new span, returning true and its position in where. On
+  // collision, returns false with the first overlapping span in where.
+  bool TryInsert(const T_element *element, T_index start, T_index end,
+                 SpanPos &where) {
+    where = LowerBound(start);
+    if (!IsEnd(where) && At(where).start <= end)
+      return false;
+
+    Span span(element, start, end);
+    if (m_Blocks.empty()) {
+      m_Blocks.emplace_back();
+      m_Blocks.back().Spans.push_back(span);
+      m_Blocks.back().MaxGap = 0;
+      where.B = where.I = 0;
+      return true;
+    }
+    if (IsEnd(where)) {
+      // Append, starting a new block if the last one is full so that spans
+      // added in order leave full blocks behind.
+      if (m_Blocks.back().Spans.size() >= kMaxBlockSpans) {
+        m_Blocks.emplace_back();
+        m_Blocks.back().MaxGap = 0;
+      }
+      where.B = m_Blocks.size() - 1;
+      where.I = m_Blocks[where.B].Spans.size();
+    }
+
+    std::vector<Span> &spans = m_Blocks[where.B].Spans;
+    spans.insert(spans.begin() + where.I, span);
+    if (spans.size() > kMaxBlockSpans) {
+      // Split in halves, moving the upper one to a new block.
+      size_t half = spans.size() / 2;
+      Block upper;
+      upper.Spans.assign(spans.begin() + half, spans.end());
+      spans.erase(spans.begin() + half, spans.end());
+      m_Blocks.insert(m_Blocks.begin() + where.B + 1, std::move(upper));
+      UpdateMaxGap(m_Blocks[where.B + 1]);
+      if (where.I >= half) {
+        where.I -= half;
+        ++where.B;
+        UpdateMaxGap(m_Blocks[where.B - 1]);
+        return true;
+      }
+    }
+    UpdateMaxGap(m_Blocks[where.B]);
+    return true;
+  }
+
+  void Erase(SpanPos it) {
+    Block &block = m_Blocks[it.B];
+    block.Spans.erase(block.Spans.begin() + it.I);
+    if (block.Spans.empty())
+      m_Blocks.erase(m_Blocks.begin() + it.B);
+    else
+      UpdateMaxGap(block);
+  }
+
+  static void UpdateMaxGap(Block &block) {
+    block.MaxGap = 0;
+    for (size_t i = 1; i < block.Spans.size(); ++i) {
+      T_index gap = block.Spans[i].start - block.Spans[i - 1].end - 1;
+      block.MaxGap = std::max(block.MaxGap, gap);
+    }
+  }
+
   T_index Align(T_index pos, T_index align) {
     T_index rem = (1 < align) ? pos % align : 0;
     return rem ? pos + (align - rem) : pos;
@@ -205,7 +359,7 @@ private:
   }
 
 private:
-  SpanSet m_Spans;
+  BlockVector m_Blocks;
   T_index m_Min, m_Max, m_FirstFree;
   const T_element *m_Unbounded;
   bool m_AllocationFull;
@@ -58,11 +58,13 @@ HRESULT ValidateDxilContainerParts(llvm::Module *pModule,
                                    const DxilContainerHeader *pContainer,
                                    uint32_t ContainerSize);
 
-// Loads module, validating load, but not module.
+// Loads module, validating load, but not module. With bSkipDebugInfo, debug
+// info metadata, locations and intrinsic calls are skipped, not loaded.
 HRESULT ValidateLoadModule(const char *pIL, uint32_t ILLength,
                            std::unique_ptr<llvm::Module> &pModule,
                            llvm::LLVMContext &Ctx,
-                           llvm::raw_ostream &DiagStream, unsigned bLazyLoad);
+                           llvm::raw_ostream &DiagStream, unsigned bLazyLoad,
+                           bool bSkipDebugInfo = false);
 
 // Loads module from container, validating load, but not module.
 HRESULT ValidateLoadModuleFromContainer(
@@ -71,11 +73,14 @@ HRESULT ValidateLoadModuleFromContainer(
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
     llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream);
 // Lazy loads module from container, validating load, but not module.
+// With bSkipProgramDebugInfo, debug info in the program part is skipped; the
+// debug part, if any, is always loaded in full.
 HRESULT ValidateLoadModuleFromContainerLazy(
     const void *pContainer, uint32_t ContainerSize,
     std::unique_ptr<llvm::Module> &pModule,
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
-    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream);
+    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream,
+    bool bSkipProgramDebugInfo = false);
 
 // Load and validate Dxil module from bitcode.
 HRESULT ValidateDxilBitcode(const char *pIL, uint32_t ILLength,
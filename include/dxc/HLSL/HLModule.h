@@ -63,7 +63,7 @@ struct HLOptions {
   unsigned bDisableOptimizations : 1;
   unsigned bLegacyCBufferLoad : 1;
   unsigned PackingStrategy : 2;
-  static_assert((unsigned)DXIL::PackingStrategy::Invalid < 4,
+  static_assert((unsigned)DXIL::PackingStrategy::MinimalRows < 4,
                 "otherwise 2 bits is not enough to store PackingStrategy");
   unsigned bUseMinPrecision : 1;
   unsigned bDX9CompatMode : 1;
@@ -129,6 +129,7 @@ public:
       llvm::opt::InputArgList(nullptr, nullptr); // Original arguments.
 
   llvm::StringRef AssemblyCode;               // OPT_Fc
+  llvm::StringRef BatchFile;                  // OPT_batch
   llvm::StringRef DebugFile;                  // OPT_Fd
   llvm::StringRef EntryPoint;                 // OPT_entrypoint
   llvm::StringRef ExternalFn;                 // OPT_external_fn
@@ -143,6 +144,7 @@ public:
   llvm::StringRef OutputRootSigFile;          // OPT_Frs
   llvm::StringRef OutputShaderHashFile;       // OPT_Fsh
   llvm::StringRef OutputFileForDependencies;  // OPT_write_dependencies_to
+  llvm::StringRef PipelineFile;               // OPT_pipeline
   std::string Preprocess;                     // OPT_P
   llvm::StringRef TargetProfile;              // OPT_target_profile
   llvm::StringRef VariableName;               // OPT_Vn
@@ -157,6 +159,9 @@ public:
   llvm::StringRef ImportBindingTable;         // OPT_import_binding_table
   llvm::StringRef BindingTableDefine;         // OPT_binding_table_define
   unsigned DefaultTextCodePage = DXC_CP_UTF8; // OPT_encoding
+  unsigned BatchJobs = 0;                     // OPT_batch_jobs
+  std::vector<std::string> DisasmFunctions;   // OPT_disasm_function
+  unsigned DisasmThreads = 1;                 // OPT_disasm_threads
 
   bool AllResourcesBound = false;         // OPT_all_resources_bound
   bool IgnoreOptSemDefs = false;          // OPT_ignore_opt_semdefs
@@ -172,6 +177,7 @@ public:
   bool DumpDependencies = false;          // OPT_dump_dependencies
   bool WriteDependencies = false;         // OPT_write_dependencies
   bool Link = false;                      // OPT_link
+  bool Server = false;                    // OPT_server
   bool WarningAsError = false;            // OPT__SLASH_WX
   bool IEEEStrict = false;                // OPT_Gis
   bool IgnoreLineDirectives = false;      // OPT_ignore_line_directives
@@ -200,6 +206,7 @@ public:
   bool NotUseLegacyCBufLoad = false;      // OPT_no_legacy_cbuf_layout
   bool PackPrefixStable = false;          // OPT_pack_prefix_stable
   bool PackOptimized = false;             // OPT_pack_optimized
+  bool PackMinimalRows = false;           // OPT_pack_minimal_rows
   bool DisplayIncludeProcess = false;     // OPT__vi
   bool RecompileFromBinary =
       false; // OPT _Recompile (Recompiling the DXBC binary file not .hlsl file)
@@ -208,6 +215,8 @@ public:
   bool SourceInDebugModule = false;          // OPT Zs
   bool SourceOnlyDebug = false;              // OPT Qsource_only_debug
   bool PdbInPrivate = false;                 // OPT Qpdb_in_private
+  bool PdbSourceBlocks = false;              // OPT Qpdb_source_blocks
+  bool ReuseLLVMContext = false;             // OPT Qreuse_llvm_context
   bool StripRootSignature = false;           // OPT_Qstrip_rootsignature
   bool StripPrivate = false;                 // OPT_Qstrip_priv
   bool StripReflection = false;              // OPT_Qstrip_reflect
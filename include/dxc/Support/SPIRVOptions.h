@@ -96,6 +96,15 @@ struct SpirvCodeGenOptions {
 
   bool printAll; // Dump SPIR-V module before each pass and after the last one.
 
+  /// Whether optimized SPIR-V is memoized by a hash of the legalized module
+  /// and the optimizer configuration.
+  bool enableOptCache;
+  /// Directory used to persist the optimization cache. Empty means the cache
+  /// is kept in memory only.
+  llvm::StringRef optCacheDir;
+  /// Whether every optimizer cache lookup is reported as a remark.
+  bool reportOptCache;
+
   // String representation of all command line options and input file.
   std::string clOptions;
   std::string inputFile;
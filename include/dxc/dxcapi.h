@@ -865,6 +865,32 @@ struct IDxcCompiler3 : public IUnknown {
       ) = 0;
 };
 
+CROSS_PLATFORM_UUIDOF(IDxcStreamingDisassembler,
+                      "93BCEF6A-1846-467E-91A0-9E45828678BA")
+/// \brief Interface to disassemble large programs, such as DXR libraries,
+/// without holding the whole listing in memory.
+///
+/// Query an instance of CLSID_DxcCompiler for this interface.
+struct IDxcStreamingDisassembler : public IUnknown {
+  /// \brief Disassemble a program, writing the UTF-8 text to pSink as it is
+  /// produced.
+  ///
+  /// When pFunctionNames is given, only the named functions (by name or by
+  /// unmangled name) have their bodies printed; the rest of the listing,
+  /// including metadata numbering, is the same as the full disassembly.
+  /// Function bodies are printed by up to threadCount threads, 0 meaning one
+  /// per hardware thread; the output does not depend on the thread count.
+  virtual HRESULT STDMETHODCALLTYPE DisassembleToStream(
+      _In_ const DxcBuffer
+          *pObject, ///< Program to disassemble: dxil container or bitcode.
+      _In_opt_count_(functionCount)
+          LPCWSTR *pFunctionNames, ///< Functions to print, or null for all.
+      _In_ UINT32 functionCount,   ///< Number of function names.
+      _In_ UINT32 threadCount,     ///< Number of threads printing functions.
+      _In_ IStream *pSink          ///< Stream receiving the disassembly text.
+      ) = 0;
+};
+
 static const UINT32 DxcValidatorFlags_Default = 0;
 static const UINT32 DxcValidatorFlags_InPlaceEdit =
     1; // Validator is allowed to update shader blob in-place.
@@ -10,12 +10,16 @@
 #ifndef LLVM_ANALYSIS_DXILVALUECACHE_H
 #define LLVM_ANALYSIS_DXILVALUECACHE_H
 
-#include "llvm/IR/ValueMap.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/ValueHandle.h"
 #include "llvm/Pass.h"
 
 namespace llvm {
 
 class Module;
+class BasicBlock;
 class DominatorTree;
 class Constant;
 class ConstantInt;
@@ -25,31 +29,49 @@ struct DxilValueCache : public ImmutablePass {
   static char ID;
 
   // Special Weak Value to Weak Value map.
+  //
+  // Entries are dropped when their key is deleted or replaced. Each entry
+  // also records which other entries were computed from it, so that a change
+  // to one value only forgets the unknown results that depended on it.
+  // Constant results are never invalidated, since edits preserve semantics.
   struct WeakValueMap {
-    struct ValueVH : public CallbackVH {
-      ValueVH(Value *V) : CallbackVH(V) {}
-      void allUsesReplacedWith(Value *) override { setValPtr(nullptr); }
+    struct KeyVH final : public CallbackVH {
+      WeakValueMap *Owner;
+      KeyVH(Value *V, WeakValueMap *Owner) : CallbackVH(V), Owner(Owner) {}
+      void deleted() override;
+      void allUsesReplacedWith(Value *) override;
     };
+    typedef SmallSetVector<const Value *, 4> ValueSet;
     struct ValueEntry {
+      KeyVH Key;
       WeakVH Value;
-      ValueVH Self;
-      ValueEntry() : Value(nullptr), Self(nullptr) {}
-      inline void Set(llvm::Value *Key, llvm::Value *V) {
-        Self = Key;
-        Value = V;
-      }
-      inline bool IsStale() const { return Self == nullptr; }
+      // Keys this entry was computed from. Only kept while the entry is
+      // unknown, since known entries are never invalidated.
+      ValueSet Dependencies;
+      ValueEntry(llvm::Value *K, WeakValueMap *Owner)
+          : Key(K, Owner), Value(nullptr) {}
     };
-    ValueMap<const Value *, ValueEntry> Map;
+    DenseMap<const Value *, ValueEntry> Map;
+    // Keys whose entries were computed from the key of this map. Every value
+    // in here is also a key of Map, whose handle removes it when deleted.
+    DenseMap<const Value *, ValueSet> Dependents;
+
     Value *Get(Value *V);
     void Set(Value *Key, Value *V);
     bool Seen(Value *v);
     void SetSentinel(Value *V);
+    void AddDependency(Value *Key, Value *DependsOn);
+    void Invalidate(const Value *V);
+    void Remove(const Value *V);
     void ResetUnknowns();
     void ResetAll();
     void dump() const;
 
   private:
+    bool IsUnknown(const ValueEntry &Entry) const;
+    void Erase(DenseMap<const Value *, ValueEntry>::iterator It);
+    void ClearDependencies(const Value *Key, ValueEntry &Entry);
+    void InvalidateDependents(const Value *V);
     Value *GetSentinel(LLVMContext &Ctx);
     std::unique_ptr<PHINode> Sentinel;
   };
@@ -81,6 +103,13 @@ public:
   ConstantInt *GetConstInt(Value *V, DominatorTree *DT = nullptr);
   void ResetUnknowns() { Map.ResetUnknowns(); }
   void ResetAll() { Map.ResetAll(); }
+  // Forgets what could not be deduced about V, and about everything computed
+  // from V. Call after editing V in place (e.g. changing its operands), which
+  // unlike deletion or RAUW is not observed by the cache.
+  void Invalidate(Value *V) { Map.Invalidate(V); }
+  // Invalidates BB's reachability, its terminator and its phis, after
+  // editing its predecessors or incoming values.
+  void InvalidateBlock(BasicBlock *BB);
   bool IsUnreachable(BasicBlock *BB, DominatorTree *DT = nullptr);
   void SetShouldSkipCallback(bool (*Callback)(Value *V)) {
     ShouldSkipCallback = Callback;
@@ -33,12 +33,15 @@ namespace llvm {
   /// deserialization of function bodies. If ShouldLazyLoadMetadata is true,
   /// lazily load metadata as well. If successful, this moves Buffer. On
   /// error, this *does not* move Buffer.
+  /// HLSL Change: If ShouldSkipDebugInfo is true, debug info metadata, debug
+  /// locations and llvm.dbg.* calls are skipped rather than loaded.
   ErrorOr<std::unique_ptr<Module>>
   getLazyBitcodeModule(std::unique_ptr<MemoryBuffer> &&Buffer,
                        LLVMContext &Context,
                        DiagnosticHandlerFunction DiagnosticHandler = nullptr,
                        bool ShouldLazyLoadMetadata = false,
-                       bool ShouldTrackBitstreamUsage = false);
+                       bool ShouldTrackBitstreamUsage = false,
+                       bool ShouldSkipDebugInfo = false); // HLSL Change
 
   /// Read the header of the specified stream and prepare for lazy
   /// deserialization and streaming of function bodies.
@@ -58,7 +61,8 @@ namespace llvm {
   ErrorOr<std::unique_ptr<Module>>
   parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
                    DiagnosticHandlerFunction DiagnosticHandler = nullptr,
-                   bool ShouldTrackBitstreamUsage = false); // HLSL Change
+                   bool ShouldTrackBitstreamUsage = false, // HLSL Change
+                   bool ShouldSkipDebugInfo = false); // HLSL Change
 
   /// \brief Write the specified module to the specified raw output stream.
   ///
@@ -175,6 +175,25 @@ public:
   void emitError(const Twine &ErrorStr);
   void emitWarning(const Twine &WarningStr); // HLSL Change
 
+  // HLSL Change - Begin
+  /// \brief Prepares the context to be used for another, unrelated module.
+  ///
+  /// Named struct types lose their names, custom metadata kinds are dropped
+  /// and all handlers and callbacks are cleared, so that a module built next
+  /// is identical to one built in a freshly constructed context. Uniqued types
+  /// and constants are retained. Returns false, leaving the context untouched,
+  /// if any module is still owned by the context; such a context must not be
+  /// reused.
+  bool resetForReuse();
+
+  /// \brief Drops the metadata kinds registered after the first \p NumKinds.
+  ///
+  /// Every registered kind is written to bitcode, so a client that builds
+  /// several modules in one context uses this to keep the kinds one module
+  /// registered out of the next. No metadata attachment may use a dropped kind.
+  void dropMDKindsFrom(unsigned NumKinds);
+  // HLSL Change - End
+
   /// \brief Query for a debug option's value.
   ///
   /// This function returns typed data populated from command line parsing.
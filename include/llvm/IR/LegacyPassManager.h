@@ -19,7 +19,11 @@
 
 #include "llvm/Pass.h"
 #include "llvm/Support/CBindingWrapping.h"
+#include "llvm/ADT/DenseMap.h" // HLSL change
+#include "llvm/Support/Timer.h" // HLSL change
+#include <memory> // HLSL change
 #include <set> // HLSL change
+#include <vector> // HLSL change
 
 namespace llvm {
 
@@ -31,6 +35,31 @@ namespace legacy {
 class PassManagerImpl;
 class FunctionPassManagerImpl;
 
+// HLSL Change Starts
+/// PassTimes - Records the time spent in each pass run by the pass managers it
+/// is attached to through PassManagerBase::HLSLPassTimes. Unlike -time-passes,
+/// the timers belong to those pass managers only, so pipelines running on
+/// different threads can each be timed. Timers are never printed.
+class PassTimes {
+public:
+  PassTimes();
+  ~PassTimes();
+
+  /// Returns the timer for pass P, creating it the first time P runs.
+  Timer *getPassTimer(Pass *P);
+
+  /// Returns a timer for each pass that ran, in the order they first ran. Each
+  /// timer is named after the command-line argument of its pass, if any.
+  const std::vector<std::unique_ptr<Timer>> &getTimers() const {
+    return Timers;
+  }
+
+private:
+  DenseMap<Pass *, Timer *> PassTimers;
+  std::vector<std::unique_ptr<Timer>> Timers;
+};
+// HLSL Change Ends
+
 /// PassManagerBase - An abstract interface to allow code to add passes to
 /// a pass manager without having to hard-code what kind of pass manager
 /// it is.
@@ -40,6 +69,7 @@ public:
   std::set<std::string> HLSLPrintBefore; // HLSL Change
   bool HLSLPrintAfterAll = false; // HLSL Change
   std::set<std::string> HLSLPrintAfter; // HLSL Change
+  PassTimes *HLSLPassTimes = nullptr; // HLSL Change
 
   virtual ~PassManagerBase();
 
@@ -99,6 +99,9 @@ namespace llvm {
   class Value;
   class Timer;
   class PMDataManager;
+  namespace legacy {
+  class PassTimes; // HLSL Change
+  }
 
 // enums for debugging strings
 enum PassDebuggingString {
@@ -184,6 +187,7 @@ public:
   std::set<std::string> HLSLPrintBefore; // HLSL Change
   bool HLSLPrintAfterAll = false; // HLSL Change
   std::set<std::string> HLSLPrintAfter; // HLSL Change
+  legacy::PassTimes *HLSLPassTimes = nullptr; // HLSL Change
 
   /// Schedule pass P for execution. Make sure that passes required by
   /// P are run before P is run. Update analysis info maintained by
@@ -17,6 +17,8 @@ namespace llvm {
 class Module;
 class Function;
 class SlotTracker;
+class AssemblyAnnotationWriter; // HLSL Change
+class raw_ostream;              // HLSL Change
 
 /// Manage lifetime of a slot tracker for printing IR.
 ///
@@ -63,6 +65,31 @@ public:
   void incorporateFunction(const Function &F);
 };
 
+// HLSL Change Begin - print large modules in pieces.
+/// Print a module in the same form as \a Module::print, one piece at a time:
+/// the header (target, types, globals), then any of the functions, then the
+/// trailer (attribute groups and metadata).
+///
+/// All slots of the module, including the metadata and attributes referenced
+/// from function bodies, are numbered up front, so a function prints exactly
+/// as it does in the full listing whichever other functions are printed.
+/// \a printFunction only reads the module and may be called concurrently for
+/// different functions, as long as the annotation writer is thread-safe and
+/// the module is not modified while printing.
+class StreamingModulePrinter {
+  struct Impl;
+  std::unique_ptr<Impl> PImpl;
+
+public:
+  StreamingModulePrinter(const Module &M, AssemblyAnnotationWriter *AAW);
+  ~StreamingModulePrinter();
+
+  void printHeader(raw_ostream &OS);
+  void printFunction(const Function &F, raw_ostream &OS) const;
+  void printTrailer(raw_ostream &OS);
+};
+// HLSL Change End
+
 } // end namespace llvm
 
 #endif
@@ -113,6 +113,9 @@ public:
   ///
   void stopTimer();
 
+  /// Return the time accumulated between startTimer/stopTimer calls.
+  TimeRecord getTotalTime() const { return Time; } // HLSL Change
+
 private:
   friend class TimerGroup;
 };
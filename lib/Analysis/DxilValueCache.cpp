@@ -349,15 +349,27 @@ Value *DxilValueCache::SimplifyAndCacheResult(Instruction *I,
   return Simplified;
 }
 
+void DxilValueCache::WeakValueMap::KeyVH::deleted() {
+  // Removing the entry destroys this handle, so don't touch it afterwards.
+  WeakValueMap *M = Owner;
+  M->Remove(getValPtr());
+}
+
+void DxilValueCache::WeakValueMap::KeyVH::allUsesReplacedWith(Value *) {
+  WeakValueMap *M = Owner;
+  M->Remove(getValPtr());
+}
+
+bool DxilValueCache::WeakValueMap::IsUnknown(const ValueEntry &Entry) const {
+  const Value *V = Entry.Value;
+  return !V || V == Sentinel.get();
+}
+
 bool DxilValueCache::WeakValueMap::Seen(Value *V) {
   auto FindIt = Map.find(V);
   if (FindIt == Map.end())
     return false;
-
-  auto &Entry = FindIt->second;
-  if (Entry.IsStale())
-    return false;
-  return Entry.Value;
+  return FindIt->second.Value;
 }
 
 Value *DxilValueCache::WeakValueMap::Get(Value *V) {
@@ -365,11 +377,7 @@ Value *DxilValueCache::WeakValueMap::Get(Value *V) {
   if (FindIt == Map.end())
     return nullptr;
 
-  auto &Entry = FindIt->second;
-  if (Entry.IsStale())
-    return nullptr;
-
-  Value *Result = Entry.Value;
+  Value *Result = FindIt->second.Value;
   if (Result == GetSentinel(V->getContext()))
     return nullptr;
 
@@ -377,7 +385,78 @@ Value *DxilValueCache::WeakValueMap::Get(Value *V) {
 }
 
 void DxilValueCache::WeakValueMap::SetSentinel(Value *Key) {
-  Map[Key].Set(Key, GetSentinel(Key->getContext()));
+  Set(Key, GetSentinel(Key->getContext()));
+}
+
+// Records that the entry of Key was computed from DependsOn.
+void DxilValueCache::WeakValueMap::AddDependency(Value *Key,
+                                                 Value *DependsOn) {
+  // Give DependsOn an empty entry, which reads as not seen, so that its
+  // handle unlinks the edge when it is deleted.
+  if (!Map.count(DependsOn))
+    Map.insert(std::make_pair(DependsOn, ValueEntry(DependsOn, this)));
+  auto KeyIt = Map.find(Key);
+  if (KeyIt == Map.end() || !IsUnknown(KeyIt->second))
+    return;
+  if (KeyIt->second.Dependencies.insert(DependsOn))
+    Dependents[DependsOn].insert(Key);
+}
+
+void DxilValueCache::WeakValueMap::ClearDependencies(const Value *Key,
+                                                     ValueEntry &Entry) {
+  for (const Value *DependsOn : Entry.Dependencies) {
+    auto DepIt = Dependents.find(DependsOn);
+    if (DepIt == Dependents.end())
+      continue;
+    DepIt->second.remove(Key);
+    if (DepIt->second.empty())
+      Dependents.erase(DepIt);
+  }
+  Entry.Dependencies.clear();
+}
+
+void DxilValueCache::WeakValueMap::Erase(
+    DenseMap<const Value *, ValueEntry>::iterator It) {
+  ClearDependencies(It->first, It->second);
+  Map.erase(It);
+}
+
+void DxilValueCache::WeakValueMap::InvalidateDependents(const Value *V) {
+  SmallVector<const Value *, 16> WorkList;
+  WorkList.push_back(V);
+  while (!WorkList.empty()) {
+    auto DepIt = Dependents.find(WorkList.pop_back_val());
+    if (DepIt == Dependents.end())
+      continue;
+    // Only unknown entries have dependencies recorded, and each one is
+    // erased below, so the list has nothing left to invalidate afterwards.
+    ValueSet Deps = std::move(DepIt->second);
+    Dependents.erase(DepIt);
+    for (const Value *Dep : Deps) {
+      auto FindIt = Map.find(Dep);
+      if (FindIt == Map.end())
+        continue;
+      Erase(FindIt);
+      WorkList.push_back(Dep);
+    }
+  }
+}
+
+void DxilValueCache::WeakValueMap::Invalidate(const Value *V) {
+  auto FindIt = Map.find(V);
+  if (FindIt != Map.end()) {
+    if (!IsUnknown(FindIt->second))
+      return;
+    Erase(FindIt);
+  }
+  InvalidateDependents(V);
+}
+
+void DxilValueCache::WeakValueMap::Remove(const Value *V) {
+  auto FindIt = Map.find(V);
+  if (FindIt != Map.end())
+    Erase(FindIt);
+  InvalidateDependents(V);
 }
 
 Value *DxilValueCache::WeakValueMap::GetSentinel(LLVMContext &Ctx) {
@@ -387,18 +466,20 @@ Value *DxilValueCache::WeakValueMap::GetSentinel(LLVMContext &Ctx) {
   return Sentinel.get();
 }
 
-void DxilValueCache::WeakValueMap::ResetAll() { Map.clear(); }
+void DxilValueCache::WeakValueMap::ResetAll() {
+  Map.clear();
+  Dependents.clear();
+}
 
 void DxilValueCache::WeakValueMap::ResetUnknowns() {
-  if (!Sentinel)
-    return;
-
   for (auto it = Map.begin(); it != Map.end();) {
     auto nextIt = std::next(it);
-    if (it->second.Value == Sentinel.get())
+    if (IsUnknown(it->second))
       Map.erase(it);
     it = nextIt;
   }
+  // Only unknown entries have dependencies, and none are left.
+  Dependents.clear();
 }
 
 LLVM_DUMP_METHOD
@@ -407,9 +488,6 @@ void DxilValueCache::WeakValueMap::dump() const {
   for (auto It = Map.begin(), E = Map.end(); It != E; It++) {
     const Value *Key = It->first;
 
-    if (It->second.IsStale())
-      continue;
-
     if (!Key)
       continue;
 
@@ -458,7 +536,13 @@ void DxilValueCache::WeakValueMap::dump() const {
 }
 
 void DxilValueCache::WeakValueMap::Set(Value *Key, Value *V) {
-  Map[Key].Set(Key, V);
+  auto FindIt = Map.find(Key);
+  if (FindIt == Map.end())
+    FindIt = Map.insert(std::make_pair(Key, ValueEntry(Key, this))).first;
+  FindIt->second.Value = V;
+  // Known results are never invalidated, so their edges are dead weight.
+  if (!IsUnknown(FindIt->second))
+    ClearDependencies(Key, FindIt->second);
 }
 
 // If there's a cached value, return it. Otherwise, return
@@ -496,6 +580,17 @@ ConstantInt *DxilValueCache::GetConstInt(Value *V, DominatorTree *DT) {
   return nullptr;
 }
 
+void DxilValueCache::InvalidateBlock(BasicBlock *BB) {
+  Map.Invalidate(BB);
+  if (TerminatorInst *Term = BB->getTerminator())
+    Map.Invalidate(Term);
+  for (Instruction &I : *BB) {
+    if (!isa<PHINode>(&I))
+      break;
+    Map.Invalidate(&I);
+  }
+}
+
 bool DxilValueCache::IsUnreachable(BasicBlock *BB, DominatorTree *DT) {
   ProcessValue(BB, DT);
   return IsUnreachable_(BB);
@@ -545,6 +640,7 @@ Value *DxilValueCache::ProcessValue(Value *NewV, DominatorTree *DT) {
           Instruction *UseI = dyn_cast<Instruction>(U.get());
           if (!UseI)
             continue;
+          Map.AddDependency(I, UseI);
           if (!Map.Seen(UseI))
             WorkList.push_back(UseI);
         }
@@ -553,6 +649,8 @@ Value *DxilValueCache::ProcessValue(Value *NewV, DominatorTree *DT) {
           for (unsigned i = 0; i < PN->getNumIncomingValues(); i++) {
             BasicBlock *BB = PN->getIncomingBlock(i);
             TerminatorInst *Term = BB->getTerminator();
+            Map.AddDependency(I, Term);
+            Map.AddDependency(I, BB);
             if (!Map.Seen(Term))
               WorkList.push_back(Term);
             if (!Map.Seen(BB))
@@ -564,6 +662,8 @@ Value *DxilValueCache::ProcessValue(Value *NewV, DominatorTree *DT) {
              PI++) {
           BasicBlock *PredBB = *PI;
           TerminatorInst *Term = PredBB->getTerminator();
+          Map.AddDependency(BB, Term);
+          Map.AddDependency(BB, PredBB);
           if (!Map.Seen(Term))
             WorkList.push_back(Term);
           if (!Map.Seen(PredBB))
@@ -239,6 +239,9 @@ public:
 
   bool ShouldTrackBitstreamUsage = false; // HLSL Change
   BitstreamUseTracker Tracker; // HLSL Change
+  // HLSL Change - Skip debug info metadata, debug locations and calls to
+  // llvm.dbg.* intrinsics instead of materializing them.
+  bool ShouldSkipDebugInfo = false;
 
   bool isDematerializable(const GlobalValue *GV) const override;
   std::error_code materialize(GlobalValue *GV) override;
@@ -1643,6 +1646,52 @@ std::error_code BitcodeReader::parseValueSymbolTable() {
 static int64_t unrotateSign(uint64_t U) { return U & 1 ? ~(U >> 1) : U >> 1; }
 
 // HLSL Change - Begin
+// Returns true for the metadata records that describe debug info nodes. When
+// debug info is skipped, these records are not decoded at all.
+static bool isDebugInfoMetadataRecord(unsigned Code) {
+  switch (Code) {
+  case bitc::METADATA_LOCATION:
+  case bitc::METADATA_GENERIC_DEBUG:
+  case bitc::METADATA_SUBRANGE:
+  case bitc::METADATA_ENUMERATOR:
+  case bitc::METADATA_BASIC_TYPE:
+  case bitc::METADATA_DERIVED_TYPE:
+  case bitc::METADATA_COMPOSITE_TYPE:
+  case bitc::METADATA_SUBROUTINE_TYPE:
+  case bitc::METADATA_MODULE:
+  case bitc::METADATA_FILE:
+  case bitc::METADATA_COMPILE_UNIT:
+  case bitc::METADATA_SUBPROGRAM:
+  case bitc::METADATA_LEXICAL_BLOCK:
+  case bitc::METADATA_LEXICAL_BLOCK_FILE:
+  case bitc::METADATA_NAMESPACE:
+  case bitc::METADATA_TEMPLATE_TYPE:
+  case bitc::METADATA_TEMPLATE_VALUE:
+  case bitc::METADATA_GLOBAL_VAR:
+  case bitc::METADATA_LOCAL_VAR:
+  case bitc::METADATA_EXPRESSION:
+  case bitc::METADATA_OBJC_PROPERTY:
+  case bitc::METADATA_IMPORTED_ENTITY:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Creates the MDString for the characters of a METADATA_STRING record. Only
+// strings that llvm::UpgradeMDStringConstant would rewrite are copied into
+// Buffer; all others are uniqued straight from the record.
+static MDString *getUpgradedMDString(LLVMContext &Context,
+                                     ArrayRef<uint8_t> Chars,
+                                     std::string &Buffer) {
+  StringRef Str(reinterpret_cast<const char *>(Chars.data()), Chars.size());
+  if (!Str.startswith("llvm.vectorizer."))
+    return MDString::get(Context, Str);
+  Buffer.assign(Str.begin(), Str.end());
+  llvm::UpgradeMDStringConstant(Buffer);
+  return MDString::get(Context, Buffer);
+}
+
 // This function takes a list of strings that corresponds to the list of named
 // metadata that we want to materialize, and materialize them efficiently.
 //
@@ -1779,6 +1828,10 @@ std::error_code BitcodeReader::parseSelectNamedMetadata(ArrayRef<StringRef> Name
       if (NextBitCode != bitc::METADATA_NAMED_NODE)
         return error("METADATA_NAME not followed by METADATA_NAMED_NODE");
 
+      // HLSL Change - Drop llvm.dbg.cu and the like with their DI nodes.
+      if (ShouldSkipDebugInfo && Name.startswith("llvm.dbg."))
+        break;
+
       // Read named metadata elements.
       unsigned Size = Record.size();
       NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
@@ -1887,11 +1940,7 @@ std::error_code BitcodeReader::parseSelectNamedMetadata(ArrayRef<StringRef> Name
       break;
     }
     case bitc::METADATA_STRING: {
-      String.clear();
-      String.resize(Uint8Record.size());
-      memcpy(&String[0], Uint8Record.data(), Uint8Record.size());
-      llvm::UpgradeMDStringConstant(String);
-      Metadata *MD = MDString::get(Context, String);
+      Metadata *MD = getUpgradedMDString(Context, Uint8Record, String);
       MDValueList.assignValue(MD, MDNumber);
       break;
     }
@@ -1923,6 +1972,8 @@ std::error_code BitcodeReader::parseMetadata() {
 
   SmallVector<uint64_t, 64> Record;
   SmallVector<uint8_t, 64> Uint8Record; // HLSL Change
+  std::string String; // HLSL Change - Reuse buffer for upgraded strings.
+  MDNode *SkippedDebugInfo = nullptr; // HLSL Change - Stands in for DI nodes.
 
   auto getMD =
       [&](unsigned ID) -> Metadata *{ return MDValueList.getValueFwdRef(ID); };
@@ -1965,8 +2016,24 @@ std::error_code BitcodeReader::parseMetadata() {
     // up reading.
     unsigned PeekCode = Stream.peekRecord(Entry.ID);
     unsigned Code = 0;
+    // When skipping debug info, DI nodes keep their metadata IDs but all
+    // resolve to one empty node, so nothing that refers to them dangles.
+    // Skipped records are still read when tracking bitstream usage, so the
+    // tracker sees every bit.
+    if (ShouldSkipDebugInfo && isDebugInfoMetadataRecord(PeekCode)) {
+      if (ShouldTrackBitstreamUsage) {
+        Record.clear();
+        Stream.readRecord(Entry.ID, Record);
+      } else {
+        Stream.skipRecord(Entry.ID);
+      }
+      if (!SkippedDebugInfo)
+        SkippedDebugInfo = MDNode::get(Context, None);
+      MDValueList.assignValue(SkippedDebugInfo, NextMDValueNo++);
+      continue;
+    }
     Record.clear();
-    if (PeekCode == bitc::METADATA_STRING) {
+    if (PeekCode == bitc::METADATA_STRING || PeekCode == bitc::METADATA_NAME) {
       Uint8Record.clear();
       Code = Stream.readRecord(Entry.ID, Record, nullptr, &Uint8Record);
       assert(!Uint8Record.empty() || (Record.empty() && Uint8Record.empty()));
@@ -1980,14 +2047,16 @@ std::error_code BitcodeReader::parseMetadata() {
     unsigned Code = Stream.readRecord(Entry.ID, Record);
 #endif // HLSL Change
 
-    std::string String; // HLSL Change - Reuse buffer for loading string.
     bool IsDistinct = false;
     switch (Code) {
     default:  // Default behavior: ignore.
       break;
     case bitc::METADATA_NAME: {
       // Read name of the named metadata.
-      SmallString<8> Name(Record.begin(), Record.end());
+      // HLSL Change - The name was read into Uint8Record, which stays intact
+      // while the following METADATA_NAMED_NODE is read into Record.
+      StringRef Name(reinterpret_cast<const char *>(Uint8Record.data()),
+                     Uint8Record.size());
       Record.clear();
       Code = Stream.ReadCode();
 
@@ -1995,6 +2064,10 @@ std::error_code BitcodeReader::parseMetadata() {
       if (NextBitCode != bitc::METADATA_NAMED_NODE)
         return error("METADATA_NAME not followed by METADATA_NAMED_NODE");
 
+      // HLSL Change - Drop llvm.dbg.cu and the like with their DI nodes.
+      if (ShouldSkipDebugInfo && Name.startswith("llvm.dbg."))
+        break;
+
       // Read named metadata elements.
       unsigned Size = Record.size();
       NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
@@ -2367,14 +2440,13 @@ std::error_code BitcodeReader::parseMetadata() {
       break;
     }
     case bitc::METADATA_STRING: {
-#if 0
+#if 0 // HLSL Change
       std::string String(Record.begin(), Record.end());
-#else
-      String.resize(Uint8Record.size());
-      memcpy(&String[0], Uint8Record.data(), Uint8Record.size());
-#endif
       llvm::UpgradeMDStringConstant(String);
       Metadata *MD = MDString::get(Context, String);
+#else // HLSL Change
+      Metadata *MD = getUpgradedMDString(Context, Uint8Record, String);
+#endif // HLSL Change
       MDValueList.assignValue(MD, NextMDValueNo++);
       break;
     }
@@ -3662,6 +3734,8 @@ std::error_code BitcodeReader::parseMetadataAttachment(Function &F) {
 
       // An instruction attachment.
       Instruction *Inst = InstructionList[Record[0]];
+      if (!Inst) // HLSL Change - Skipped debug intrinsic call.
+        continue;
       for (unsigned i = 1; i != RecordLength; i = i+2) {
         unsigned Kind = Record[i];
         DenseMap<unsigned, unsigned>::iterator I =
@@ -3814,6 +3888,8 @@ std::error_code BitcodeReader::parseFunctionBody(Function *F) {
     }
 
     case bitc::FUNC_CODE_DEBUG_LOC_AGAIN:  // DEBUG_LOC_AGAIN
+      if (ShouldSkipDebugInfo) // HLSL Change
+        continue;
       // This record indicates that the last instruction is at the same
       // location as the previous instruction with a location.
       I = getLastInstruction();
@@ -3825,6 +3901,8 @@ std::error_code BitcodeReader::parseFunctionBody(Function *F) {
       continue;
 
     case bitc::FUNC_CODE_DEBUG_LOC: {      // DEBUG_LOC: [line, col, scope, ia]
+      if (ShouldSkipDebugInfo) // HLSL Change
+        continue;
       I = getLastInstruction();
       if (!I || Record.size() < 4)
         return error("Invalid record");
@@ -4697,6 +4775,16 @@ std::error_code BitcodeReader::parseFunctionBody(Function *F) {
       if (getValueTypePair(Record, OpNum, NextValueNo, Callee))
         return error("Invalid record");
 
+      // HLSL Change Begin - Drop llvm.dbg.* calls when skipping debug info.
+      // They produce no value; the null entry keeps instruction IDs intact
+      // for metadata attachments.
+      if (ShouldSkipDebugInfo && isa<Function>(Callee) &&
+          Callee->getName().startswith("llvm.dbg.")) {
+        InstructionList.push_back(nullptr);
+        continue;
+      }
+      // HLSL Change End
+
       PointerType *OpTy = dyn_cast<PointerType>(Callee->getType());
       if (!OpTy)
         return error("Callee is not a pointer type");
@@ -5080,7 +5168,8 @@ getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
                          LLVMContext &Context, bool MaterializeAll,
                          DiagnosticHandlerFunction DiagnosticHandler,
                          bool ShouldLazyLoadMetadata = false,
-                         bool ShouldTrackBitstreamUsage = false) // HLSL Change
+                         bool ShouldTrackBitstreamUsage = false, // HLSL Change
+                         bool ShouldSkipDebugInfo = false) // HLSL Change
 {
   // HLSL Change Begin: Proper memory management with unique_ptr
   // Get the buffer identifier before we transfer the ownership to the bitcode reader,
@@ -5090,6 +5179,7 @@ getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
     std::move(Buffer), Context, DiagnosticHandler);
 
   if (R) R->ShouldTrackBitstreamUsage = ShouldTrackBitstreamUsage; // HLSL Change
+  if (R) R->ShouldSkipDebugInfo = ShouldSkipDebugInfo; // HLSL Change
   ErrorOr<std::unique_ptr<Module>> Ret =
       getBitcodeModuleImpl(nullptr, BufferIdentifier, std::move(R), Context,
                            MaterializeAll, ShouldLazyLoadMetadata);
@@ -5103,10 +5193,11 @@ getLazyBitcodeModuleImpl(std::unique_ptr<MemoryBuffer> &&Buffer,
 ErrorOr<std::unique_ptr<Module>> llvm::getLazyBitcodeModule(
     std::unique_ptr<MemoryBuffer> &&Buffer, LLVMContext &Context,
     DiagnosticHandlerFunction DiagnosticHandler, bool ShouldLazyLoadMetadata,
-    bool ShouldTrackBitstreamUsage) {
+    bool ShouldTrackBitstreamUsage, bool ShouldSkipDebugInfo) {
   return getLazyBitcodeModuleImpl(std::move(Buffer), Context, false,
                                   DiagnosticHandler, ShouldLazyLoadMetadata,
-                                  ShouldTrackBitstreamUsage); // HLSL Change
+                                  ShouldTrackBitstreamUsage, // HLSL Change
+                                  ShouldSkipDebugInfo); // HLSL Change
 }
 
 ErrorOr<std::unique_ptr<Module>> llvm::getStreamedBitcodeModule(
@@ -5138,7 +5229,8 @@ void report_fatal_error_handler(void *user_datam, const std::string &reason,
 ErrorOr<std::unique_ptr<Module>>
 llvm::parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
                        DiagnosticHandlerFunction DiagnosticHandler,
-                       bool ShouldTrackBitstreamUsage) // HLSL Change
+                       bool ShouldTrackBitstreamUsage, // HLSL Change
+                       bool ShouldSkipDebugInfo) // HLSL Change
 {
   // HLSL Change Starts - introduce a ScopedFatalErrorHandler to handle
   // report_fatal_error from readers.
@@ -5148,7 +5240,8 @@ llvm::parseBitcodeFile(MemoryBufferRef Buffer, LLVMContext &Context,
   std::unique_ptr<MemoryBuffer> Buf = MemoryBuffer::getMemBuffer(Buffer, false);
   return getLazyBitcodeModuleImpl(std::move(Buf), Context, true,
                                   DiagnosticHandler,
-                                  false, ShouldTrackBitstreamUsage); // HLSL Change
+                                  false, ShouldTrackBitstreamUsage, // HLSL Change
+                                  ShouldSkipDebugInfo); // HLSL Change
   // TODO: Restore the use-lists to the in-memory state when the bitcode was
   // written.  We must defer until the Module has been fully materialized.
 }
@@ -1245,20 +1245,22 @@ static void WriteModuleMetadata(const Module *M,
     }
     const MDString *MDS = cast<MDString>(MD);
     // Code: [strchar x N]
-    Record.append(MDS->bytes_begin(), MDS->bytes_end());
-
-    // Emit the finished record.
-    Stream.EmitRecord(bitc::METADATA_STRING, Record, MDSAbbrev);
+    // HLSL Change Begin - Emit the characters straight from the string
+    // instead of widening each one into the record first.
+    Record.push_back(bitc::METADATA_STRING);
+    Stream.EmitRecordWithArray(MDSAbbrev, Record, MDS->getString());
     Record.clear();
+    // HLSL Change End
   }
 
   // Write named metadata.
   for (const NamedMDNode &NMD : M->named_metadata()) {
     // Write name.
-    StringRef Str = NMD.getName();
-    Record.append(Str.bytes_begin(), Str.bytes_end());
-    Stream.EmitRecord(bitc::METADATA_NAME, Record, NameAbbrev);
+    // HLSL Change Begin - Emit the name without widening it into the record.
+    Record.push_back(bitc::METADATA_NAME);
+    Stream.EmitRecordWithArray(NameAbbrev, Record, NMD.getName());
     Record.clear();
+    // HLSL Change End
 
     // Write named metadata operands.
     for (const MDNode *N : NMD.operands())
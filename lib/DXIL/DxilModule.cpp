@@ -283,6 +283,26 @@ bool DxilModule::IsEntryOrPatchConstantFunction(
   return pFunc == GetEntryFunction() || pFunc == GetPatchConstantFunction();
 }
 
+bool DxilModule::HasUnmaterializedFunctions() const {
+  for (const Function &F : m_pModule->functions()) {
+    if (F.isMaterializable())
+      return true;
+  }
+  return false;
+}
+
+void DxilModule::MaterializeFunction(llvm::Function *F) {
+  if (!F->isMaterializable())
+    return;
+  IFTBOOL(!m_pModule->materialize(F), DXC_E_IR_VERIFICATION_FAILED);
+}
+
+void DxilModule::MaterializeAllFunctions() {
+  if (!HasUnmaterializedFunctions())
+    return;
+  IFTBOOL(!m_pModule->materializeAll(), DXC_E_IR_VERIFICATION_FAILED);
+}
+
 unsigned DxilModule::GetGlobalFlags() const {
   unsigned Flags = m_ShaderFlags.GetGlobalFlags();
   return Flags;
@@ -3435,10 +3435,10 @@ Function *OP::GetOpFunc(OpCode opCode, Type *pOverloadType) {
   OpCodeClass opClass = m_OpCodeProps[(unsigned)opCode].opCodeClass;
   Function *&F =
       m_OpCodeClassCache[(unsigned)opClass].pOverloads[pOverloadType];
-  if (F != nullptr) {
-    UpdateCache(opClass, pOverloadType, F);
+  // Both caches are filled together by UpdateCache, so a hit needs no update.
+  // Lowering calls this once per generated instruction.
+  if (F != nullptr)
     return F;
-  }
 
   vector<Type *> ArgTypes; // RetType is ArgTypes[0]
   Type *pETy = pOverloadType;
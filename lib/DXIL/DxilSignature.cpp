@@ -12,6 +12,8 @@
 #include "dxc/Support/Global.h"
 #include "llvm/ADT/STLExtras.h"
 
+#include <climits>
+
 using std::unique_ptr;
 using std::vector;
 
@@ -128,6 +130,22 @@ unsigned DxilSignature::GetRowCount() const {
   return maxRow;
 }
 
+vector<unsigned> DxilSignature::RemoveElements(const vector<bool> &Remove) {
+  DXASSERT_NOMSG(Remove.size() == m_Elements.size());
+  vector<unsigned> NewIDs(m_Elements.size(), UINT_MAX);
+  unsigned NumKept = 0;
+  for (unsigned i = 0; i < m_Elements.size(); ++i) {
+    if (Remove[i])
+      continue;
+    NewIDs[i] = NumKept;
+    // SetID only assigns an ID once; renumbering is done here directly.
+    m_Elements[i]->m_ID = NumKept;
+    m_Elements[NumKept++] = std::move(m_Elements[i]);
+  }
+  m_Elements.resize(NumKept);
+  return NewIDs;
+}
+
 //------------------------------------------------------------------------------
 //
 // EntrySingnature methods.
@@ -210,9 +210,13 @@ bool MergeGepUse(Value *V) {
 
 std::unique_ptr<llvm::Module> LoadModuleFromBitcode(llvm::MemoryBuffer *MB,
                                                     llvm::LLVMContext &Ctx,
-                                                    std::string &DiagStr) {
+                                                    std::string &DiagStr,
+                                                    bool bSkipDebugInfo) {
   // Note: the DiagStr is not used.
-  auto pModule = llvm::parseBitcodeFile(MB->getMemBufferRef(), Ctx);
+  auto pModule =
+      llvm::parseBitcodeFile(MB->getMemBufferRef(), Ctx, nullptr,
+                             /*ShouldTrackBitstreamUsage*/ false,
+                             bSkipDebugInfo);
   if (!pModule) {
     return nullptr;
   }
@@ -221,21 +225,39 @@ std::unique_ptr<llvm::Module> LoadModuleFromBitcode(llvm::MemoryBuffer *MB,
 
 std::unique_ptr<llvm::Module>
 LoadModuleFromBitcodeLazy(std::unique_ptr<llvm::MemoryBuffer> &&MB,
-                          llvm::LLVMContext &Ctx, std::string &DiagStr) {
+                          llvm::LLVMContext &Ctx, std::string &DiagStr,
+                          bool bSkipDebugInfo) {
   // Note: the DiagStr is not used.
-  auto pModule = llvm::getLazyBitcodeModule(std::move(MB), Ctx, nullptr, true);
+  auto pModule = llvm::getLazyBitcodeModule(
+      std::move(MB), Ctx, nullptr, true,
+      /*ShouldTrackBitstreamUsage*/ false, bSkipDebugInfo);
   if (!pModule) {
     return nullptr;
   }
   return std::unique_ptr<llvm::Module>(pModule.get().release());
 }
 
+std::unique_ptr<llvm::Module>
+LoadModuleFromBitcodeLazy(llvm::StringRef BC, llvm::LLVMContext &Ctx,
+                          std::string &DiagStr, bool bSkipDebugInfo) {
+  // NOTE: this doesn't copy the memory, just references it.
+  std::unique_ptr<llvm::MemoryBuffer> pBitcodeBuf(
+      llvm::MemoryBuffer::getMemBuffer(BC, "", false));
+  std::unique_ptr<llvm::Module> pModule = LoadModuleFromBitcodeLazy(
+      std::move(pBitcodeBuf), Ctx, DiagStr, bSkipDebugInfo);
+  if (!pModule || pModule->materializeMetadata())
+    return nullptr;
+  return pModule;
+}
+
 std::unique_ptr<llvm::Module> LoadModuleFromBitcode(llvm::StringRef BC,
                                                     llvm::LLVMContext &Ctx,
-                                                    std::string &DiagStr) {
+                                                    std::string &DiagStr,
+                                                    bool bSkipDebugInfo) {
   std::unique_ptr<llvm::MemoryBuffer> pBitcodeBuf(
       llvm::MemoryBuffer::getMemBuffer(BC, "", false));
-  return LoadModuleFromBitcode(pBitcodeBuf.get(), Ctx, DiagStr);
+  return LoadModuleFromBitcode(pBitcodeBuf.get(), Ctx, DiagStr,
+                               bSkipDebugInfo);
 }
 
 DIGlobalVariable *FindGlobalVariableDebugInfo(GlobalVariable *GV,
@@ -759,7 +759,32 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.DefaultRowMajor = Args.hasFlag(OPT_Zpr, OPT_INVALID, false);
   opts.DefaultColMajor = Args.hasFlag(OPT_Zpc, OPT_INVALID, false);
   opts.DumpBin = Args.hasFlag(OPT_dumpbin, OPT_INVALID, false);
+  opts.DisasmFunctions = Args.getAllArgValues(OPT_disasm_function);
+  if (!Args.getLastArgValue(OPT_disasm_threads).empty() &&
+      Args.getLastArgValue(OPT_disasm_threads)
+          .getAsInteger(10, opts.DisasmThreads)) {
+    errors << "/disasm-threads requires a number of threads.";
+    return 1;
+  }
   opts.Link = Args.hasFlag(OPT_link, OPT_INVALID, false);
+  opts.BatchFile = Args.getLastArgValue(OPT_batch);
+  opts.PipelineFile = Args.getLastArgValue(OPT_pipeline);
+  if (!opts.BatchFile.empty() && !opts.PipelineFile.empty()) {
+    errors << "Cannot specify /batch and /pipeline together.";
+    return 1;
+  }
+  opts.Server = Args.hasFlag(OPT_server, OPT_INVALID, false);
+  if (!Args.getLastArgValue(OPT_batch_jobs).empty()) {
+    if (opts.BatchFile.empty() && !opts.Server) {
+      errors << "/j requires /batch or --server.";
+      return 1;
+    }
+    if (Args.getLastArgValue(OPT_batch_jobs).getAsInteger(10, opts.BatchJobs) ||
+        opts.BatchJobs == 0) {
+      errors << "/j requires a positive number of jobs.";
+      return 1;
+    }
+  }
   opts.NotUseLegacyCBufLoad =
       Args.hasFlag(OPT_no_legacy_cbuf_layout, OPT_INVALID, false);
   opts.NotUseLegacyCBufLoad = Args.hasFlag(
@@ -771,6 +796,8 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   opts.PackOptimized = Args.hasFlag(OPT_pack_optimized, OPT_INVALID, false);
   opts.PackOptimized =
       Args.hasFlag(OPT_pack_optimized_, OPT_INVALID, opts.PackOptimized);
+  opts.PackMinimalRows =
+      Args.hasFlag(OPT_pack_minimal_rows, OPT_INVALID, false);
   opts.DisplayIncludeProcess = Args.hasFlag(OPT_H, OPT_INVALID, false);
   opts.WarningAsError = Args.hasFlag(OPT__SLASH_WX, OPT_INVALID, false);
   opts.AvoidFlowControl = Args.hasFlag(OPT_Gfa, OPT_INVALID, false);
@@ -782,6 +809,10 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
       Args.hasFlag(OPT_Qsource_in_debug_module, OPT_INVALID, false);
   opts.SourceOnlyDebug = Args.hasFlag(OPT_Zs, OPT_INVALID, false);
   opts.PdbInPrivate = Args.hasFlag(OPT_Qpdb_in_private, OPT_INVALID, false);
+  opts.PdbSourceBlocks =
+      Args.hasFlag(OPT_Qpdb_source_blocks, OPT_INVALID, false);
+  opts.ReuseLLVMContext =
+      Args.hasFlag(OPT_Qreuse_llvm_context, OPT_INVALID, false);
   opts.StripRootSignature =
       Args.hasFlag(OPT_Qstrip_rootsignature, OPT_INVALID, false);
   opts.StripPrivate = Args.hasFlag(OPT_Qstrip_priv, OPT_INVALID, false);
@@ -862,6 +893,11 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
               "together, use /? to get usage information";
     return 1;
   }
+  if (opts.PackPrefixStable && opts.PackMinimalRows) {
+    errors << "Cannot specify /pack_prefix_stable and /pack-minimal-rows "
+              "together, use /? to get usage information";
+    return 1;
+  }
   // TODO: more fxc option check.
   // ERR_RES_MAY_ALIAS_ONLY_IN_CS_5
   // ERR_NOT_ABLE_TO_FLATTEN on if that contain side effects
@@ -888,7 +924,8 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   }
 
   if ((flagsToInclude & hlsl::options::DriverOption) &&
-      opts.InputFile.empty()) {
+      opts.InputFile.empty() && opts.BatchFile.empty() &&
+      opts.PipelineFile.empty() && !opts.Server) {
     // Input file is required in arguments only for drivers; APIs take this
     // through an argument.
     errors << "Required input file argument is missing. use -help to get more "
@@ -938,7 +975,8 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
   if ((flagsToInclude & hlsl::options::DriverOption) &&
       !(flagsToInclude & hlsl::options::RewriteOption) &&
       opts.TargetProfile.empty() && !opts.DumpBin && opts.Preprocess.empty() &&
-      !opts.RecompileFromBinary) {
+      !opts.RecompileFromBinary && opts.BatchFile.empty() &&
+      opts.PipelineFile.empty() && !opts.Server) {
     // Target profile is required in arguments only for drivers when compiling;
     // APIs take this through an argument.
     errors << "Target profile argument is missing";
@@ -1096,6 +1134,13 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
 
   opts.SpirvOptions.printAll =
       Args.hasFlag(OPT_fspv_print_all, OPT_INVALID, false);
+  opts.SpirvOptions.optCacheDir =
+      Args.getLastArgValue(OPT_fspv_opt_cache_dir_EQ);
+  opts.SpirvOptions.enableOptCache =
+      Args.hasFlag(OPT_fspv_opt_cache, OPT_INVALID, false) ||
+      !opts.SpirvOptions.optCacheDir.empty();
+  opts.SpirvOptions.reportOptCache =
+      Args.hasFlag(OPT_fspv_opt_cache_report, OPT_INVALID, false);
 
   opts.SpirvOptions.debugInfoFile = opts.SpirvOptions.debugInfoSource = false;
   opts.SpirvOptions.debugInfoLine = opts.SpirvOptions.debugInfoTool = false;
@@ -1202,6 +1247,8 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
       Args.hasFlag(OPT_fspv_reflect, OPT_INVALID, false) ||
       Args.hasFlag(OPT_fspv_fix_func_call_arguments, OPT_INVALID, false) ||
       Args.hasFlag(OPT_fspv_print_all, OPT_INVALID, false) ||
+      Args.hasFlag(OPT_fspv_opt_cache, OPT_INVALID, false) ||
+      Args.hasFlag(OPT_fspv_opt_cache_report, OPT_INVALID, false) ||
       Args.hasFlag(OPT_Wno_vk_ignored_features, OPT_INVALID, false) ||
       Args.hasFlag(OPT_Wno_vk_emulated_features, OPT_INVALID, false) ||
       Args.hasFlag(OPT_fvk_auto_shift_bindings, OPT_INVALID, false) ||
@@ -1212,6 +1259,7 @@ int ReadDxcOpts(const OptTable *optionTable, unsigned flagsToInclude,
       !Args.getLastArgValue(OPT_fspv_extension_EQ).empty() ||
       !Args.getLastArgValue(OPT_fspv_target_env_EQ).empty() ||
       !Args.getLastArgValue(OPT_Oconfig).empty() ||
+      !Args.getLastArgValue(OPT_fspv_opt_cache_dir_EQ).empty() ||
       !Args.getLastArgValue(OPT_fvk_bind_register).empty() ||
       !Args.getLastArgValue(OPT_fvk_bind_globals).empty() ||
       !Args.getLastArgValue(OPT_fvk_b_shift).empty() ||
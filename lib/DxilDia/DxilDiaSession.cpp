@@ -13,6 +13,7 @@
 
 #include "dxc/DxilPIXPasses/DxilPIXVirtualRegisters.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/DebugInfoMetadata.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instruction.h"
@@ -20,6 +21,8 @@
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 
+#include <algorithm>
+
 #include "..\DxilPIXPasses\PixPassHelpers.h"
 #include "DxilDia.h"
 #include "DxilDiaEnumTables.h"
@@ -62,6 +65,16 @@ void dxil_dia::Session::Init(std::shared_ptr<llvm::LLVMContext> context,
   if (!m_arguments)
     m_arguments = m_module->getNamedMetadata("llvm.dbg.args");
 
+  // Index file names; the first file with a given name gets its ID.
+  if (m_contents != nullptr) {
+    for (unsigned i = 0; i < m_contents->getNumOperands(); ++i) {
+      llvm::StringRef fn = llvm::dyn_cast<llvm::MDString>(
+                               m_contents->getOperand(i)->getOperand(0))
+                               ->getString();
+      m_fileNameToId.insert(std::make_pair(fn, i));
+    }
+  }
+
   // Build up a linear list of instructions. The index will be used as the
   // RVA.
   std::vector<llvm::Function *> allInstrumentableFunctions =
@@ -96,6 +109,55 @@ void dxil_dia::Session::Init(std::shared_ptr<llvm::LLVMContext> context,
     DXASSERT(m_rvaMap[It->second] == It->first,
              "instruction mapped to wrong rva");
   }
+
+  // Build the lookup indexes.
+  m_rvaIndex.reserve(m_instructions.size());
+  for (auto &It : m_instructions) {
+    m_rvaIndex.push_back({It.first, It.second});
+  }
+
+  m_lineIndex.reserve(m_instructionLines.size());
+  for (const llvm::Instruction *inst : m_instructionLines) {
+    DWORD fileId;
+    if (getSourceFileIdOfInst(inst, &fileId) != S_OK)
+      fileId = kNoSourceFileId;
+    m_lineIndex.push_back({fileId, inst->getDebugLoc().getLine(), inst});
+  }
+  // Stable, so that entries of a line keep the line table order.
+  std::stable_sort(m_lineIndex.begin(), m_lineIndex.end(),
+                   [](const LineEntry &A, const LineEntry &B) {
+                     return A.FileId < B.FileId ||
+                            (A.FileId == B.FileId && A.Line < B.Line);
+                   });
+}
+
+bool dxil_dia::Session::FindInstructionsByRVA(
+    RVA rva, DWORD length, llvm::ArrayRef<RVAEntry> *pInstructions) const {
+  auto It = std::lower_bound(
+      m_rvaIndex.begin(), m_rvaIndex.end(), rva,
+      [](const RVAEntry &E, RVA R) -> bool { return E.Rva < R; });
+  size_t First = It - m_rvaIndex.begin();
+  if (length != 0) {
+    // RVAs are unique, so the range is complete if it has length entries
+    // starting at rva and ending at rva + length - 1.
+    if (m_rvaIndex.size() - First < length || It->Rva != rva ||
+        m_rvaIndex[First + length - 1].Rva - rva != length - 1)
+      return false;
+  }
+  *pInstructions = llvm::ArrayRef<RVAEntry>(m_rvaIndex.data() + First, length);
+  return true;
+}
+
+llvm::ArrayRef<dxil_dia::Session::LineEntry>
+dxil_dia::Session::FindInstructionsByLine(DWORD fileId, DWORD line) const {
+  auto Range = std::equal_range(
+      m_lineIndex.begin(), m_lineIndex.end(), LineEntry{fileId, line, nullptr},
+      [](const LineEntry &A, const LineEntry &B) {
+        return A.FileId < B.FileId || (A.FileId == B.FileId && A.Line < B.Line);
+      });
+  return llvm::ArrayRef<LineEntry>(m_lineIndex.data() +
+                                       (Range.first - m_lineIndex.begin()),
+                                   Range.second - Range.first);
 }
 
 const dxil_dia::SymbolManager &dxil_dia::Session::SymMgr() {
@@ -112,16 +174,26 @@ const dxil_dia::SymbolManager &dxil_dia::Session::SymMgr() {
 
 HRESULT dxil_dia::Session::getSourceFileIdByName(llvm::StringRef fileName,
                                                  DWORD *pRetVal) {
-  if (Contents() != nullptr) {
-    for (unsigned i = 0; i < Contents()->getNumOperands(); ++i) {
-      llvm::StringRef fn = llvm::dyn_cast<llvm::MDString>(
-                               Contents()->getOperand(i)->getOperand(0))
-                               ->getString();
-      if (fn.equals(fileName)) {
-        *pRetVal = i;
-        return S_OK;
-      }
-    }
+  auto It = m_fileNameToId.find(fileName);
+  if (It != m_fileNameToId.end()) {
+    *pRetVal = It->second;
+    return S_OK;
+  }
+  *pRetVal = 0;
+  return S_FALSE;
+}
+
+HRESULT dxil_dia::Session::getSourceFileIdOfInst(const llvm::Instruction *inst,
+                                                 DWORD *pRetVal) {
+  llvm::MDNode *pScope = inst->getDebugLoc().getScope();
+  auto *pBlock = llvm::dyn_cast_or_null<llvm::DILexicalBlock>(pScope);
+  if (pBlock != nullptr) {
+    return getSourceFileIdByName(pBlock->getFile()->getFilename(), pRetVal);
+  }
+  auto *pSubProgram = llvm::dyn_cast_or_null<llvm::DISubprogram>(pScope);
+  if (pSubProgram != nullptr) {
+    return getSourceFileIdByName(pSubProgram->getFile()->getFilename(),
+                                 pRetVal);
   }
   *pRetVal = 0;
   return S_FALSE;
@@ -231,19 +303,16 @@ static HRESULT DxcDiaFindLineNumbersByRVA(Session *pSession, DWORD rva,
   if (!ppResult)
     return E_POINTER;
 
-  std::vector<const llvm::Instruction *> instructions;
-  auto &allInstructions = pSession->InstructionsRef();
-
   // Gather the list of insructions that map to the given rva range.
-  for (DWORD i = rva; i < rva + length; ++i) {
-    auto It = allInstructions.find(i);
-    if (It == allInstructions.end())
-      return E_INVALIDARG;
+  llvm::ArrayRef<Session::RVAEntry> rangeInstructions;
+  if (!pSession->FindInstructionsByRVA(rva, length, &rangeInstructions))
+    return E_INVALIDARG;
 
+  std::vector<const llvm::Instruction *> instructions;
+  for (const Session::RVAEntry &E : rangeInstructions) {
     // Only include the instruction if it has debug info for line mappings.
-    const llvm::Instruction *inst = It->second;
-    if (inst->getDebugLoc())
-      instructions.push_back(inst);
+    if (E.Inst->getDebugLoc())
+      instructions.push_back(E.Inst);
   }
 
   // Create line number table from explicit instruction list.
@@ -296,19 +365,19 @@ STDMETHODIMP dxil_dia::Session::findLinesByLinenum(
   *ppResult = nullptr;
 
   DxcThreadMalloc TM(m_pMalloc);
-  CComPtr<IDiaTable> pTable;
-  VARIANT vtIndex;
-  vtIndex.vt = VT_UI4;
-  vtIndex.uintVal = (int)Table::Kind::LineNumbers;
-  IFR(m_pEnumTables->Item(vtIndex, &pTable));
-
-  CComPtr<IDiaEnumLineNumbers> pLineTable;
-  IFR(pTable->QueryInterface(&pLineTable));
-  HRESULT hr;
-  CComPtr<IDiaLineNumber> line;
-  ULONG cnt;
   std::vector<const llvm::Instruction *> lines;
 
+  // Lines whose source file is unknown match a null file. Otherwise the file
+  // must be this session's source file object.
+  DWORD fileId = kNoSourceFileId;
+  bool fileMatches = true;
+  if (file != nullptr) {
+    CComPtr<IDiaSourceFile> sessionFile;
+    fileMatches = SUCCEEDED(file->get_uniqueId(&fileId)) &&
+                  SUCCEEDED(findFileById(fileId, &sessionFile)) &&
+                  sessionFile == file;
+  }
+
   std::function<bool(DWORD, DWORD)> column_matches =
       [](DWORD colStart, DWORD colEnd) -> bool { return true; };
 
@@ -318,22 +387,14 @@ STDMETHODIMP dxil_dia::Session::findLinesByLinenum(
     };
   }
 
-  pLineTable->Reset();
-  while (SUCCEEDED(hr = pLineTable->Next(1, &line, &cnt)) && hr == S_OK &&
-         cnt == 1) {
-    CComPtr<IDiaSourceFile> f;
-    DWORD ln, lnEnd, cn, cnEnd;
-    IFR(line->get_lineNumber(&ln));
-    IFR(line->get_lineNumberEnd(&lnEnd));
-    IFR(line->get_columnNumber(&cn));
-    IFR(line->get_columnNumberEnd(&cnEnd));
-    IFR(line->get_sourceFile(&f));
-
-    if (file == f && (ln <= linenum && linenum <= lnEnd) &&
-        column_matches(cn, cnEnd)) {
-      lines.emplace_back(reinterpret_cast<LineNumber *>(line.p)->Inst());
+  if (fileMatches) {
+    // A line entry spans a single line and column.
+    for (const LineEntry &E : FindInstructionsByLine(fileId, linenum)) {
+      DWORD col = E.Inst->getDebugLoc().getCol();
+      if (column_matches(col, col)) {
+        lines.emplace_back(E.Inst);
+      }
     }
-    line.Release();
   }
 
   HRESULT result = lines.empty() ? S_FALSE : S_OK;
@@ -375,15 +436,14 @@ STDMETHODIMP dxil_dia::Session::findInlineFramesByAddr(
   *ppResult = nullptr;
 
   DxcThreadMalloc TM(m_pMalloc);
-  auto &allInstructions = InstructionsRef();
-  auto It = allInstructions.find(offset);
-  if (It == allInstructions.end()) {
+  llvm::ArrayRef<RVAEntry> instructions;
+  if (!FindInstructionsByRVA(offset, 1, &instructions)) {
     return E_INVALIDARG;
   }
 
   HRESULT hr;
   SymbolChildrenEnumerator *ChildrenEnum;
-  IFR(hr = SymMgr().DbgScopeOf(It->second, &ChildrenEnum));
+  IFR(hr = SymMgr().DbgScopeOf(instructions.front().Inst, &ChildrenEnum));
 
   *ppResult = ChildrenEnum;
   return hr;
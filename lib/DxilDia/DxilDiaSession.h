@@ -21,6 +21,8 @@
 #include "dia2.h"
 
 #include "dxc/DXIL/DxilModule.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
 #include "dxc/dxcpix.h"
 
 #include "dxc/Support/Global.h"
@@ -45,6 +47,19 @@ public:
   };
   using LineToInfoMap = std::unordered_map<std::uint32_t, LineInfo>;
 
+  struct RVAEntry {
+    RVA Rva;
+    const llvm::Instruction *Inst;
+  };
+
+  // Source file ID of instructions whose scope has no file in the contents.
+  static constexpr DWORD kNoSourceFileId = ~0u;
+  struct LineEntry {
+    DWORD FileId;
+    DWORD Line;
+    const llvm::Instruction *Inst;
+  };
+
   DXC_MICROCOM_TM_ADDREF_RELEASE_IMPL()
   DXC_MICROCOM_TM_CTOR(Session)
 
@@ -74,6 +89,16 @@ public:
   }
 
   HRESULT getSourceFileIdByName(llvm::StringRef fileName, DWORD *pRetVal);
+  HRESULT getSourceFileIdOfInst(const llvm::Instruction *inst, DWORD *pRetVal);
+
+  // Returns the instructions at RVAs [rva, rva + length), or false if any of
+  // them has no instruction.
+  bool FindInstructionsByRVA(RVA rva, DWORD length,
+                             llvm::ArrayRef<RVAEntry> *pInstructions) const;
+  // Returns the instructions with line info at the given line of a file, in
+  // line table order.
+  llvm::ArrayRef<LineEntry> FindInstructionsByLine(DWORD fileId,
+                                                   DWORD line) const;
 
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
                                            void **ppvObject) override {
@@ -499,6 +524,11 @@ private:
   std::unordered_map<const llvm::Instruction *, RVA>
       m_rvaMap; // Map instruction to its RVA.
   LineToInfoMap m_lineToInfoMap;
+  // Lookup indexes built once by Init; queries are binary searches.
+  std::vector<RVAEntry> m_rvaIndex; // All instructions, sorted by RVA.
+  std::vector<LineEntry>
+      m_lineIndex; // Instructions with line info, sorted by file and line.
+  llvm::StringMap<DWORD> m_fileNameToId;
   std::unique_ptr<SymbolManager> m_symsMgr;
 
 private:
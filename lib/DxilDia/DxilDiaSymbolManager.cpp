@@ -2313,6 +2313,11 @@ dxil_dia::hlsl_symbols::SymbolManagerInit::PopulateParentToChildrenIDMap(
       "parents vector must be the same size of symbols ctor vector: %d vs %d",
       m_SymCtors.size(), m_Parent.size());
 
+  // Count the children of each symbol, then place them; symbols are visited
+  // in ID order, so the children of a symbol are sorted by ID.
+  std::vector<DWORD> &Begin = pParentToChildren->Begin;
+  std::vector<DWORD> &Children = pParentToChildren->Children;
+  Begin.assign(m_Parent.size() + 1, 0);
   for (size_t i = 0; i < m_Parent.size(); ++i) {
 #ifndef NDEBUG
     {
@@ -2326,7 +2331,19 @@ dxil_dia::hlsl_symbols::SymbolManagerInit::PopulateParentToChildrenIDMap(
     DXASSERT_ARGS(m_Parent[i] != kNullSymbolID || (i + 1) == HlslProgramId,
                   "Parentless symbol %d", i + 1);
     if (m_Parent[i] != kNullSymbolID) {
-      pParentToChildren->emplace(m_Parent[i], i + 1);
+      DXASSERT_NOMSG(m_Parent[i] <= m_Parent.size());
+      ++Begin[m_Parent[i]];
+    }
+  }
+  for (size_t i = 1; i < Begin.size(); ++i) {
+    Begin[i] += Begin[i - 1];
+  }
+
+  Children.resize(Begin.back());
+  std::vector<DWORD> Next(Begin.begin(), Begin.end() - 1);
+  for (size_t i = 0; i < m_Parent.size(); ++i) {
+    if (m_Parent[i] != kNullSymbolID) {
+      Children[Next[m_Parent[i] - 1]++] = i + 1;
     }
   }
 
@@ -2346,7 +2363,8 @@ void dxil_dia::SymbolManager::Init(Session *pSes) {
   DXASSERT(m_pSession == nullptr, "SymbolManager already initialized");
   m_pSession = pSes;
   m_symbolCtors.clear();
-  m_parentToChildren.clear();
+  m_parentToChildren.Begin.clear();
+  m_parentToChildren.Children.clear();
 
   llvm::DebugInfoFinder &DIFinder = pSes->InfoRef();
   if (DIFinder.compile_unit_count() != 1) {
@@ -2466,10 +2484,15 @@ HRESULT dxil_dia::SymbolManager::GetGlobalScope(Symbol **ppSym) const {
 HRESULT dxil_dia::SymbolManager::ChildrenOf(
     DWORD ID, std::vector<CComPtr<Symbol>> *pChildren) const {
   pChildren->clear();
-  auto childrenList = m_parentToChildren.equal_range(ID);
-  for (auto it = childrenList.first; it != childrenList.second; ++it) {
+  if (ID == kNullSymbolID || ID >= m_parentToChildren.Begin.size()) {
+    return S_OK;
+  }
+  const DWORD First = m_parentToChildren.Begin[ID - 1];
+  const DWORD Last = m_parentToChildren.Begin[ID];
+  pChildren->reserve(Last - First);
+  for (DWORD i = First; i < Last; ++i) {
     CComPtr<Symbol> Child;
-    IFR(GetSymbolByID(it->second, &Child));
+    IFR(GetSymbolByID(m_parentToChildren.Children[i], &Child));
     pChildren->emplace_back(Child);
   }
   return S_OK;
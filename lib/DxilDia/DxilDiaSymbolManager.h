@@ -56,7 +56,12 @@ public:
 
   using ScopeToIDMap = llvm::DenseMap<llvm::DIScope *, DWORD>;
   using IDToLiveRangeMap = std::unordered_map<DWORD, LiveRange>;
-  using ParentToChildrenMap = std::unordered_multimap<DWORD, DWORD>;
+  // Children of every symbol in ID order: the children of symbol ID are
+  // Children[Begin[ID - 1]] up to Children[Begin[ID]].
+  struct ParentToChildrenMap {
+    std::vector<DWORD> Begin;
+    std::vector<DWORD> Children;
+  };
 
   SymbolManager();
   SymbolManager(SymbolManager &&) = default;
@@ -13,8 +13,6 @@
 
 #include <utility>
 
-#include "llvm/IR/DebugInfoMetadata.h"
-
 #include "DxilDiaSession.h"
 
 dxil_dia::LineNumber::LineNumber(
@@ -122,19 +120,9 @@ STDMETHODIMP dxil_dia::LineNumber::get_statement(
 
 STDMETHODIMP dxil_dia::LineNumber::get_sourceFileId(
     /* [retval][out] */ DWORD *pRetVal) {
-  llvm::MDNode *pScope = DL().getScope();
-  auto *pBlock = llvm::dyn_cast_or_null<llvm::DILexicalBlock>(pScope);
-  if (pBlock != nullptr) {
-    return m_pSession->getSourceFileIdByName(pBlock->getFile()->getFilename(),
-                                             pRetVal);
-  }
-  auto *pSubProgram = llvm::dyn_cast_or_null<llvm::DISubprogram>(pScope);
-  if (pSubProgram != nullptr) {
-    return m_pSession->getSourceFileIdByName(
-        pSubProgram->getFile()->getFilename(), pRetVal);
-  }
-  *pRetVal = 0;
-  return S_FALSE;
+  DXASSERT(bool(m_inst->getDebugLoc()),
+           "Trying to read line info from invalid debug location");
+  return m_pSession->getSourceFileIdOfInst(m_inst, pRetVal);
 }
 
 STDMETHODIMP dxil_dia::LineNumber::get_compilandId(
@@ -33,6 +33,7 @@ class DxilAddPixelHitInstrumentation : public ModulePass {
   int RTWidth = 1024;
   int NumPixels = 128;
   int SVPositionIndex = -1;
+  bool WaveAggregate = false;
 
 public:
   static char ID; // Pass identification, replacement for typeid
@@ -48,6 +49,7 @@ void DxilAddPixelHitInstrumentation::applyOptions(PassOptions O) {
   GetPassOptionInt(O, "rt-width", &RTWidth, 0);
   GetPassOptionInt(O, "num-pixels", &NumPixels, 0);
   GetPassOptionInt(O, "sv-position-index", &SVPositionIndex, 0);
+  GetPassOptionBool(O, "wave-aggregate", &WaveAggregate, false);
 }
 
 bool DxilAddPixelHitInstrumentation::runOnModule(Module &M) {
@@ -175,6 +177,84 @@ bool DxilAddPixelHitInstrumentation::runOnModule(Module &M) {
                                     "ByteIndex");
         }
 
+        // With wave aggregation, the lanes of a wave are grouped by pixel: each
+        // pass of a loop takes the pixel of the first remaining lane, counts
+        // the lanes that hit it, and lets them leave the loop, so that one
+        // atomic per distinct pixel is done by the first lane of each group.
+        // Every pass retires at least one lane, so no more passes than the
+        // wave has lanes are needed; lanes still left after that (such as
+        // helper lanes, which wave operations may not count) do their own
+        // atomic. The atomics are moved into a block that only the lanes doing
+        // an update branch to.
+        Value *Increment = One32Arg;
+        if (WaveAggregate) {
+          DM.m_ShaderFlags.SetWaveOps(true);
+          Function *LaneCountFunc = HlslOP->GetOpFunc(
+              DXIL::OpCode::WaveGetLaneCount, Type::getVoidTy(Ctx));
+          auto LaneCount = Builder.CreateCall(
+              LaneCountFunc,
+              {HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveGetLaneCount)},
+              "WaveLaneCount");
+
+          BasicBlock *Tail =
+              EntryBlock.splitBasicBlock(ThisInstruction, "PIXPixelHitTail");
+          BasicBlock *LoopBlock = BasicBlock::Create(Ctx, "PIXPixelHitLoop",
+                                                     EntryPointFunction, Tail);
+          BasicBlock *GroupBlock = BasicBlock::Create(Ctx, "PIXPixelHitGroup",
+                                                      EntryPointFunction, Tail);
+          BasicBlock *AtomicBlock = BasicBlock::Create(
+              Ctx, "PIXPixelHitAtomic", EntryPointFunction, Tail);
+          EntryBlock.getTerminator()->eraseFromParent();
+          BranchInst::Create(LoopBlock, &EntryBlock);
+
+          IRBuilder<> LoopBuilder(LoopBlock);
+          PHINode *Pass =
+              LoopBuilder.CreatePHI(Type::getInt32Ty(Ctx), 2, "PixelHitPass");
+          Function *ReadLaneFirstFunc = HlslOP->GetOpFunc(
+              DXIL::OpCode::WaveReadLaneFirst, Type::getInt32Ty(Ctx));
+          auto FirstByteIndex = LoopBuilder.CreateCall(
+              ReadLaneFirstFunc,
+              {HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveReadLaneFirst),
+               Index},
+              "WaveFirstByteIndex");
+          auto SharesFirstPixel = LoopBuilder.CreateICmpEQ(
+              Index, FirstByteIndex, "SharesFirstPixel");
+          Function *BitCountFunc = HlslOP->GetOpFunc(
+              DXIL::OpCode::WaveAllBitCount, Type::getVoidTy(Ctx));
+          auto WaveHits = LoopBuilder.CreateCall(
+              BitCountFunc,
+              {HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveAllBitCount),
+               SharesFirstPixel},
+              "WaveHits");
+          Function *IsFirstLaneFunc = HlslOP->GetOpFunc(
+              DXIL::OpCode::WaveIsFirstLane, Type::getVoidTy(Ctx));
+          auto IsFirstLane = LoopBuilder.CreateCall(
+              IsFirstLaneFunc,
+              {HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveIsFirstLane)},
+              "IsFirstLane");
+          auto NextPass =
+              LoopBuilder.CreateAdd(Pass, One32Arg, "NextPixelHitPass");
+          auto LastPass = LoopBuilder.CreateICmpUGE(NextPass, LaneCount,
+                                                    "LastPixelHitPass");
+          auto LeavesLoop =
+              LoopBuilder.CreateOr(SharesFirstPixel, LastPass, "LeavesLoop");
+          LoopBuilder.CreateCondBr(LeavesLoop, GroupBlock, LoopBlock);
+          Pass->addIncoming(Zero32Arg, &EntryBlock);
+          Pass->addIncoming(NextPass, LoopBlock);
+
+          // The first lane of a group counts the group; a lane that left the
+          // loop without joining a group counts itself.
+          IRBuilder<> GroupBuilder(GroupBlock);
+          auto UpdatesCounter = GroupBuilder.CreateOr(
+              IsFirstLane,
+              GroupBuilder.CreateNot(SharesFirstPixel, "Ungrouped"),
+              "UpdatesCounter");
+          Increment = GroupBuilder.CreateSelect(SharesFirstPixel, WaveHits,
+                                                One32Arg, "PixelHitIncrement");
+          GroupBuilder.CreateCondBr(UpdatesCounter, AtomicBlock, Tail);
+          Builder.SetInsertPoint(BranchInst::Create(Tail, AtomicBlock));
+        }
+
         // Insert the UAV increment instruction:
         Function *AtomicOpFunc =
             HlslOP->GetOpFunc(OP::OpCode::AtomicBinOp, Type::getInt32Ty(Ctx));
@@ -193,7 +273,7 @@ bool DxilAddPixelHitInstrumentation::runOnModule(Module &M) {
                   Index,     // i32, ; coordinate c0: byte offset
                   UndefArg,  // i32, ; coordinate c1 (unused)
                   UndefArg,  // i32, ; coordinate c2 (unused)
-                  One32Arg   // i32); increment value
+                  Increment  // i32); increment value
               },
               "UAVIncResult");
         }
@@ -232,7 +312,12 @@ bool DxilAddPixelHitInstrumentation::runOnModule(Module &M) {
           auto OffsetIndex = Builder.CreateAdd(Index, NumPixelsByteOffsetArg,
                                                "OffsetByteIndex");
 
-          // Step 3: Increment UAV value by the weight
+          // Step 3: Increment UAV value by the weight (times the number of
+          // hits this lane is counting)
+          Value *Cost = Weight;
+          if (WaveAggregate) {
+            Cost = Builder.CreateMul(Weight, Increment, "WaveWeight");
+          }
           (void)Builder.CreateCall(
               AtomicOpFunc,
               {
@@ -243,7 +328,7 @@ bool DxilAddPixelHitInstrumentation::runOnModule(Module &M) {
                   OffsetIndex, // i32, ; coordinate c0: byte offset
                   UndefArg,    // i32, ; coordinate c1 (unused)
                   UndefArg,    // i32, ; coordinate c2 (unused)
-                  Weight       // i32); increment value
+                  Cost         // i32); increment value
               },
               "UAVIncResult2");
         }
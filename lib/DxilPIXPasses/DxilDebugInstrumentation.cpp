@@ -20,6 +20,8 @@
 #include "dxc/HLSL/DxilGenerationPass.h"
 
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
@@ -88,6 +90,22 @@ using namespace hlsl;
 // overwritten, the debug session is deemed to have overflowed the UAV. The
 // caller will than allocate a UAV that is twice the size and try again, up to a
 // predefined maximum.
+//
+// Three optional modes reduce the cost of the instrumentation on large
+// dispatches. They are off by default, since the debugger application has to
+// ask for output it can read:
+// -  WaveAggregatedCounter: the lanes of a wave add up their increments, the
+//    first lane does a single atomic add on the counter, and each lane then
+//    finds its own offset from the result and a prefix sum of the increments.
+// -  CompactSteps: step records leave out the instruction offset, and the
+//    value ordinal when it is the register of the instruction itself. The
+//    instruction number is kept in the record header, as the distance from
+//    the previous step of the same straight-line code, or as an absolute
+//    number at the start of each block.
+// -  SampleRate=N: besides the invocation selected by the parameters, about
+//    one in N invocations is of interest, chosen by a hash of the values that
+//    identify the invocation. As with overlapping triangles, the instance
+//    identifiers keep their records apart.
 
 // Keep these in sync with the same-named value in the debugger application's
 // WinPixShaderUtils.h
@@ -110,6 +128,16 @@ enum DebugShaderModifierRecordType {
   DebugShaderModifierRecordTypeRegisterRelativeIndex0,
   DebugShaderModifierRecordTypeRegisterRelativeIndex1,
   DebugShaderModifierRecordTypeRegisterRelativeIndex2,
+  // The compact step types are only written in CompactSteps mode. The
+  // debugger application's debugshaderrecord.h and WinPixShaderUtils.h ship
+  // with PIX, not with this repository, and need the same values before PIX
+  // can read that mode's output.
+  DebugShaderModifierRecordTypeDXILCompactStepTerminator = 244,
+  DebugShaderModifierRecordTypeDXILCompactStepVoid = 245,
+  DebugShaderModifierRecordTypeDXILCompactStepFloat = 246,
+  DebugShaderModifierRecordTypeDXILCompactStepUint32 = 247,
+  DebugShaderModifierRecordTypeDXILCompactStepUint64 = 248,
+  DebugShaderModifierRecordTypeDXILCompactStepDouble = 249,
   DebugShaderModifierRecordTypeDXILStepTerminator = 250,
   DebugShaderModifierRecordTypeDXILStepVoid = 251,
   DebugShaderModifierRecordTypeDXILStepFloat = 252,
@@ -166,8 +194,38 @@ struct DebugShaderModifierRecordDXILStep
 template <>
 struct DebugShaderModifierRecordDXILStep<void>
     : public DebugShaderModifierRecordDXILStepBase {};
+
+// Written instead of a DXILStep record in CompactSteps mode. The return value,
+// if any, follows the UID, and the value ordinal follows that if the
+// DXILCompactStepFlagValueOrdinal flag is set.
+struct DebugShaderModifierRecordDXILCompactStep {
+  union {
+    struct {
+      uint32_t SizeDwords : 4;
+      uint32_t Flags : 4;
+      uint32_t Type : 8;
+      uint32_t Instruction : 16;
+    } Details;
+    uint32_t u32Header;
+  } Header;
+  uint32_t UID;
+};
 #pragma pack(pop)
 
+enum DebugShaderModifierRecordDXILCompactStepFlags {
+  // Instruction is the instruction number, rather than its distance from the
+  // instruction of the previous step record of the invocation.
+  DXILCompactStepFlagAbsoluteInstruction = 1,
+  DXILCompactStepFlagValueOrdinal = 2,
+};
+
+static DebugShaderModifierRecordType
+CompactStepRecordType(DebugShaderModifierRecordType RecordType) {
+  return static_cast<DebugShaderModifierRecordType>(
+      RecordType - DebugShaderModifierRecordTypeDXILStepTerminator +
+      DebugShaderModifierRecordTypeDXILCompactStepTerminator);
+}
+
 uint32_t
 DebugShaderModifierRecordPayloadSizeDwords(size_t recordTotalSizeBytes) {
   return ((recordTotalSizeBytes - sizeof(DebugShaderModifierRecordHeader)) /
@@ -218,6 +276,15 @@ private:
   unsigned m_LastInstruction = static_cast<unsigned>(-1);
 
   uint64_t m_UAVSize = 1024 * 1024;
+  bool m_WaveAggregatedCounter = false;
+  bool m_CompactSteps = false;
+  unsigned m_SampleRate = 0;
+  // The values that identify the invocation, gathered by the prologs for
+  // sampling.
+  SmallVector<Value *, 3> m_InvocationKey;
+  // The instruction number of the previous step record in the straight-line
+  // code being instrumented, or -1 at the start of a block.
+  int64_t m_PreviousStepInstNum = -1;
   struct PerFunctionValues {
     CallInst *UAVHandle = nullptr;
     Constant *CounterOffset = nullptr;
@@ -278,17 +345,26 @@ private:
   void addDebugEntryValue(BuilderContext &BC, Value *TheValue);
   void addInvocationStartMarker(BuilderContext &BC);
   void reserveDebugEntrySpace(BuilderContext &BC, uint32_t SpaceInDwords);
+  Value *addWaveAggregatedIncrement(BuilderContext &BC, Value *Increment);
+  Value *encodeValueOrdinal(BuilderContext &BC, std::uint32_t ValueOrdinal,
+                            Value *ValueOrdinalIndex);
   void addStoreStepDebugEntry(BuilderContext &BC, StoreInst *Inst);
   void addStepDebugEntry(BuilderContext &BC, Instruction *Inst);
   void addStepDebugEntryValue(BuilderContext &BC, std::uint32_t InstNum,
                               Value *V, std::uint32_t ValueOrdinal,
-                              Value *ValueOrdinalIndex);
+                              Value *ValueOrdinalIndex,
+                              bool ValueOrdinalIsInstReg);
   uint32_t UAVDumpingGroundOffset();
   template <typename ReturnType>
   void addStepEntryForType(DebugShaderModifierRecordType RecordType,
                            BuilderContext &BC, std::uint32_t InstNum, Value *V,
-                           std::uint32_t ValueOrdinal,
-                           Value *ValueOrdinalIndex);
+                           std::uint32_t ValueOrdinal, Value *ValueOrdinalIndex,
+                           bool ValueOrdinalIsInstReg);
+  bool addCompactStepEntry(DebugShaderModifierRecordType RecordType,
+                           BuilderContext &BC, std::uint32_t InstNum, Value *V,
+                           std::uint32_t ValueDwords,
+                           std::uint32_t ValueOrdinal, Value *ValueOrdinalIndex,
+                           bool ValueOrdinalIsInstReg);
 };
 
 void DxilDebugInstrumentation::applyOptions(PassOptions O) {
@@ -299,6 +375,10 @@ void DxilDebugInstrumentation::applyOptions(PassOptions O) {
   GetPassOptionUnsigned(O, "parameter1", &m_Parameters.Parameters[1], 0);
   GetPassOptionUnsigned(O, "parameter2", &m_Parameters.Parameters[2], 0);
   GetPassOptionUInt64(O, "UAVSize", &m_UAVSize, 1024 * 1024);
+  GetPassOptionBool(O, "WaveAggregatedCounter", &m_WaveAggregatedCounter,
+                    false);
+  GetPassOptionBool(O, "CompactSteps", &m_CompactSteps, false);
+  GetPassOptionUnsigned(O, "SampleRate", &m_SampleRate, 0);
 }
 
 uint32_t DxilDebugInstrumentation::UAVDumpingGroundOffset() {
@@ -414,6 +494,7 @@ Value *DxilDebugInstrumentation::addDispatchedShaderProlog(BuilderContext &BC) {
       BC.Builder.CreateCall(ThreadIdFunc, {Opcode, One32Arg}, "ThreadIdY");
   auto ThreadIdZ =
       BC.Builder.CreateCall(ThreadIdFunc, {Opcode, Two32Arg}, "ThreadIdZ");
+  m_InvocationKey.append({ThreadIdX, ThreadIdY, ThreadIdZ});
 
   // Compare to expected thread ID
   auto CompareToX = BC.Builder.CreateICmpEQ(
@@ -449,6 +530,7 @@ Value *DxilDebugInstrumentation::addRaygenShaderProlog(BuilderContext &BC) {
   auto RayZ = BC.Builder.CreateCall(
       DispatchRaysIndexOpFunc,
       {DispatchRaysIndexOpcode, BC.HlslOP->GetI8Const(2)}, "RayZ");
+  m_InvocationKey.append({RayX, RayY, RayZ});
 
   auto CompareToX = BC.Builder.CreateICmpEQ(
       RayX, BC.HlslOP->GetU32Const(m_Parameters.ComputeShader.ThreadIdX),
@@ -496,6 +578,7 @@ DxilDebugInstrumentation::addVertexShaderProlog(BuilderContext &BC,
                             {LoadInputOpcode, SV_Instance_ID, Zero32Arg /*row*/,
                              Zero8Arg /*column*/, UndefArg},
                             "InstanceId");
+  m_InvocationKey.append({VertId, InstanceId});
 
   // Compare to expected vertex ID and instance ID
   auto CompareToVert = BC.Builder.CreateICmpEQ(
@@ -517,6 +600,7 @@ Value *DxilDebugInstrumentation::addHullhaderProlog(BuilderContext &BC) {
       BC.HlslOP->GetU32Const((unsigned)DXIL::OpCode::OutputControlPointID);
   auto ControlPointId = BC.Builder.CreateCall(
       LoadControlPointFunction, {LoadControlPointOpcode}, "ControlPointId");
+  m_InvocationKey.push_back(ControlPointId);
 
   auto *CompareToPrimId =
       addComparePrimitiveIdProlog(BC, m_Parameters.HullShader.PrimitiveId);
@@ -540,6 +624,7 @@ Value *DxilDebugInstrumentation::addComparePrimitiveIdProlog(BuilderContext &BC,
       BC.HlslOP->GetU32Const((unsigned)DXIL::OpCode::PrimitiveID);
   auto PrimId =
       BC.Builder.CreateCall(PrimitiveIdFunction, {PrimitiveIdOpcode}, "PrimId");
+  m_InvocationKey.push_back(PrimId);
 
   return BC.Builder.CreateICmpEQ(PrimId, BC.HlslOP->GetU32Const(primId),
                                  "CompareToPrimId");
@@ -559,6 +644,7 @@ Value *DxilDebugInstrumentation::addGeometryShaderProlog(BuilderContext &BC) {
       BC.HlslOP->GetU32Const((unsigned)DXIL::OpCode::GSInstanceID);
   auto GSInstanceId = BC.Builder.CreateCall(
       GSInstanceIdOpFunc, {GSInstanceIdOpcode}, "GSInstanceId");
+  m_InvocationKey.push_back(GSInstanceId);
 
   // Compare to expected vertex ID and instance ID
   auto CompareToInstance = BC.Builder.CreateICmpEQ(
@@ -604,6 +690,7 @@ DxilDebugInstrumentation::addPixelShaderProlog(BuilderContext &BC,
                                    Type::getInt32Ty(BC.Ctx), "XIndex");
     YAsInt = BC.Builder.CreateCast(Instruction::CastOps::FPToUI, YPos,
                                    Type::getInt32Ty(BC.Ctx), "YIndex");
+    m_InvocationKey.append({XAsInt, YAsInt});
   }
 
   // Compare to expected pixel position and primitive ID
@@ -620,6 +707,7 @@ void DxilDebugInstrumentation::addInvocationSelectionProlog(
     BuilderContext &BC, SystemValueIndices SVIndices,
     DXIL::ShaderKind shaderKind) {
   Value *ParameterTestResult = nullptr;
+  m_InvocationKey.clear();
   switch (shaderKind) {
   case DXIL::ShaderKind::RayGeneration:
   case DXIL::ShaderKind::ClosestHit:
@@ -653,6 +741,26 @@ void DxilDebugInstrumentation::addInvocationSelectionProlog(
     assert(false); // guaranteed by runOnModule
   }
 
+  if (m_SampleRate != 0 && !m_InvocationKey.empty()) {
+    // Hash the identifying values, so that the sampled invocations are spread
+    // over the whole dispatch or render target.
+    IRBuilder<> &B = BC.Builder;
+    Value *Key = m_InvocationKey[0];
+    for (unsigned i = 1; i < m_InvocationKey.size(); ++i) {
+      Key = B.CreateMul(Key, BC.HlslOP->GetU32Const(0x01000193), "SampleKey");
+      Key = B.CreateXor(Key, m_InvocationKey[i], "SampleKey");
+    }
+    Value *Hash =
+        B.CreateMul(Key, BC.HlslOP->GetU32Const(0x9E3779B1), "SampleHash");
+    Value *Bucket =
+        B.CreateURem(B.CreateLShr(Hash, 16, "SampleHashHigh"),
+                     BC.HlslOP->GetU32Const(m_SampleRate), "SampleBucket");
+    Value *IsSampled =
+        B.CreateICmpEQ(Bucket, BC.HlslOP->GetU32Const(0), "IsSampled");
+    ParameterTestResult =
+        B.CreateOr(ParameterTestResult, IsSampled, "SelectedOrSampled");
+  }
+
   // This is a convenient place to calculate the values that modify the UAV
   // offset for invocations of interest and for UAV size.
   auto &values = m_FunctionToValues[BC.Builder.GetInsertBlock()->getParent()];
@@ -692,19 +800,24 @@ void DxilDebugInstrumentation::reserveDebugEntrySpace(BuilderContext &BC,
   Value *IncrementForThisInvocation = BC.Builder.CreateMul(
       Increment, values.OffsetMultiplicand, "IncrementForThisInvocation");
 
-  auto PreviousValue = BC.Builder.CreateCall(
-      AtomicOpFunc,
-      {
-          AtomicBinOpcode,  // i32, ; opcode
-          values.UAVHandle, // %dx.types.Handle, ; resource handle
-          AtomicAdd, // i32, ; binary operation code : EXCHANGE, IADD, AND, OR,
-                     // XOR, IMIN, IMAX, UMIN, UMAX
-          values.CounterOffset,       // i32, ; coordinate c0: index in bytes
-          UndefArg,                   // i32, ; coordinate c1 (unused)
-          UndefArg,                   // i32, ; coordinate c2 (unused)
-          IncrementForThisInvocation, // i32); increment value
-      },
-      "UAVIncResult");
+  Value *PreviousValue;
+  if (m_WaveAggregatedCounter) {
+    PreviousValue = addWaveAggregatedIncrement(BC, IncrementForThisInvocation);
+  } else {
+    PreviousValue = BC.Builder.CreateCall(
+        AtomicOpFunc,
+        {
+            AtomicBinOpcode,  // i32, ; opcode
+            values.UAVHandle, // %dx.types.Handle, ; resource handle
+            AtomicAdd, // i32, ; binary operation code : EXCHANGE, IADD, AND,
+                       // OR, XOR, IMIN, IMAX, UMIN, UMAX
+            values.CounterOffset,       // i32, ; coordinate c0: index in bytes
+            UndefArg,                   // i32, ; coordinate c1 (unused)
+            UndefArg,                   // i32, ; coordinate c2 (unused)
+            IncrementForThisInvocation, // i32); increment value
+        },
+        "UAVIncResult");
+  }
 
   if (values.InvocationId == nullptr) {
     values.InvocationId = PreviousValue;
@@ -722,6 +835,74 @@ void DxilDebugInstrumentation::reserveDebugEntrySpace(BuilderContext &BC,
   values.CurrentIndex = AddedForInterest;
 }
 
+// Adds the increments of the active lanes of the wave to the counter with a
+// single atomic operation from the first lane, and returns the counter value
+// this lane would have seen had it done its own atomic add. Splits the block
+// at the insertion point; the builder is left in the new tail block.
+Value *DxilDebugInstrumentation::addWaveAggregatedIncrement(BuilderContext &BC,
+                                                            Value *Increment) {
+  auto &values = m_FunctionToValues[BC.Builder.GetInsertBlock()->getParent()];
+  IRBuilder<> &B = BC.Builder;
+  Type *I32Ty = Type::getInt32Ty(BC.Ctx);
+  Constant *SumOp = BC.HlslOP->GetI8Const((char)DXIL::WaveOpKind::Sum);
+  Constant *UnsignedOp =
+      BC.HlslOP->GetI8Const((char)DXIL::SignedOpKind::Unsigned);
+
+  Function *WaveActiveOpFunc =
+      BC.HlslOP->GetOpFunc(DXIL::OpCode::WaveActiveOp, I32Ty);
+  auto WaveIncrement = B.CreateCall(
+      WaveActiveOpFunc,
+      {BC.HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveActiveOp), Increment,
+       SumOp, UnsignedOp},
+      "WaveIncrement");
+  Function *WavePrefixOpFunc =
+      BC.HlslOP->GetOpFunc(DXIL::OpCode::WavePrefixOp, I32Ty);
+  auto LaneOffset = B.CreateCall(
+      WavePrefixOpFunc,
+      {BC.HlslOP->GetU32Const((unsigned)DXIL::OpCode::WavePrefixOp), Increment,
+       SumOp, UnsignedOp},
+      "LaneOffset");
+  Function *IsFirstLaneFunc = BC.HlslOP->GetOpFunc(
+      DXIL::OpCode::WaveIsFirstLane, Type::getVoidTy(BC.Ctx));
+  auto IsFirstLane = B.CreateCall(
+      IsFirstLaneFunc,
+      {BC.HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveIsFirstLane)},
+      "IsFirstLane");
+
+  Instruction *SplitBefore = &*B.GetInsertPoint();
+  BasicBlock *Head = SplitBefore->getParent();
+  BasicBlock *Tail = Head->splitBasicBlock(SplitBefore, "PIXDebugWaveTail");
+  BasicBlock *AtomicBlock =
+      BasicBlock::Create(BC.Ctx, "PIXDebugWaveAtomic", Head->getParent(), Tail);
+  Head->getTerminator()->eraseFromParent();
+  BranchInst::Create(AtomicBlock, Tail, IsFirstLane, Head);
+
+  IRBuilder<> AtomicBuilder(AtomicBlock);
+  Function *AtomicOpFunc = BC.HlslOP->GetOpFunc(OP::OpCode::AtomicBinOp, I32Ty);
+  UndefValue *UndefArg = UndefValue::get(I32Ty);
+  auto WaveResult = AtomicBuilder.CreateCall(
+      AtomicOpFunc,
+      {BC.HlslOP->GetU32Const((unsigned)OP::OpCode::AtomicBinOp),
+       values.UAVHandle,
+       BC.HlslOP->GetU32Const((unsigned)DXIL::AtomicBinOpCode::Add),
+       values.CounterOffset, UndefArg, UndefArg, WaveIncrement},
+      "WaveUAVIncResult");
+  AtomicBuilder.CreateBr(Tail);
+
+  B.SetInsertPoint(SplitBefore);
+  PHINode *FirstLaneResult = B.CreatePHI(I32Ty, 2, "FirstLaneUAVIncResult");
+  FirstLaneResult->addIncoming(WaveResult, AtomicBlock);
+  FirstLaneResult->addIncoming(UndefArg, Head);
+  Function *ReadLaneFirstFunc =
+      BC.HlslOP->GetOpFunc(DXIL::OpCode::WaveReadLaneFirst, I32Ty);
+  auto WaveBase = B.CreateCall(
+      ReadLaneFirstFunc,
+      {BC.HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveReadLaneFirst),
+       FirstLaneResult},
+      "WaveUAVBase");
+  return B.CreateAdd(WaveBase, LaneOffset, "UAVIncResult");
+}
+
 void DxilDebugInstrumentation::addDebugEntryValue(BuilderContext &BC,
                                                   Value *TheValue) {
   assert(m_RemainingReservedSpaceInBytes > 0);
@@ -818,12 +999,79 @@ void DxilDebugInstrumentation::addInvocationStartMarker(BuilderContext &BC) {
   addDebugEntryValue(BC, values.InvocationId);
 }
 
+Value *DxilDebugInstrumentation::encodeValueOrdinal(BuilderContext &BC,
+                                                    std::uint32_t ValueOrdinal,
+                                                    Value *ValueOrdinalIndex) {
+  IRBuilder<> &B = BC.Builder;
+
+  Value *VO = BC.HlslOP->GetU32Const(ValueOrdinal << 16);
+  Value *VOI = B.CreateAnd(ValueOrdinalIndex, BC.HlslOP->GetU32Const(0xFFFF),
+                           "ValueOrdinalIndex");
+  return B.CreateOr(VO, VOI, "ValueOrdinal");
+}
+
+// Writes a compact step record, or returns false if the instruction number
+// cannot be encoded in one.
+bool DxilDebugInstrumentation::addCompactStepEntry(
+    DebugShaderModifierRecordType RecordType, BuilderContext &BC,
+    std::uint32_t InstNum, Value *V, std::uint32_t ValueDwords,
+    std::uint32_t ValueOrdinal, Value *ValueOrdinalIndex,
+    bool ValueOrdinalIsInstReg) {
+  DebugShaderModifierRecordDXILCompactStep step = {};
+  if (m_PreviousStepInstNum >= 0 && InstNum >= m_PreviousStepInstNum &&
+      InstNum - m_PreviousStepInstNum <= 0xFFFF) {
+    step.Header.Details.Instruction = InstNum - m_PreviousStepInstNum;
+  } else if (InstNum <= 0xFFFF) {
+    step.Header.Details.Flags = DXILCompactStepFlagAbsoluteInstruction;
+    step.Header.Details.Instruction = InstNum;
+  } else {
+    return false;
+  }
+
+  bool WriteValueOrdinal = ValueDwords != 0 && !ValueOrdinalIsInstReg;
+  if (WriteValueOrdinal)
+    step.Header.Details.Flags |= DXILCompactStepFlagValueOrdinal;
+  uint32_t SizeInBytes =
+      sizeof(step) + (ValueDwords + (WriteValueOrdinal ? 1 : 0)) * 4;
+  reserveDebugEntrySpace(BC, SizeInBytes);
+
+  auto &values = m_FunctionToValues[BC.Builder.GetInsertBlock()->getParent()];
+
+  step.Header.Details.SizeDwords =
+      DebugShaderModifierRecordPayloadSizeDwords(SizeInBytes);
+  step.Header.Details.Type =
+      static_cast<uint8_t>(CompactStepRecordType(RecordType));
+  addDebugEntryValue(BC, BC.HlslOP->GetU32Const(step.Header.u32Header));
+  addDebugEntryValue(BC, values.InvocationId);
+  if (ValueDwords != 0)
+    addDebugEntryValue(BC, V);
+  if (WriteValueOrdinal)
+    addDebugEntryValue(BC,
+                       encodeValueOrdinal(BC, ValueOrdinal, ValueOrdinalIndex));
+  m_PreviousStepInstNum = InstNum;
+  return true;
+}
+
 template <typename ReturnType>
 void DxilDebugInstrumentation::addStepEntryForType(
     DebugShaderModifierRecordType RecordType, BuilderContext &BC,
     std::uint32_t InstNum, Value *V, std::uint32_t ValueOrdinal,
-    Value *ValueOrdinalIndex) {
+    Value *ValueOrdinalIndex, bool ValueOrdinalIsInstReg) {
   DebugShaderModifierRecordDXILStep<ReturnType> step = {};
+
+  if (m_CompactSteps) {
+    // The full record holds the value and its ordinal after the base.
+    std::uint32_t ValueDwords =
+        (sizeof(step) - sizeof(DebugShaderModifierRecordDXILStepBase)) / 4;
+    if (ValueDwords != 0)
+      --ValueDwords;
+    if (addCompactStepEntry(RecordType, BC, InstNum, V, ValueDwords,
+                            ValueOrdinal, ValueOrdinalIndex,
+                            ValueOrdinalIsInstReg))
+      return;
+  }
+  m_PreviousStepInstNum = InstNum;
+
   reserveDebugEntrySpace(BC, sizeof(step));
 
   auto &values = m_FunctionToValues[BC.Builder.GetInsertBlock()->getParent()];
@@ -838,15 +1086,8 @@ void DxilDebugInstrumentation::addStepEntryForType(
   if (RecordType != DebugShaderModifierRecordTypeDXILStepVoid &&
       RecordType != DebugShaderModifierRecordTypeDXILStepTerminator) {
     addDebugEntryValue(BC, V);
-
-    IRBuilder<> &B = BC.Builder;
-
-    Value *VO = BC.HlslOP->GetU32Const(ValueOrdinal << 16);
-    Value *VOI = B.CreateAnd(ValueOrdinalIndex, BC.HlslOP->GetU32Const(0xFFFF),
-                             "ValueOrdinalIndex");
-    Value *EncodedValueOrdinalAndIndex =
-        BC.Builder.CreateOr(VO, VOI, "ValueOrdinal");
-    addDebugEntryValue(BC, EncodedValueOrdinalAndIndex);
+    addDebugEntryValue(BC,
+                       encodeValueOrdinal(BC, ValueOrdinal, ValueOrdinalIndex));
   }
 }
 
@@ -871,7 +1112,7 @@ void DxilDebugInstrumentation::addStoreStepDebugEntry(BuilderContext &BC,
   }
 
   addStepDebugEntryValue(BC, InstNum, Inst->getValueOperand(), ValueOrdinalBase,
-                         ValueOrdinalIndex);
+                         ValueOrdinalIndex, /*ValueOrdinalIsInstReg*/ false);
 }
 
 void DxilDebugInstrumentation::addStepDebugEntry(BuilderContext &BC,
@@ -897,45 +1138,51 @@ void DxilDebugInstrumentation::addStepDebugEntry(BuilderContext &BC,
   if (!pix_dxil::PixDxilReg::FromInst(Inst, &RegNum)) {
     if (Inst->getOpcode() == Instruction::Ret)
       addStepEntryForType<void>(DebugShaderModifierRecordTypeDXILStepTerminator,
-                                BC, InstNum, nullptr, 0, 0);
+                                BC, InstNum, nullptr, 0, 0, true);
     return;
   }
-  addStepDebugEntryValue(BC, InstNum, Inst, RegNum, BC.Builder.getInt32(0));
+  addStepDebugEntryValue(BC, InstNum, Inst, RegNum, BC.Builder.getInt32(0),
+                         /*ValueOrdinalIsInstReg*/ true);
 }
 
 void DxilDebugInstrumentation::addStepDebugEntryValue(
     BuilderContext &BC, std::uint32_t InstNum, Value *V,
-    std::uint32_t ValueOrdinal, Value *ValueOrdinalIndex) {
+    std::uint32_t ValueOrdinal, Value *ValueOrdinalIndex,
+    bool ValueOrdinalIsInstReg) {
   const Type::TypeID ID = V->getType()->getTypeID();
 
   switch (ID) {
   case Type::TypeID::StructTyID:
   case Type::TypeID::VoidTyID:
     addStepEntryForType<void>(DebugShaderModifierRecordTypeDXILStepVoid, BC,
-                              InstNum, V, ValueOrdinal, ValueOrdinalIndex);
+                              InstNum, V, ValueOrdinal, ValueOrdinalIndex,
+                              ValueOrdinalIsInstReg);
     break;
   case Type::TypeID::FloatTyID:
     addStepEntryForType<float>(DebugShaderModifierRecordTypeDXILStepFloat, BC,
-                               InstNum, V, ValueOrdinal, ValueOrdinalIndex);
+                               InstNum, V, ValueOrdinal, ValueOrdinalIndex,
+                               ValueOrdinalIsInstReg);
     break;
   case Type::TypeID::IntegerTyID:
     if (V->getType()->getIntegerBitWidth() == 64) {
       addStepEntryForType<uint64_t>(DebugShaderModifierRecordTypeDXILStepUint64,
                                     BC, InstNum, V, ValueOrdinal,
-                                    ValueOrdinalIndex);
+                                    ValueOrdinalIndex, ValueOrdinalIsInstReg);
     } else {
       addStepEntryForType<uint32_t>(DebugShaderModifierRecordTypeDXILStepUint32,
                                     BC, InstNum, V, ValueOrdinal,
-                                    ValueOrdinalIndex);
+                                    ValueOrdinalIndex, ValueOrdinalIsInstReg);
     }
     break;
   case Type::TypeID::DoubleTyID:
     addStepEntryForType<double>(DebugShaderModifierRecordTypeDXILStepDouble, BC,
-                                InstNum, V, ValueOrdinal, ValueOrdinalIndex);
+                                InstNum, V, ValueOrdinal, ValueOrdinalIndex,
+                                ValueOrdinalIsInstReg);
     break;
   case Type::TypeID::HalfTyID:
     addStepEntryForType<float>(DebugShaderModifierRecordTypeDXILStepFloat, BC,
-                               InstNum, V, ValueOrdinal, ValueOrdinalIndex);
+                               InstNum, V, ValueOrdinal, ValueOrdinalIndex,
+                               ValueOrdinalIsInstReg);
     break;
   case Type::TypeID::PointerTyID:
     // Skip pointer calculation instructions. They aren't particularly
@@ -1005,8 +1252,11 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
     return false;
   }
 
-  // First record pointers to all instructions in the function:
+  // First record pointers to all instructions in the function, and the first
+  // of them in each block:
   std::vector<Instruction *> AllInstructions;
+  SmallPtrSet<Instruction *, 16> BlockStarts;
+  BasicBlock *PreviousBlock = nullptr;
   for (inst_iterator I = inst_begin(entryFunction), E = inst_end(entryFunction);
        I != E; ++I) {
     std::uint32_t InstructionNumber;
@@ -1015,9 +1265,20 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
           InstructionNumber >= m_LastInstruction)
         continue;
       AllInstructions.push_back(&*I);
+      if (I->getParent() != PreviousBlock) {
+        BlockStarts.insert(&*I);
+        PreviousBlock = I->getParent();
+      }
     }
   }
 
+  // The wave aggregated counter splits blocks, so the blocks whose phis are
+  // instrumented are gathered up front.
+  std::vector<BasicBlock *> OriginalBlocks;
+  for (BasicBlock &BB : *entryFunction)
+    OriginalBlocks.push_back(&BB);
+  m_PreviousStepInstNum = -1;
+
   // Branchless instrumentation requires taking care of a few things:
   // -Each invocation of the shader will be either of interest or not of
   // interest
@@ -1063,6 +1324,8 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
                                                "PIX_DebugUAV_Handle");
   values.CounterOffset = BC.HlslOP->GetU32Const(UAVDumpingGroundOffset() +
                                                 CounterOffsetBeyondUsefulData);
+  if (m_WaveAggregatedCounter)
+    DM.m_ShaderFlags.SetWaveOps(true);
 
   auto SystemValues = addRequiredSystemValues(BC, shaderKind);
   addInvocationSelectionProlog(BC, SystemValues, shaderKind);
@@ -1072,8 +1335,8 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
   // purposes
   int NewBlockCounter = 0;
 
-  auto &Blocks = entryFunction->getBasicBlockList();
-  for (auto &CurrentBlock : Blocks) {
+  for (BasicBlock *CurrentBlockPtr : OriginalBlocks) {
+    BasicBlock &CurrentBlock = *CurrentBlockPtr;
     struct ValueAndPhi {
       Value *Val;
       PHINode *Phi;
@@ -1098,7 +1361,8 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
       auto *NewBlock = BasicBlock::Create(
           Ctx, "PIXDebug" + std::to_string(NewBlockCounter++),
           InsertableEdge.first->getParent());
-      IRBuilder<> Builder(NewBlock);
+      // Add a branch to the new block to point to the current block
+      IRBuilder<> Builder(BranchInst::Create(&CurrentBlock, NewBlock));
 
       auto *PreviousBlock = InsertableEdge.first;
 
@@ -1114,11 +1378,13 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
         }
       }
 
-      // Modify the Phis and add debug instrumentation
-      for (auto &ValueNPhi : InsertableEdge.second) {
-        // Modify the phi to refer to the new block:
+      // Modify the phis to refer to the new block:
+      for (auto &ValueNPhi : InsertableEdge.second)
         ValueNPhi.Phi->setIncomingBlock(ValueNPhi.Index, NewBlock);
 
+      // Add debug instrumentation
+      m_PreviousStepInstNum = -1;
+      for (auto &ValueNPhi : InsertableEdge.second) {
         // Add instrumentation to the new block
         std::uint32_t RegNum;
         if (!pix_dxil::PixDxilReg::FromInst(ValueNPhi.Phi, &RegNum)) {
@@ -1134,16 +1400,16 @@ bool DxilDebugInstrumentation::RunOnFunction(Module &M, DxilModule &DM,
 
         BuilderContext BC{M, DM, Ctx, HlslOP, Builder};
         addStepDebugEntryValue(BC, InstNum, ValueNPhi.Val, RegNum,
-                               BC.Builder.getInt32(0));
+                               BC.Builder.getInt32(0),
+                               /*ValueOrdinalIsInstReg*/ true);
       }
-
-      // Add a branch to the new block to point to the current block
-      Builder.CreateBr(&CurrentBlock);
     }
   }
 
   // Instrument original instructions:
   for (auto &Inst : AllInstructions) {
+    if (BlockStarts.count(Inst))
+      m_PreviousStepInstNum = -1;
     // Instrumentation goes after the instruction if it is not a terminator.
     // Otherwise, Instrumentation goes prior to the instruction.
     if (!Inst->isTerminator()) {
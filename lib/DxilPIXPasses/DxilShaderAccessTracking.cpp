@@ -218,6 +218,8 @@ public:
 private:
   void EmitAccess(LLVMContext &Ctx, OP *HlslOP, IRBuilder<> &, Value *slot,
                   ShaderAccessFlags access);
+  void BeginWaveAggregatedStore(LLVMContext &Ctx, OP *HlslOP, IRBuilder<> &,
+                                Value *ByteOffset);
   bool EmitResourceAccess(DxilModule &DM, DxilResourceAndClass &res,
                           Instruction *instruction, OP *HlslOP,
                           LLVMContext &Ctx, ShaderAccessFlags readWrite);
@@ -236,6 +238,7 @@ private:
 
   std::vector<DynamicResourceBinding> m_dynamicResourceBindings;
   bool m_CheckForDynamicIndexing = false;
+  bool m_WaveAggregate = false;
   int m_DynamicResourceDataOffset = -1;
   int m_DynamicSamplerDataOffset = -1;
   int m_OutputBufferSize = -1;
@@ -308,6 +311,7 @@ void DxilShaderAccessTracking::applyOptions(PassOptions O) {
   int checkForDynamic;
   GetPassOptionInt(O, "checkForDynamicIndexing", &checkForDynamic, 0);
   m_CheckForDynamicIndexing = checkForDynamic != 0;
+  GetPassOptionBool(O, "waveAggregate", &m_WaveAggregate, false);
 
   StringRef configOption;
   if (GetPassOption(O, "config", &configOption)) {
@@ -361,6 +365,8 @@ void DxilShaderAccessTracking::EmitAccess(LLVMContext &Ctx, OP *HlslOP,
   Constant *LiteralOne = HlslOP->GetU32Const(1);
   Constant *ElementMask = HlslOP->GetI8Const(1);
 
+  BeginWaveAggregatedStore(Ctx, HlslOP, Builder, OffsetByteIndex);
+
   Function *StoreFunc =
       HlslOP->GetOpFunc(OP::OpCode::BufferStore, Type::getInt32Ty(Ctx));
   Constant *StoreOpcode =
@@ -382,6 +388,51 @@ void DxilShaderAccessTracking::EmitAccess(LLVMContext &Ctx, OP *HlslOP,
       });
 }
 
+// The value stored for an access only depends on the offset it is stored to,
+// so with wave aggregation only one lane of the wave writes each distinct
+// record: the first lane writes the record it shares with every lane whose
+// offset is the same, and lanes with some other offset write their own. When
+// the offset is known to be uniform only the first lane is left. Splits the
+// block at the insertion point and leaves the builder in a new block that
+// only the storing lanes branch to.
+void DxilShaderAccessTracking::BeginWaveAggregatedStore(LLVMContext &Ctx,
+                                                        OP *HlslOP,
+                                                        IRBuilder<> &Builder,
+                                                        Value *ByteOffset) {
+  if (!m_WaveAggregate)
+    return;
+
+  Function *IsFirstLaneFunc =
+      HlslOP->GetOpFunc(DXIL::OpCode::WaveIsFirstLane, Type::getVoidTy(Ctx));
+  Value *ShouldStore = Builder.CreateCall(
+      IsFirstLaneFunc,
+      {HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveIsFirstLane)},
+      "IsFirstLane");
+  if (!isa<Constant>(ByteOffset)) {
+    Function *ReadLaneFirstFunc = HlslOP->GetOpFunc(
+        DXIL::OpCode::WaveReadLaneFirst, Type::getInt32Ty(Ctx));
+    auto FirstByteOffset = Builder.CreateCall(
+        ReadLaneFirstFunc,
+        {HlslOP->GetU32Const((unsigned)DXIL::OpCode::WaveReadLaneFirst),
+         ByteOffset},
+        "WaveFirstByteOffset");
+    auto DiffersFromFirstLane = Builder.CreateICmpNE(
+        ByteOffset, FirstByteOffset, "DiffersFromFirstLane");
+    ShouldStore =
+        Builder.CreateOr(ShouldStore, DiffersFromFirstLane, "ShouldStore");
+  }
+
+  Instruction *SplitBefore = &*Builder.GetInsertPoint();
+  BasicBlock *Head = SplitBefore->getParent();
+  BasicBlock *Tail =
+      Head->splitBasicBlock(SplitBefore, "PIXAccessTrackingTail");
+  BasicBlock *StoreBlock = BasicBlock::Create(Ctx, "PIXAccessTrackingStore",
+                                              Head->getParent(), Tail);
+  Head->getTerminator()->eraseFromParent();
+  BranchInst::Create(StoreBlock, Tail, ShouldStore, Head);
+  Builder.SetInsertPoint(BranchInst::Create(Tail, StoreBlock));
+}
+
 static ResourceAccessStyle
 AccessStyleFromAccessAndType(AccessStyle accessStyle, RegisterType registerType,
                              ShaderAccessFlags readWrite) {
@@ -554,6 +605,8 @@ bool DxilShaderAccessTracking::EmitResourceAccess(DxilModule &DM,
       auto *CombinedFlagOrInstructionValue =
           Builder.CreateAdd(MultipliedEncodedFlags, MultipliedOutOfBoundsValue);
 
+      BeginWaveAggregatedStore(Ctx, HlslOP, Builder, Offset);
+
       Constant *ElementMask = HlslOP->GetI8Const(1);
       Function *StoreFunc =
           HlslOP->GetOpFunc(OP::OpCode::BufferStore, Type::getInt32Ty(Ctx));
@@ -935,6 +988,9 @@ bool DxilShaderAccessTracking::runOnModule(Module &M) {
       }
     }
     DM.ReEmitDxilResources();
+    if (m_WaveAggregate) {
+      DM.m_ShaderFlags.SetWaveOps(true);
+    }
 
     for (llvm::Function &F : M.functions()) {
       if (!F.isDeclaration() || F.isIntrinsic() || !OP::IsDxilOpFunc(&F))
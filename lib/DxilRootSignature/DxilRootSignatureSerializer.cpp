@@ -288,6 +288,31 @@ void SerializeRootSignatureTemplate(const T_ROOT_SIGNATURE_DESC *pRootSignature,
   bytes.Detach(); // Ownership transfered to ppBlob.
 }
 
+static void SerializeVersionedRootSignature(
+    const DxilVersionedRootSignatureDesc *pRootSignature, IDxcBlob **ppBlob,
+    DiagnosticPrinter &DiagPrinter, bool bAllowReservedRegisterSpace) {
+  switch (pRootSignature->Version) {
+  case DxilRootSignatureVersion::Version_1_0:
+    SerializeRootSignatureTemplate<DxilRootSignatureDesc, DxilRootParameter,
+                                   DxilRootDescriptor,
+                                   DxilContainerDescriptorRange>(
+        &pRootSignature->Desc_1_0, DxilRootSignatureVersion::Version_1_0,
+        ppBlob, DiagPrinter, bAllowReservedRegisterSpace);
+    break;
+
+  case DxilRootSignatureVersion::Version_1_1:
+  default:
+    DXASSERT(pRootSignature->Version == DxilRootSignatureVersion::Version_1_1,
+             "else VerifyRootSignature didn't validate");
+    SerializeRootSignatureTemplate<DxilRootSignatureDesc1, DxilRootParameter1,
+                                   DxilContainerRootDescriptor1,
+                                   DxilContainerDescriptorRange1>(
+        &pRootSignature->Desc_1_1, DxilRootSignatureVersion::Version_1_1,
+        ppBlob, DiagPrinter, bAllowReservedRegisterSpace);
+    break;
+  }
+}
+
 void SerializeRootSignature(
     const DxilVersionedRootSignatureDesc *pRootSignature, IDxcBlob **ppBlob,
     IDxcBlobEncoding **ppErrorBlob, bool bAllowReservedRegisterSpace) {
@@ -303,6 +328,41 @@ void SerializeRootSignature(
   raw_string_ostream DiagStream(DiagString);
   DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
 
+  // Root signatures that were verified before are found in the verified root
+  // signature cache by their serialized form, so serialize first and verify
+  // the result. If the description cannot be serialized or read back, verify
+  // the description itself, which reports why.
+  if (pRootSignature->Version == DxilRootSignatureVersion::Version_1_0 ||
+      pRootSignature->Version == DxilRootSignatureVersion::Version_1_1) {
+    CComPtr<IDxcBlob> pSerialized;
+    bool bVerified = false;
+    try {
+      string IgnoredDiag;
+      raw_string_ostream IgnoredStream(IgnoredDiag);
+      DiagnosticPrinterRawOStream IgnoredPrinter(IgnoredStream);
+      SerializeVersionedRootSignature(pRootSignature, &pSerialized,
+                                      IgnoredPrinter,
+                                      bAllowReservedRegisterSpace);
+      bVerified = VerifySerializedRootSignature(
+          pSerialized->GetBufferPointer(), pSerialized->GetBufferSize(),
+          DiagStream, bAllowReservedRegisterSpace);
+    } catch (...) {
+      pSerialized.Release();
+    }
+    if (pSerialized) {
+      if (bVerified) {
+        *ppBlob = pSerialized.Detach();
+        return;
+      }
+      DiagStream.flush();
+      DxcCreateBlobWithEncodingOnHeapCopy(DiagString.c_str(), DiagString.size(),
+                                          CP_UTF8, ppErrorBlob);
+      return;
+    }
+    DiagStream.flush();
+    DiagString.clear();
+  }
+
   // Verify root signature.
   if (!VerifyRootSignature(pRootSignature, DiagStream,
                            bAllowReservedRegisterSpace)) {
@@ -313,26 +373,8 @@ void SerializeRootSignature(
   }
 
   try {
-    switch (pRootSignature->Version) {
-    case DxilRootSignatureVersion::Version_1_0:
-      SerializeRootSignatureTemplate<DxilRootSignatureDesc, DxilRootParameter,
-                                     DxilRootDescriptor,
-                                     DxilContainerDescriptorRange>(
-          &pRootSignature->Desc_1_0, DxilRootSignatureVersion::Version_1_0,
-          ppBlob, DiagPrinter, bAllowReservedRegisterSpace);
-      break;
-
-    case DxilRootSignatureVersion::Version_1_1:
-    default:
-      DXASSERT(pRootSignature->Version == DxilRootSignatureVersion::Version_1_1,
-               "else VerifyRootSignature didn't validate");
-      SerializeRootSignatureTemplate<DxilRootSignatureDesc1, DxilRootParameter1,
-                                     DxilContainerRootDescriptor1,
-                                     DxilContainerDescriptorRange1>(
-          &pRootSignature->Desc_1_1, DxilRootSignatureVersion::Version_1_1,
-          ppBlob, DiagPrinter, bAllowReservedRegisterSpace);
-      break;
-    }
+    SerializeVersionedRootSignature(pRootSignature, ppBlob, DiagPrinter,
+                                    bAllowReservedRegisterSpace);
   } catch (...) {
     DiagStream.flush();
     DxcCreateBlobWithEncodingOnHeapCopy(DiagString.c_str(), DiagString.size(),
@@ -17,11 +17,15 @@
 #include "dxc/Support/WinIncludes.h"
 #include "dxc/dxcapi.h"
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/IR/DiagnosticPrinter.h"
+#include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
 #include <ios>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <utility>
@@ -47,7 +51,7 @@ private:
   std::set<T> m_set;
 
 public:
-  const T *FindIntersectingInterval(const T &I) {
+  const T *FindIntersectingInterval(const T &I) const {
     auto it = m_set.find(I);
     if (it != m_set.end())
       return &*it;
@@ -90,8 +94,10 @@ public:
   void VerifyRootSignature(const DxilVersionedRootSignatureDesc *pRootSignature,
                            DiagnosticPrinter &DiagPrinter);
 
+  // Only reads the accumulated state, so a verified root signature can be
+  // shared between threads checking different shaders.
   void VerifyShader(DxilShaderVisibility VisType, const void *pPSVData,
-                    uint32_t PSVSize, DiagnosticPrinter &DiagPrinter);
+                    uint32_t PSVSize, DiagnosticPrinter &DiagPrinter) const;
 
   typedef enum NODE_TYPE {
     DESCRIPTOR_TABLE_ENTRY,
@@ -146,12 +152,16 @@ private:
   const RegisterRange *FindCoveringInterval(DxilDescriptorRangeType RangeType,
                                             DxilShaderVisibility VisType,
                                             unsigned Num, unsigned LB,
-                                            unsigned Space);
+                                            unsigned Space) const;
 
   RegisterRanges &GetRanges(DxilShaderVisibility VisType,
                             DxilDescriptorRangeType DescType) {
     return RangeKinds[(unsigned)VisType][(unsigned)DescType];
   }
+  const RegisterRanges &GetRanges(DxilShaderVisibility VisType,
+                                  DxilDescriptorRangeType DescType) const {
+    return RangeKinds[(unsigned)VisType][(unsigned)DescType];
+  }
 
   RegisterRanges RangeKinds[kMaxVisType + 1][kMaxDescType + 1];
   bool m_bAllowReservedRegisterSpace;
@@ -396,7 +406,7 @@ const RootSignatureVerifier::RegisterRange *
 RootSignatureVerifier::FindCoveringInterval(DxilDescriptorRangeType RangeType,
                                             DxilShaderVisibility VisType,
                                             unsigned Num, unsigned LB,
-                                            unsigned Space) {
+                                            unsigned Space) const {
   RegisterRange RR;
   RR.space = Space;
   RR.lb = LB;
@@ -622,7 +632,7 @@ void RootSignatureVerifier::VerifyRootSignature(
 
 void RootSignatureVerifier::VerifyShader(DxilShaderVisibility VisType,
                                          const void *pPSVData, uint32_t PSVSize,
-                                         DiagnosticPrinter &DiagPrinter) {
+                                         DiagnosticPrinter &DiagPrinter) const {
   DxilPipelineStateValidation PSV;
   IFTBOOL(PSV.InitFromPSV0(pPSVData, PSVSize), E_INVALIDARG);
 
@@ -955,4 +965,101 @@ bool VerifyRootSignature(const DxilVersionedRootSignatureDesc *pDesc,
   return true;
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Verified root signature cache.
+//
+// The same root signature is usually shared by many shaders, so the verifier
+// state built from a serialized root signature that passed verification is
+// kept, keyed by the serialized bytes. Checking another shader against it is
+// then a lookup plus the read-only VerifyShader, without deserializing,
+// up-converting or rebuilding the register ranges.
+
+namespace {
+class VerifiedRootSignatureCache {
+  static const unsigned kMaxEntries = 256;
+  std::mutex m_Mutex;
+  // Indexed by whether reserved register spaces are allowed.
+  llvm::StringMap<std::shared_ptr<const RootSignatureVerifier>> m_Entries[2];
+
+public:
+  std::shared_ptr<const RootSignatureVerifier>
+  Lookup(StringRef Serialized, bool bAllowReservedRegisterSpace) {
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    auto &Entries = m_Entries[bAllowReservedRegisterSpace];
+    auto It = Entries.find(Serialized);
+    if (It == Entries.end())
+      return nullptr;
+    return It->second;
+  }
+
+  std::shared_ptr<const RootSignatureVerifier>
+  Insert(StringRef Serialized, bool bAllowReservedRegisterSpace,
+         std::shared_ptr<const RootSignatureVerifier> Verifier) {
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    auto &Entries = m_Entries[bAllowReservedRegisterSpace];
+    if (Entries.size() >= kMaxEntries && !Entries.count(Serialized))
+      Entries.clear();
+    // Keep the first entry if another thread verified it concurrently.
+    return Entries.insert(std::make_pair(Serialized, std::move(Verifier)))
+        .first->second;
+  }
+};
+} // namespace
+
+static llvm::ManagedStatic<VerifiedRootSignatureCache> VerifiedRootSignatures;
+
+// Returns the verifier for a serialized root signature, or null with the
+// problems written to DiagStream if it fails verification. Deserialization
+// errors are thrown.
+static std::shared_ptr<const RootSignatureVerifier>
+GetVerifiedRootSignature(const void *pRSData, uint32_t RSSize,
+                         bool bAllowReservedRegisterSpace,
+                         llvm::raw_ostream &DiagStream) {
+  StringRef Serialized((const char *)pRSData, RSSize);
+  if (auto Cached = VerifiedRootSignatures->Lookup(
+          Serialized, bAllowReservedRegisterSpace))
+    return Cached;
+
+  DxilVersionedRootSignature Desc;
+  DeserializeRootSignature(pRSData, RSSize, Desc.get_address_of());
+  IFTBOOL(Desc.get(), E_INVALIDARG);
+
+  auto Verifier = std::make_shared<RootSignatureVerifier>();
+  try {
+    Verifier->AllowReservedRegisterSpace(bAllowReservedRegisterSpace);
+    DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
+    Verifier->VerifyRootSignature(Desc.get(), DiagPrinter);
+  } catch (...) {
+    return nullptr;
+  }
+  return VerifiedRootSignatures->Insert(Serialized,
+                                        bAllowReservedRegisterSpace,
+                                        std::move(Verifier));
+}
+
+bool VerifySerializedRootSignatureWithShaderPSV(
+    const void *pRSData, uint32_t RSSize, DXIL::ShaderKind ShaderKind,
+    const void *pPSVData, uint32_t PSVSize, llvm::raw_ostream &DiagStream) {
+  std::shared_ptr<const RootSignatureVerifier> RSV =
+      GetVerifiedRootSignature(pRSData, RSSize, false, DiagStream);
+  if (!RSV)
+    return false;
+  try {
+    DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
+    RSV->VerifyShader(GetVisibilityType(ShaderKind), pPSVData, PSVSize,
+                      DiagPrinter);
+  } catch (...) {
+    return false;
+  }
+
+  return true;
+}
+
+bool VerifySerializedRootSignature(const void *pRSData, uint32_t RSSize,
+                                   llvm::raw_ostream &DiagStream,
+                                   bool bAllowReservedRegisterSpace) {
+  return GetVerifiedRootSignature(pRSData, RSSize, bAllowReservedRegisterSpace,
+                                  DiagStream) != nullptr;
+}
+
 } // namespace hlsl
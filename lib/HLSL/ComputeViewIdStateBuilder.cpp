@@ -15,6 +15,7 @@
 #include "dxc/HlslIntrinsicOp.h"
 #include "dxc/Support/Global.h"
 
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/CallGraph.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
@@ -26,6 +27,7 @@
 #include "llvm/Support/Debug.h"
 
 #include <algorithm>
+#include <climits>
 
 using namespace llvm;
 using namespace llvm::legacy;
@@ -68,7 +70,10 @@ public:
         m_PCInputsContributingToOutputs(state.m_PCInputsContributingToOutputs),
         m_bUsesViewId(state.m_bUsesViewId) {}
 
-  void Compute();
+  // Computes the signature sizes, dynamic index masks and, if
+  // bComputeDependences is set, the ViewID and input-to-output dependence
+  // tables.
+  void Compute(bool bComputeDependences = true);
 
 private:
   static const unsigned kNumStreams = 4;
@@ -99,6 +104,22 @@ private:
   DynamicallyIndexedElemsType m_OutSigDynIdxElems;
   DynamicallyIndexedElemsType m_PCSigDynIdxElems;
 
+  // Signature scalars contributing to a value. Which signature Inputs refers
+  // to depends on the shader kind: the input signature, which includes the
+  // control points read by a DS. PCInputs are the patch constants read by a
+  // DS, OutputCPs the control-point outputs read by an HS patch-constant
+  // function.
+  using SigScalarSetType = std::bitset<kMaxSigScalars>;
+  struct ContributionSet {
+    SigScalarSetType Inputs;
+    SigScalarSetType PCInputs;
+    SigScalarSetType OutputCPs;
+    bool bViewId = false;
+
+    // Returns true if this set changed.
+    bool Merge(const ContributionSet &Other);
+  };
+
   // Information per entry point.
   using FunctionSetType = std::unordered_set<llvm::Function *>;
   using InstructionSetType = std::unordered_set<llvm::Instruction *>;
@@ -108,9 +129,8 @@ private:
     FunctionSetType Functions;
     // Outputs to analyze.
     InstructionSetType Outputs;
-    // Contributing instructions per output.
-    std::unordered_map<unsigned, InstructionSetType>
-        ContributingInstructions[kNumStreams];
+    // Contributions per output.
+    std::unordered_map<unsigned, ContributionSet> Contributions[kNumStreams];
 
     void Clear();
   };
@@ -142,13 +162,18 @@ private:
                                     llvm::CallGraphNode *pNode,
                                     FunctionSetType &FuncSet);
   void AnalyzeFunctions(EntryInfo &Entry);
+  void AnalyzeControlFlow(EntryInfo &Entry);
   void CollectValuesContributingToOutputs(EntryInfo &Entry);
-  void CollectValuesContributingToOutputRec(
-      EntryInfo &Entry, llvm::Value *pContributingValue,
-      InstructionSetType &ContributingInstructions);
-  void CollectPhiCFValuesContributingToOutputRec(
-      llvm::PHINode *pPhi, EntryInfo &Entry,
-      InstructionSetType &ContributingInstructions);
+  void CollectDependences(EntryInfo &Entry, llvm::Instruction *pInst,
+                          llvm::SmallVectorImpl<llvm::Value *> &Deps);
+  void CollectCtrlDependences(llvm::BasicBlock *pBB,
+                              llvm::SmallVectorImpl<llvm::Value *> &Deps);
+  void CollectPhiCFDependences(llvm::PHINode *pPhi,
+                               llvm::SmallVectorImpl<llvm::Value *> &Deps);
+  void GetInstructionContribution(llvm::Instruction *pInst,
+                                  ContributionSet &Contribution) const;
+  void AddSigScalars(SigScalarSetType &Set, DxilSignatureElement &SigElem,
+                     int row, unsigned col) const;
   const ValueSetType &CollectReachingDecls(llvm::Value *pValue);
   void CollectReachingDeclsRec(llvm::Value *pValue, ValueSetType &ReachingDecls,
                                ValueSetType &Visited);
@@ -157,8 +182,8 @@ private:
                         ValueSetType &Visited);
   void UpdateDynamicIndexUsageState() const;
   void
-  CreateViewIdSets(const std::unordered_map<unsigned, InstructionSetType>
-                       &ContributingInstructions,
+  CreateViewIdSets(const std::unordered_map<unsigned, ContributionSet>
+                       &Contributions,
                    OutputsDependentOnViewIdType &OutputsDependentOnViewId,
                    InputsContributingToOutputType &InputsContributingToOutputs,
                    bool bPC);
@@ -170,7 +195,7 @@ private:
 };
 } // namespace
 
-void DxilViewIdStateBuilder::Compute() {
+void DxilViewIdStateBuilder::Compute(bool bComputeDependences) {
   Clear();
 
   const ShaderModel *pSM = m_pModule->GetShaderModel();
@@ -204,29 +229,39 @@ void DxilViewIdStateBuilder::Compute() {
     AnalyzeFunctions(m_PCEntry);
   }
 
-  // 4. Collect sets of values contributing to outputs.
-  CollectValuesContributingToOutputs(m_Entry);
-  if (m_PCEntry.pEntryFunc) {
-    CollectValuesContributingToOutputs(m_PCEntry);
-  }
+  // Without stored outputs all dependence tables are empty, so there is no
+  // need to build dominator trees and control dependence either.
+  if (bComputeDependences &&
+      (!m_Entry.Outputs.empty() || !m_PCEntry.Outputs.empty())) {
+    // 4. Compute control dependence and collect values contributing to
+    // outputs.
+    AnalyzeControlFlow(m_Entry);
+    if (m_PCEntry.pEntryFunc) {
+      AnalyzeControlFlow(m_PCEntry);
+    }
+    CollectValuesContributingToOutputs(m_Entry);
+    if (m_PCEntry.pEntryFunc) {
+      CollectValuesContributingToOutputs(m_PCEntry);
+    }
 
-  // 5. Construct dependency sets.
-  for (unsigned StreamId = 0; StreamId < (pSM->IsGS() ? kNumStreams : 1u);
-       StreamId++) {
-    CreateViewIdSets(m_Entry.ContributingInstructions[StreamId],
-                     m_OutputsDependentOnViewId[StreamId],
-                     m_InputsContributingToOutputs[StreamId], false);
-  }
-  if (pSM->IsHS() || pSM->IsMS()) {
-    CreateViewIdSets(m_PCEntry.ContributingInstructions[0],
-                     m_PCOrPrimOutputsDependentOnViewId,
-                     m_InputsContributingToPCOrPrimOutputs, true);
-  } else if (pSM->IsDS()) {
-    OutputsDependentOnViewIdType OutputsDependentOnViewId;
-    CreateViewIdSets(m_Entry.ContributingInstructions[0],
-                     OutputsDependentOnViewId, m_PCInputsContributingToOutputs,
-                     true);
-    DXASSERT_NOMSG(OutputsDependentOnViewId == m_OutputsDependentOnViewId[0]);
+    // 5. Construct dependency sets.
+    for (unsigned StreamId = 0; StreamId < (pSM->IsGS() ? kNumStreams : 1u);
+         StreamId++) {
+      CreateViewIdSets(m_Entry.Contributions[StreamId],
+                       m_OutputsDependentOnViewId[StreamId],
+                       m_InputsContributingToOutputs[StreamId], false);
+    }
+    if (pSM->IsHS() || pSM->IsMS()) {
+      CreateViewIdSets(m_PCEntry.Contributions[0],
+                       m_PCOrPrimOutputsDependentOnViewId,
+                       m_InputsContributingToPCOrPrimOutputs, true);
+    } else if (pSM->IsDS()) {
+      OutputsDependentOnViewIdType OutputsDependentOnViewId;
+      CreateViewIdSets(m_Entry.Contributions[0], OutputsDependentOnViewId,
+                       m_PCInputsContributingToOutputs, true);
+      DXASSERT_NOMSG(OutputsDependentOnViewId ==
+                     m_OutputsDependentOnViewId[0]);
+    }
   }
 
   // 6. Update dynamically indexed input/output component masks.
@@ -263,7 +298,23 @@ void DxilViewIdStateBuilder::EntryInfo::Clear() {
   Functions.clear();
   Outputs.clear();
   for (unsigned i = 0; i < kNumStreams; i++)
-    ContributingInstructions[i].clear();
+    Contributions[i].clear();
+}
+
+bool DxilViewIdStateBuilder::ContributionSet::Merge(
+    const ContributionSet &Other) {
+  SigScalarSetType NewInputs = Inputs | Other.Inputs;
+  SigScalarSetType NewPCInputs = PCInputs | Other.PCInputs;
+  SigScalarSetType NewOutputCPs = OutputCPs | Other.OutputCPs;
+  bool bNewViewId = bViewId || Other.bViewId;
+  if (NewInputs == Inputs && NewPCInputs == PCInputs &&
+      NewOutputCPs == OutputCPs && bNewViewId == bViewId)
+    return false;
+  Inputs = NewInputs;
+  PCInputs = NewPCInputs;
+  OutputCPs = NewOutputCPs;
+  bViewId = bNewViewId;
+  return true;
 }
 
 void DxilViewIdStateBuilder::FuncInfo::Clear() {
@@ -431,6 +482,16 @@ void DxilViewIdStateBuilder::AnalyzeFunctions(EntryInfo &Entry) {
         }
       }
     }
+  }
+}
+
+void DxilViewIdStateBuilder::AnalyzeControlFlow(EntryInfo &Entry) {
+  for (auto *F : Entry.Functions) {
+    FuncInfo *pFuncInfo = m_FuncInfo[F].get();
+    // Functions shared by the HS main and patch-constant entries are only
+    // analyzed once.
+    if (pFuncInfo->pDomTree)
+      continue;
 
     // Compute dominator relation.
     pFuncInfo->pDomTree = make_unique<DominatorTreeBase<BasicBlock>>(false);
@@ -453,8 +514,56 @@ void DxilViewIdStateBuilder::AnalyzeFunctions(EntryInfo &Entry) {
   }
 }
 
+// Contributions are computed by a dataflow over the instructions that outputs
+// depend on, so that each instruction is visited once per entry instead of
+// once per output it reaches. Every instruction starts with the signature
+// scalars and ViewID it reads directly, and its set is merged into its users
+// until nothing changes; the contribution of an output is then the union of
+// the sets of its value and control dependences.
 void DxilViewIdStateBuilder::CollectValuesContributingToOutputs(
     EntryInfo &Entry) {
+  std::unordered_map<Instruction *, unsigned> NodeIndex;
+  vector<Instruction *> Nodes;
+  // Users[i] are the nodes that depend on node i.
+  vector<SmallVector<unsigned, 4>> Users;
+  SmallVector<Value *, 16> Deps;
+
+  auto GetNode = [&](Value *V) -> unsigned {
+    if (isa<Argument>(V)) {
+      // This must be a leftover signature argument of an entry function.
+      DXASSERT_NOMSG(Entry.pEntryFunc == m_pModule->GetEntryFunction() ||
+                     Entry.pEntryFunc == m_pModule->GetPatchConstantFunction());
+      return UINT_MAX;
+    }
+    Instruction *I = dyn_cast<Instruction>(V);
+    if (I == nullptr) {
+      // Can be literal constant, global decl, branch target.
+      DXASSERT_NOMSG(isa<Constant>(V) || isa<BasicBlock>(V));
+      return UINT_MAX;
+    }
+    auto it = NodeIndex.find(I);
+    if (it != NodeIndex.end())
+      return it->second;
+    DXASSERT_NOMSG(m_FuncInfo.count(I->getParent()->getParent()));
+    if (!m_FuncInfo.count(I->getParent()->getParent()))
+      return UINT_MAX;
+    NodeIndex.emplace(I, (unsigned)Nodes.size());
+    Nodes.emplace_back(I);
+    Users.emplace_back();
+    return (unsigned)Nodes.size() - 1;
+  };
+
+  // Roots of each output: its value and the terminators it is control
+  // dependent on.
+  struct OutputInfo {
+    DxilSignatureElement *pSigElem;
+    int startRow, endRow;
+    unsigned col;
+    SmallVector<unsigned, 4> Roots;
+  };
+  vector<OutputInfo> OutputInfos;
+  OutputInfos.reserve(Entry.Outputs.size());
+
   for (auto *CI : Entry.Outputs) { // CI = call instruction
     DxilSignature *pDxilSig = nullptr;
     Value *pContributingValue = nullptr;
@@ -496,8 +605,6 @@ void DxilViewIdStateBuilder::CollectValuesContributingToOutputs(
     if (!SigElem.IsAllocated())
       continue;
 
-    unsigned StreamId = SigElem.GetOutputStream();
-
     if (startRow != Semantic::kUndefinedRow) {
       endRow = startRow;
     } else {
@@ -508,119 +615,113 @@ void DxilViewIdStateBuilder::CollectValuesContributingToOutputs(
       endRow = SigElem.GetRows() - 1;
     }
 
-    InstructionSetType ContributingInstructionsAllRows;
-    InstructionSetType *pContributingInstructions =
-        &ContributingInstructionsAllRows;
-    if (startRow == endRow) {
-      // Scalar or indexable with known index.
-      unsigned index = GetLinearIndex(SigElem, startRow, col);
-      pContributingInstructions =
-          &Entry.ContributingInstructions[StreamId][index];
-    }
-
-    CollectValuesContributingToOutputRec(Entry, pContributingValue,
-                                         *pContributingInstructions);
+    OutputInfos.emplace_back();
+    OutputInfo &Out = OutputInfos.back();
+    Out.pSigElem = &SigElem;
+    Out.startRow = startRow;
+    Out.endRow = endRow;
+    Out.col = col;
 
+    Deps.clear();
+    Deps.emplace_back(pContributingValue);
     // Handle control dependence of this instruction BB.
-    BasicBlock *pBB = CI->getParent();
-    Function *F = pBB->getParent();
-    FuncInfo *pFuncInfo = m_FuncInfo[F].get();
-    const BasicBlockSet &CtrlDepSet = pFuncInfo->CtrlDep.GetCDBlocks(pBB);
-    for (BasicBlock *B : CtrlDepSet) {
-      CollectValuesContributingToOutputRec(Entry, B->getTerminator(),
-                                           *pContributingInstructions);
+    CollectCtrlDependences(CI->getParent(), Deps);
+    for (Value *V : Deps) {
+      unsigned Node = GetNode(V);
+      if (Node != UINT_MAX)
+        Out.Roots.emplace_back(Node);
     }
+  }
 
-    if (pContributingInstructions == &ContributingInstructionsAllRows) {
-      // Write dynamically indexed output contributions to all rows.
-      for (int row = startRow; row <= endRow; row++) {
-        unsigned index = GetLinearIndex(SigElem, row, col);
-        Entry.ContributingInstructions[StreamId][index].insert(
-            ContributingInstructionsAllRows.begin(),
-            ContributingInstructionsAllRows.end());
-      }
+  // Discover every instruction the roots depend on; Nodes grows as new
+  // dependences are found.
+  for (unsigned i = 0; i < Nodes.size(); i++) {
+    Deps.clear();
+    CollectDependences(Entry, Nodes[i], Deps);
+    for (Value *V : Deps) {
+      unsigned Node = GetNode(V);
+      if (Node != UINT_MAX)
+        Users[Node].emplace_back(i);
     }
   }
-}
 
-void DxilViewIdStateBuilder::CollectValuesContributingToOutputRec(
-    EntryInfo &Entry, Value *pContributingValue,
-    InstructionSetType &ContributingInstructions) {
-  if (dyn_cast<Argument>(pContributingValue)) {
-    // This must be a leftover signature argument of an entry function.
-    DXASSERT_NOMSG(Entry.pEntryFunc == m_pModule->GetEntryFunction() ||
-                   Entry.pEntryFunc == m_pModule->GetPatchConstantFunction());
-    return;
+  // Propagate contributions to users until a fixed point is reached.
+  vector<ContributionSet> Contributions(Nodes.size());
+  vector<unsigned> Worklist;
+  vector<bool> InWorklist(Nodes.size(), true);
+  Worklist.reserve(Nodes.size());
+  for (unsigned i = 0; i < Nodes.size(); i++) {
+    GetInstructionContribution(Nodes[i], Contributions[i]);
+    Worklist.emplace_back(i);
   }
-
-  Instruction *pContributingInst = dyn_cast<Instruction>(pContributingValue);
-  if (pContributingInst == nullptr) {
-    // Can be literal constant, global decl, branch target.
-    DXASSERT_NOMSG(isa<Constant>(pContributingValue) ||
-                   isa<BasicBlock>(pContributingValue));
-    return;
+  while (!Worklist.empty()) {
+    unsigned Node = Worklist.back();
+    Worklist.pop_back();
+    InWorklist[Node] = false;
+    for (unsigned User : Users[Node]) {
+      if (Contributions[User].Merge(Contributions[Node]) && !InWorklist[User]) {
+        InWorklist[User] = true;
+        Worklist.emplace_back(User);
+      }
+    }
   }
 
-  BasicBlock *pBB = pContributingInst->getParent();
-  Function *F = pBB->getParent();
-  auto FuncInfoIt = m_FuncInfo.find(F);
-  DXASSERT_NOMSG(FuncInfoIt != m_FuncInfo.end());
-  if (FuncInfoIt == m_FuncInfo.end()) {
-    return;
-  }
+  for (OutputInfo &Out : OutputInfos) {
+    ContributionSet OutContribution;
+    for (unsigned Root : Out.Roots)
+      OutContribution.Merge(Contributions[Root]);
 
-  auto itInst = ContributingInstructions.emplace(pContributingInst);
-  // Already visited instruction.
-  if (!itInst.second)
-    return;
+    // Dynamically indexed outputs contribute to all rows.
+    unsigned StreamId = Out.pSigElem->GetOutputStream();
+    for (int row = Out.startRow; row <= Out.endRow; row++) {
+      unsigned index = GetLinearIndex(*Out.pSigElem, row, Out.col);
+      Entry.Contributions[StreamId][index].Merge(OutContribution);
+    }
+  }
+}
 
+void DxilViewIdStateBuilder::CollectDependences(EntryInfo &Entry,
+                                                Instruction *pInst,
+                                                SmallVectorImpl<Value *> &Deps) {
   // Handle special cases.
-  if (PHINode *phi = dyn_cast<PHINode>(pContributingInst)) {
-    CollectPhiCFValuesContributingToOutputRec(phi, Entry,
-                                              ContributingInstructions);
-  } else if (isa<LoadInst>(pContributingInst) ||
-             isa<AtomicCmpXchgInst>(pContributingInst) ||
-             isa<AtomicRMWInst>(pContributingInst)) {
-    Value *pPtrValue = pContributingInst->getOperand(0);
+  if (PHINode *phi = dyn_cast<PHINode>(pInst)) {
+    CollectPhiCFDependences(phi, Deps);
+  } else if (isa<LoadInst>(pInst) || isa<AtomicCmpXchgInst>(pInst) ||
+             isa<AtomicRMWInst>(pInst)) {
+    Value *pPtrValue = pInst->getOperand(0);
     DXASSERT_NOMSG(pPtrValue->getType()->isPointerTy());
     const ValueSetType &ReachingDecls = CollectReachingDecls(pPtrValue);
     DXASSERT_NOMSG(ReachingDecls.size() > 0);
     for (Value *pDeclValue : ReachingDecls) {
       const ValueSetType &Stores = CollectStores(pDeclValue);
-      for (Value *V : Stores) {
-        CollectValuesContributingToOutputRec(Entry, V,
-                                             ContributingInstructions);
-      }
+      Deps.append(Stores.begin(), Stores.end());
     }
-  } else if (CallInst *CI = dyn_cast<CallInst>(pContributingInst)) {
+  } else if (CallInst *CI = dyn_cast<CallInst>(pInst)) {
     if (!hlsl::OP::IsDxilOpFuncCallInst(CI)) {
       Function *F = CI->getCalledFunction();
       if (!F->empty()) {
         // Return value of a user function.
         if (Entry.Functions.find(F) != Entry.Functions.end()) {
           const FuncInfo &FI = *m_FuncInfo[F];
-          for (ReturnInst *pRetInst : FI.Returns) {
-            CollectValuesContributingToOutputRec(Entry, pRetInst,
-                                                 ContributingInstructions);
-          }
+          Deps.append(FI.Returns.begin(), FI.Returns.end());
         }
       }
     }
   }
 
   // Handle instruction inputs.
-  unsigned NumOps = pContributingInst->getNumOperands();
-  for (unsigned i = 0; i < NumOps; i++) {
-    Value *O = pContributingInst->getOperand(i);
-    CollectValuesContributingToOutputRec(Entry, O, ContributingInstructions);
-  }
+  Deps.append(pInst->op_begin(), pInst->op_end());
 
   // Handle control dependence of this instruction BB.
-  FuncInfo *pFuncInfo = FuncInfoIt->second.get();
+  CollectCtrlDependences(pInst->getParent(), Deps);
+}
+
+void DxilViewIdStateBuilder::CollectCtrlDependences(
+    BasicBlock *pBB, SmallVectorImpl<Value *> &Deps) {
+  FuncInfo *pFuncInfo = m_FuncInfo[pBB->getParent()].get();
   const BasicBlockSet &CtrlDepSet = pFuncInfo->CtrlDep.GetCDBlocks(pBB);
   for (BasicBlock *B : CtrlDepSet) {
-    CollectValuesContributingToOutputRec(Entry, B->getTerminator(),
-                                         ContributingInstructions);
+    Deps.emplace_back(B->getTerminator());
   }
 }
 
@@ -631,9 +732,8 @@ void DxilViewIdStateBuilder::CollectValuesContributingToOutputRec(
 // point is the highest dominator where it is still legal to "insert" constant
 // assignment. In this context, "legal" means that only one value "leaves" the
 // dominator and reaches Phi.
-void DxilViewIdStateBuilder::CollectPhiCFValuesContributingToOutputRec(
-    PHINode *pPhi, EntryInfo &Entry,
-    InstructionSetType &ContributingInstructions) {
+void DxilViewIdStateBuilder::CollectPhiCFDependences(
+    PHINode *pPhi, SmallVectorImpl<Value *> &Deps) {
   Function *F = pPhi->getParent()->getParent();
   FuncInfo *pFuncInfo = m_FuncInfo[F].get();
   unordered_map<DomTreeNodeBase<BasicBlock> *, Value *> DomTreeMarkers;
@@ -709,12 +809,7 @@ void DxilViewIdStateBuilder::CollectPhiCFValuesContributingToOutputRec(
 
     // Handle control dependence of this constant argument highest legal
     // "definition" point.
-    pBB = pDefDomNode->getBlock();
-    const BasicBlockSet &CtrlDepSet = pFuncInfo->CtrlDep.GetCDBlocks(pBB);
-    for (BasicBlock *B : CtrlDepSet) {
-      CollectValuesContributingToOutputRec(Entry, B->getTerminator(),
-                                           ContributingInstructions);
-    }
+    CollectCtrlDependences(pDefDomNode->getBlock(), Deps);
   }
 }
 
@@ -826,101 +921,121 @@ void DxilViewIdStateBuilder::CollectStoresRec(llvm::Value *pValue,
   }
 }
 
+void DxilViewIdStateBuilder::GetInstructionContribution(
+    Instruction *pInst, ContributionSet &Contribution) const {
+  const ShaderModel *pSM = m_pModule->GetShaderModel();
+  CallInst *CI = dyn_cast<CallInst>(pInst);
+  if (!CI || !hlsl::OP::IsDxilOpFuncCallInst(CI))
+    return;
+
+  // Set output dependence on ViewId.
+  if (DxilInst_ViewID VID = DxilInst_ViewID(CI)) {
+    DXASSERT(m_bUsesViewId, "otherwise, DxilModule flag not set properly");
+    Contribution.bViewId = true;
+    return;
+  }
+
+  unsigned inpId = (unsigned)-1;
+  int row = Semantic::kUndefinedRow;
+  unsigned col = (unsigned)-1;
+  if (DxilInst_LoadInput LI = DxilInst_LoadInput(CI)) {
+    GetUnsignedVal(LI.get_inputSigId(), &inpId);
+    GetUnsignedVal(LI.get_colIndex(), &col);
+    GetUnsignedVal(LI.get_rowIndex(), (uint32_t *)&row);
+    AddSigScalars(Contribution.Inputs,
+                  m_pModule->GetInputSignature().GetElement(inpId), row, col);
+  } else if (DxilInst_LoadOutputControlPoint LOCP =
+                 DxilInst_LoadOutputControlPoint(CI)) {
+    GetUnsignedVal(LOCP.get_inputSigId(), &inpId);
+    GetUnsignedVal(LOCP.get_col(), &col);
+    GetUnsignedVal(LOCP.get_row(), (uint32_t *)&row);
+    if (pSM->IsHS()) {
+      AddSigScalars(Contribution.OutputCPs,
+                    m_pModule->GetOutputSignature().GetElement(inpId), row,
+                    col);
+    } else if (pSM->IsDS()) {
+      AddSigScalars(Contribution.Inputs,
+                    m_pModule->GetInputSignature().GetElement(inpId), row,
+                    col);
+    } else {
+      DXASSERT_NOMSG(false);
+    }
+  } else if (DxilInst_LoadPatchConstant LPC = DxilInst_LoadPatchConstant(CI)) {
+    if (pSM->IsDS()) {
+      GetUnsignedVal(LPC.get_inputSigId(), &inpId);
+      GetUnsignedVal(LPC.get_col(), &col);
+      GetUnsignedVal(LPC.get_row(), (uint32_t *)&row);
+      AddSigScalars(
+          Contribution.PCInputs,
+          m_pModule->GetPatchConstOrPrimSignature().GetElement(inpId), row,
+          col);
+    }
+  }
+}
+
+void DxilViewIdStateBuilder::AddSigScalars(SigScalarSetType &Set,
+                                           DxilSignatureElement &SigElem,
+                                           int row, unsigned col) const {
+  if (!SigElem.IsAllocated())
+    return;
+
+  int startRow = row, endRow = row;
+  if (row == Semantic::kUndefinedRow) {
+    // The entire column contributes to output.
+    startRow = 0;
+    endRow = SigElem.GetRows() - 1;
+  }
+  for (int r = startRow; r <= endRow; r++) {
+    Set.set(GetLinearIndex(SigElem, r, col));
+  }
+}
+
 void DxilViewIdStateBuilder::CreateViewIdSets(
-    const std::unordered_map<unsigned, InstructionSetType>
-        &ContributingInstructions,
+    const std::unordered_map<unsigned, ContributionSet> &Contributions,
     OutputsDependentOnViewIdType &OutputsDependentOnViewId,
     InputsContributingToOutputType &InputsContributingToOutputs, bool bPC) {
   const ShaderModel *pSM = m_pModule->GetShaderModel();
 
-  for (auto &itOut : ContributingInstructions) {
+  for (auto &itOut : Contributions) {
     unsigned outIdx = itOut.first;
-    for (Instruction *pInst : itOut.second) {
-      // Set output dependence on ViewId.
-      if (DxilInst_ViewID VID = DxilInst_ViewID(pInst)) {
-        DXASSERT(m_bUsesViewId, "otherwise, DxilModule flag not set properly");
-        OutputsDependentOnViewId[outIdx] = true;
-        continue;
-      }
-
-      // Start setting output dependence on inputs.
-      DxilSignatureElement *pSigElem = nullptr;
-      bool bLoadOutputCPInHS = false;
-      unsigned inpId = (unsigned)-1;
-      int startRow = Semantic::kUndefinedRow, endRow = Semantic::kUndefinedRow;
-      unsigned col = (unsigned)-1;
-      if (DxilInst_LoadInput LI = DxilInst_LoadInput(pInst)) {
-        GetUnsignedVal(LI.get_inputSigId(), &inpId);
-        GetUnsignedVal(LI.get_colIndex(), &col);
-        GetUnsignedVal(LI.get_rowIndex(), (uint32_t *)&startRow);
-        pSigElem = &m_pModule->GetInputSignature().GetElement(inpId);
-        if (pSM->IsDS() && bPC) {
-          pSigElem = nullptr;
-        }
-      } else if (DxilInst_LoadOutputControlPoint LOCP =
-                     DxilInst_LoadOutputControlPoint(pInst)) {
-        GetUnsignedVal(LOCP.get_inputSigId(), &inpId);
-        GetUnsignedVal(LOCP.get_col(), &col);
-        GetUnsignedVal(LOCP.get_row(), (uint32_t *)&startRow);
-        if (pSM->IsHS()) {
-          pSigElem = &m_pModule->GetOutputSignature().GetElement(inpId);
-          bLoadOutputCPInHS = true;
-        } else if (pSM->IsDS()) {
-          if (!bPC) {
-            pSigElem = &m_pModule->GetInputSignature().GetElement(inpId);
-          }
-        } else {
-          DXASSERT_NOMSG(false);
-        }
-      } else if (DxilInst_LoadPatchConstant LPC =
-                     DxilInst_LoadPatchConstant(pInst)) {
-        if (pSM->IsDS() && bPC) {
-          GetUnsignedVal(LPC.get_inputSigId(), &inpId);
-          GetUnsignedVal(LPC.get_col(), &col);
-          GetUnsignedVal(LPC.get_row(), (uint32_t *)&startRow);
-          pSigElem =
-              &m_pModule->GetPatchConstOrPrimSignature().GetElement(inpId);
-        }
-      } else {
-        continue;
+    const ContributionSet &Contribution = itOut.second;
+    if (Contribution.bViewId)
+      OutputsDependentOnViewId[outIdx] = true;
+
+    // DS patch-constant dependences are reported separately from control-point
+    // inputs.
+    const SigScalarSetType &Inputs =
+        pSM->IsDS() && bPC ? Contribution.PCInputs : Contribution.Inputs;
+    if (Inputs.any()) {
+      auto &ContributingInputs = InputsContributingToOutputs[outIdx];
+      for (unsigned index = 0; index < kMaxSigScalars; index++) {
+        if (Inputs[index])
+          ContributingInputs.emplace(index);
       }
+    }
 
-      // Finalize setting output dependence on inputs.
-      if (pSigElem && pSigElem->IsAllocated()) {
-        if (startRow != Semantic::kUndefinedRow) {
-          endRow = startRow;
-        } else {
-          // The entire column contributes to output.
-          startRow = 0;
-          endRow = pSigElem->GetRows() - 1;
-        }
-
-        auto &ContributingInputs = InputsContributingToOutputs[outIdx];
-        for (int row = startRow; row <= endRow; row++) {
-          unsigned index = GetLinearIndex(*pSigElem, row, col);
-          if (!bLoadOutputCPInHS) {
-            ContributingInputs.emplace(index);
-          } else {
-            // This HS patch-constant output depends on an input value of
-            // LoadOutputControlPoint that is the output value of the HS main
-            // (control-point) function. Transitively update this
-            // (patch-constant) output dependence on main (control-point)
-            // output.
-            DXASSERT_NOMSG(&OutputsDependentOnViewId ==
-                           &m_PCOrPrimOutputsDependentOnViewId);
-            OutputsDependentOnViewId[outIdx] =
-                OutputsDependentOnViewId[outIdx] ||
-                m_OutputsDependentOnViewId[0][index];
-
-            const auto it = m_InputsContributingToOutputs[0].find(index);
-            if (it != m_InputsContributingToOutputs[0].end()) {
-              const std::set<unsigned>
-                  &LoadOutputCPInputsContributingToOutputs = it->second;
-              ContributingInputs.insert(
-                  LoadOutputCPInputsContributingToOutputs.begin(),
-                  LoadOutputCPInputsContributingToOutputs.end());
-            }
-          }
+    if (Contribution.OutputCPs.any()) {
+      // This HS patch-constant output depends on an input value of
+      // LoadOutputControlPoint that is the output value of the HS main
+      // (control-point) function. Transitively update this (patch-constant)
+      // output dependence on main (control-point) output.
+      DXASSERT_NOMSG(&OutputsDependentOnViewId ==
+                     &m_PCOrPrimOutputsDependentOnViewId);
+      auto &ContributingInputs = InputsContributingToOutputs[outIdx];
+      for (unsigned index = 0; index < kMaxSigScalars; index++) {
+        if (!Contribution.OutputCPs[index])
+          continue;
+        OutputsDependentOnViewId[outIdx] =
+            OutputsDependentOnViewId[outIdx] ||
+            m_OutputsDependentOnViewId[0][index];
+
+        const auto it = m_InputsContributingToOutputs[0].find(index);
+        if (it != m_InputsContributingToOutputs[0].end()) {
+          const std::set<unsigned> &LoadOutputCPInputsContributingToOutputs =
+              it->second;
+          ContributingInputs.insert(
+              LoadOutputCPInputsContributingToOutputs.begin(),
+              LoadOutputCPInputsContributingToOutputs.end());
         }
       }
     }
@@ -996,9 +1111,16 @@ bool ComputeViewIdState::runOnModule(Module &M) {
   DxilModule &DxilModule = M.GetOrCreateDxilModule();
   const ShaderModel *pSM = DxilModule.GetShaderModel();
   if (!pSM->IsCS() && !pSM->IsLib()) {
+    // The dependence tables only reach the dx.viewIdState metadata and PSV1
+    // and later, neither of which is emitted for validator version 1.0.
+    unsigned ValMajor, ValMinor;
+    DxilModule.GetValidatorVersion(ValMajor, ValMinor);
+    bool bComputeDependences =
+        (ValMajor == 0 && ValMinor == 0) ||
+        DXIL::CompareVersions(ValMajor, ValMinor, 1, 1) >= 0;
     DxilViewIdState ViewIdState(&DxilModule);
     DxilViewIdStateBuilder Builder(ViewIdState, &DxilModule);
-    Builder.Compute();
+    Builder.Compute(bComputeDependences);
     // Serialize viewidstate.
     ViewIdState.Serialize();
     auto &TmpSerialized = ViewIdState.GetSerialized();
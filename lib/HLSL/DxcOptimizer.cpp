@@ -37,6 +37,7 @@
 #include "llvm/Pass.h"
 #include "llvm/PassInfo.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Transforms/IPO/PassManagerBuilder.h"
@@ -69,6 +70,14 @@ static void FatalErrorHandlerStreamWrite(void *user_data,
   throw std::exception();
 }
 
+static uint64_t CountInstructions(const Module &M) {
+  uint64_t Count = 0;
+  for (const Function &F : M)
+    for (const BasicBlock &BB : F)
+      Count += BB.size();
+  return Count;
+}
+
 static HRESULT Utf8ToWideCoTaskMalloc(LPCSTR pValue, LPWSTR *ppResult) {
   if (ppResult == nullptr)
     return E_POINTER;
@@ -409,6 +418,7 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
     //
     bool OutputAssembly = false;
     bool AnalyzeOnly = false;
+    bool OutputStats = false;
 
     // First gather flags, wherever they may be.
     SmallVector<UINT32, 2> handled;
@@ -423,6 +433,22 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
         handled.push_back(i);
         continue;
       }
+      // Append instruction counts and the time spent in each pass to the
+      // output text, as 'OPT-STATS:' lines.
+      if (wcseq(L"-opt-stats", ppOptions[i])) {
+        OutputStats = true;
+        handled.push_back(i);
+        continue;
+      }
+    }
+
+    legacy::PassTimes Times;
+    uint64_t InstructionsIn = 0;
+    // Pass managers pick up the timers as passes are added.
+    if (OutputStats) {
+      ModulePasses.HLSLPassTimes = &Times;
+      FunctionPasses.HLSLPassTimes = &Times;
+      InstructionsIn = CountInstructions(*M);
     }
 
     // TODO: should really use string_table for this once that's available
@@ -572,6 +598,14 @@ HRESULT STDMETHODCALLTYPE DxcOptimizer::RunOptimizer(
       ModulePasses.run(*M.get());
     }
 
+    if (OutputStats) {
+      outStream << "OPT-STATS: instructions " << InstructionsIn << " "
+                << CountInstructions(*M) << "\n";
+      for (const std::unique_ptr<Timer> &T : Times.getTimers())
+        outStream << "OPT-STATS: pass " << T->getName() << " "
+                  << format("%.6f", T->getTotalTime().getWallTime()) << "\n";
+    }
+
     outStream.flush();
     if (ppOutputText != nullptr) {
       IFT(DxcCreateBlobWithEncodingSet(pOutputBlob, CP_UTF8, ppOutputText));
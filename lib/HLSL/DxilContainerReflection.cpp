@@ -2295,17 +2295,20 @@ HRESULT DxilModuleReflection::LoadProgramHeader(
     auto errorHandler = [&bBitcodeLoadError](const DiagnosticInfo &diagInfo) {
       bBitcodeLoadError |= diagInfo.getSeverity() == DS_Error;
     };
-#if 0 // We materialize eagerly, because we'll need to walk instructions to look
-      // for usage information.
-    ErrorOr<std::unique_ptr<Module>> mod =
-        getLazyBitcodeModule(std::move(pMemBuffer), Context, errorHandler);
-#else
-    ErrorOr<std::unique_ptr<Module>> mod =
-        parseBitcodeFile(pMemBuffer->getMemBufferRef(), Context, errorHandler);
-#endif
+    // Load lazily: when usage information is recorded in metadata, nothing
+    // below needs to walk instructions, so function bodies stay in bitcode.
+    // Reflection never looks at debug info, so skip it, which matters for
+    // debug (ILDB) parts.
+    ErrorOr<std::unique_ptr<Module>> mod = getLazyBitcodeModule(
+        std::move(pMemBuffer), Context, errorHandler,
+        /*ShouldLazyLoadMetadata*/ false,
+        /*ShouldTrackBitstreamUsage*/ false, /*ShouldSkipDebugInfo*/ true);
     if (!mod || bBitcodeLoadError) {
       return E_INVALIDARG;
     }
+    if (mod.get()->materializeMetadata() || bBitcodeLoadError) {
+      return E_INVALIDARG;
+    }
     std::swap(m_pModule, mod.get());
     m_pDxilModule = &m_pModule->GetOrCreateDxilModule();
 
@@ -2314,6 +2317,14 @@ HRESULT DxilModuleReflection::LoadProgramHeader(
     m_bUsageInMetadata =
         hlsl::DXIL::CompareVersions(ValMajor, ValMinor, 1, 5) >= 0;
 
+    // Older validator versions require walking instructions to look for usage
+    // information, so materialize everything up front.
+    if (!m_bUsageInMetadata) {
+      m_pDxilModule->MaterializeAllFunctions();
+      if (bBitcodeLoadError)
+        return E_INVALIDARG;
+    }
+
     CreateReflectionObjects();
     return S_OK;
   }
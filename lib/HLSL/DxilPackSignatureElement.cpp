@@ -50,6 +50,9 @@ unsigned PackDxilSignature(DxilSignature &sig, DXIL::PackingStrategy packing) {
         case DXIL::PackingStrategy::Optimized:
           streamRowsUsed = alloc[i].PackOptimized(elements[i], 0, 32);
           break;
+        case DXIL::PackingStrategy::MinimalRows:
+          streamRowsUsed = alloc[i].PackMinimalRows(elements[i], 0, 32);
+          break;
         default:
           DXASSERT(false, "otherwise, invalid packing strategy supplied");
         }
@@ -93,6 +96,9 @@ unsigned PackDxilSignature(DxilSignature &sig, DXIL::PackingStrategy packing) {
     case DXIL::PackingStrategy::Optimized:
       rowsUsed = alloc.PackOptimized(elements, 0, 32);
       break;
+    case DXIL::PackingStrategy::MinimalRows:
+      rowsUsed = alloc.PackMinimalRows(elements, 0, 32);
+      break;
     default:
       DXASSERT(false, "otherwise, invalid packing strategy supplied");
     }
@@ -0,0 +1,430 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// DxilSignaturePruning.cpp                                                  //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Removes signature elements that are not used across a pipeline of         //
+// shader stages compiled together.                                          //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxc/HLSL/DxilSignaturePruning.h"
+#include "dxc/DXIL/DxilModule.h"
+#include "dxc/DXIL/DxilOperations.h"
+#include "dxc/DXIL/DxilSigPoint.h"
+#include "dxc/DXIL/DxilSignature.h"
+#include "dxc/HLSL/ComputeViewIdState.h"
+#include "dxc/HLSL/DxilGenerationPass.h"
+#include "dxc/HLSL/DxilPackSignatureElement.h"
+#include "dxc/HLSL/DxilSignatureAllocator.h"
+#include "dxc/Support/Global.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Transforms/Scalar.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace llvm;
+using namespace hlsl;
+
+namespace {
+
+enum SigIndex { kInputSig = 0, kOutputSig, kPatchConstOrPrimSig, kNumSigs };
+
+DxilSignature &GetSignature(DxilModule &DM, unsigned Sig) {
+  switch (Sig) {
+  case kInputSig:
+    return DM.GetInputSignature();
+  case kOutputSig:
+    return DM.GetOutputSignature();
+  default:
+    return DM.GetPatchConstOrPrimSignature();
+  }
+}
+
+// Returns the signature accessed by a DXIL operation taking a signature ID as
+// its first argument, and whether the operation reads it. Returns false for
+// other operations.
+bool GetSignatureAccess(DXIL::OpCode Opcode, unsigned &Sig, bool &bRead) {
+  switch (Opcode) {
+  case DXIL::OpCode::LoadInput:
+  case DXIL::OpCode::EvalSnapped:
+  case DXIL::OpCode::EvalSampleIndex:
+  case DXIL::OpCode::EvalCentroid:
+  case DXIL::OpCode::AttributeAtVertex:
+    Sig = kInputSig;
+    bRead = true;
+    return true;
+  case DXIL::OpCode::LoadOutputControlPoint:
+    Sig = kOutputSig;
+    bRead = true;
+    return true;
+  case DXIL::OpCode::LoadPatchConstant:
+    Sig = kPatchConstOrPrimSig;
+    bRead = true;
+    return true;
+  case DXIL::OpCode::StoreOutput:
+  case DXIL::OpCode::StoreVertexOutput:
+    Sig = kOutputSig;
+    bRead = false;
+    return true;
+  case DXIL::OpCode::StorePatchConstant:
+  case DXIL::OpCode::StorePrimitiveOutput:
+    Sig = kPatchConstOrPrimSig;
+    bRead = false;
+    return true;
+  default:
+    return false;
+  }
+}
+
+// Signature operations of one stage, grouped by the signature they access.
+struct StageSigUses {
+  std::vector<CallInst *> Calls[kNumSigs];
+  std::vector<bool> Read[kNumSigs];
+  bool bNonConstantID = false;
+
+  explicit StageSigUses(DxilModule &DM) {
+    for (unsigned S = 0; S < kNumSigs; ++S)
+      Read[S].resize(GetSignature(DM, S).GetElements().size());
+    for (Function &F : *DM.GetModule()) {
+      if (!OP::IsDxilOpFunc(&F))
+        continue;
+      for (User *U : F.users()) {
+        CallInst *CI = dyn_cast<CallInst>(U);
+        if (!CI)
+          continue;
+        unsigned Sig;
+        bool bRead;
+        if (!GetSignatureAccess(OP::getOpCode(CI), Sig, bRead))
+          continue;
+        ConstantInt *ID = dyn_cast<ConstantInt>(CI->getArgOperand(1));
+        if (!ID || ID->getZExtValue() >= Read[Sig].size()) {
+          bNonConstantID = true;
+          continue;
+        }
+        Calls[Sig].push_back(CI);
+        if (bRead)
+          Read[Sig][ID->getZExtValue()] = true;
+      }
+    }
+  }
+};
+
+// A producer signature and the consumer signature it feeds.
+struct SigLink {
+  unsigned ProducerSig;
+  unsigned ConsumerSig;
+  bool bRepack;
+};
+
+// Returns false if the consumer stage cannot follow the producer stage.
+bool GetSigLinks(DXIL::ShaderKind Producer, DXIL::ShaderKind Consumer,
+                 SmallVectorImpl<SigLink> &Links) {
+  typedef DXIL::ShaderKind SK;
+  switch (Producer) {
+  case SK::Vertex:
+    if (Consumer != SK::Hull && Consumer != SK::Geometry &&
+        Consumer != SK::Pixel)
+      return false;
+    break;
+  case SK::Hull:
+    if (Consumer != SK::Domain)
+      return false;
+    // Patch constants keep their locations, tess factors are fixed.
+    Links.push_back({kPatchConstOrPrimSig, kPatchConstOrPrimSig, false});
+    break;
+  case SK::Domain:
+    if (Consumer != SK::Geometry && Consumer != SK::Pixel)
+      return false;
+    break;
+  case SK::Geometry:
+    if (Consumer != SK::Pixel)
+      return false;
+    break;
+  case SK::Amplification:
+    // Payload only, no signature is shared.
+    return Consumer == SK::Mesh;
+  case SK::Mesh:
+    if (Consumer != SK::Pixel)
+      return false;
+    // Vertex and primitive outputs share the pixel shader input signature,
+    // so the elements keep their locations.
+    Links.push_back({kOutputSig, kInputSig, false});
+    Links.push_back({kPatchConstOrPrimSig, kInputSig, false});
+    return true;
+  default:
+    return false;
+  }
+  Links.push_back({kOutputSig, kInputSig, true});
+  return true;
+}
+
+bool SemanticsOverlap(const DxilSignatureElement &A,
+                      const DxilSignatureElement &B) {
+  if (!StringRef(A.GetName()).equals_lower(B.GetName()))
+    return false;
+  for (unsigned Index : A.GetSemanticIndexVec()) {
+    const std::vector<unsigned> &BIndices = B.GetSemanticIndexVec();
+    if (std::find(BIndices.begin(), BIndices.end(), Index) != BIndices.end())
+      return true;
+  }
+  return false;
+}
+
+// Erases writes to removed elements, renumbers the remaining signature
+// operations and removes the elements from the signature.
+void RemoveSignatureElements(DxilSignature &Sig,
+                             const std::vector<CallInst *> &Calls,
+                             const std::vector<bool> &Remove) {
+  std::vector<unsigned> NewIDs = Sig.RemoveElements(Remove);
+  for (CallInst *CI : Calls) {
+    ConstantInt *ID = cast<ConstantInt>(CI->getArgOperand(1));
+    unsigned NewID = NewIDs[ID->getZExtValue()];
+    if (NewID == UINT_MAX) {
+      DXASSERT(CI->getType()->isVoidTy(),
+               "otherwise, a removed signature element is still read");
+      CI->eraseFromParent();
+      continue;
+    }
+    CI->setArgOperand(1, ConstantInt::get(ID->getType(), NewID));
+  }
+}
+
+// Repacks the consumer signature and lays out the producer signature to
+// match it. On failure both signatures keep their original locations.
+bool RepackLinkedSignatures(DxilSignature &ProducerSig,
+                            DxilSignature &ConsumerSig,
+                            DXIL::PackingStrategy Packing) {
+  if (SigPoint::GetSigPoint(ProducerSig.GetSigPointKind())->GetPackingKind() !=
+          DXIL::PackingKind::Vertex ||
+      SigPoint::GetSigPoint(ConsumerSig.GetSigPointKind())->GetPackingKind() !=
+          DXIL::PackingKind::Vertex)
+    return false;
+
+  const auto &ProducerElts = ProducerSig.GetElements();
+  const auto &ConsumerElts = ConsumerSig.GetElements();
+
+  // Only elements declared identically on both sides can follow the new
+  // consumer layout.
+  std::vector<DxilSignatureElement *> Match(ProducerElts.size(), nullptr);
+  std::vector<bool> ConsumerMatched(ConsumerElts.size(), false);
+  for (unsigned P = 0; P < ProducerElts.size(); ++P) {
+    DxilSignatureElement &PE = *ProducerElts[P];
+    if (!DxilSignature::ShouldBeAllocated(PE.GetInterpretation()))
+      continue;
+    for (unsigned C = 0; C < ConsumerElts.size(); ++C) {
+      DxilSignatureElement &CE = *ConsumerElts[C];
+      if (!SemanticsOverlap(PE, CE))
+        continue;
+      if (Match[P] || ConsumerMatched[C] ||
+          PE.GetSemanticIndexVec() != CE.GetSemanticIndexVec())
+        return false;
+      Match[P] = &CE;
+      ConsumerMatched[C] = true;
+    }
+  }
+
+  std::vector<std::pair<int, int>> ProducerLocs, ConsumerLocs;
+  for (auto &E : ProducerElts)
+    ProducerLocs.emplace_back(E->GetStartRow(), E->GetStartCol());
+  for (auto &E : ConsumerElts)
+    ConsumerLocs.emplace_back(E->GetStartRow(), E->GetStartCol());
+  auto Restore = [&]() {
+    for (unsigned i = 0; i < ProducerElts.size(); ++i) {
+      ProducerElts[i]->SetStartRow(ProducerLocs[i].first);
+      ProducerElts[i]->SetStartCol(ProducerLocs[i].second);
+    }
+    for (unsigned i = 0; i < ConsumerElts.size(); ++i) {
+      ConsumerElts[i]->SetStartRow(ConsumerLocs[i].first);
+      ConsumerElts[i]->SetStartCol(ConsumerLocs[i].second);
+    }
+    return false;
+  };
+
+  PackDxilSignature(ConsumerSig, Packing);
+  if (!ConsumerSig.IsFullyAllocated())
+    return Restore();
+
+  bool bUseMinPrecision = ProducerSig.UseMinPrecision();
+  DxilSignatureAllocator Alloc(32, bUseMinPrecision);
+  // Reserve consumer elements the producer does not write, like system
+  // generated values.
+  for (unsigned C = 0; C < ConsumerElts.size(); ++C) {
+    if (ConsumerMatched[C] || !ConsumerElts[C]->IsAllocated())
+      continue;
+    DxilPackElement CE(ConsumerElts[C].get(), ConsumerSig.UseMinPrecision());
+    Alloc.PlaceElement(&CE, CE.GetStartRow(), CE.GetStartCol());
+  }
+  for (unsigned P = 0; P < ProducerElts.size(); ++P) {
+    if (!Match[P])
+      continue;
+    DxilPackElement PE(ProducerElts[P].get(), bUseMinPrecision);
+    unsigned Row = Match[P]->GetStartRow(), Col = Match[P]->GetStartCol();
+    if (!Match[P]->IsAllocated() || Alloc.DetectRowConflict(&PE, Row) ||
+        Alloc.DetectColConflict(&PE, Row, Col))
+      return Restore();
+    Alloc.PlaceElement(&PE, Row, Col);
+    PE.SetLocation(Row, Col);
+  }
+  for (unsigned P = 0; P < ProducerElts.size(); ++P) {
+    if (Match[P] ||
+        !DxilSignature::ShouldBeAllocated(ProducerElts[P]->GetInterpretation()))
+      continue;
+    DxilPackElement PE(ProducerElts[P].get(), bUseMinPrecision);
+    if (!Alloc.PackNext(&PE, 0, 32))
+      return Restore();
+  }
+  return true;
+}
+
+void RunCleanupPasses(Module &M) {
+  legacy::PassManager PM;
+  PM.add(createAggressiveDCEPass());
+  PM.add(createCFGSimplificationPass());
+  PM.add(createDeadCodeEliminationPass());
+  PM.run(M);
+}
+
+void UpdateModuleState(Module &M) {
+  legacy::PassManager PM;
+  PM.add(createComputeViewIdStatePass());
+  PM.add(createDxilEmitMetadataPass());
+  PM.run(M);
+}
+
+// Prunes the signatures shared by two consecutive stages. Returns the number
+// of elements removed.
+unsigned PruneStagePair(DxilModule &Producer, DxilModule &Consumer,
+                        ArrayRef<SigLink> Links, DXIL::PackingStrategy Packing,
+                        bool &bProducerChanged, bool &bConsumerChanged) {
+  if (Links.empty() || !Producer.GetEntryFunction() ||
+      !Consumer.GetEntryFunction())
+    return 0;
+  if (Producer.GetShaderModel()->IsGS()) {
+    for (auto &E : Producer.GetOutputSignature().GetElements())
+      if (E->GetOutputStream() != 0)
+        return 0;
+  }
+
+  StageSigUses ProducerUses(Producer), ConsumerUses(Consumer);
+  if (ProducerUses.bNonConstantID || ConsumerUses.bNonConstantID)
+    return 0;
+
+  // Consumer inputs that are never read.
+  std::vector<bool> ConsumerRemove[kNumSigs];
+  for (const SigLink &L : Links) {
+    std::vector<bool> &Remove = ConsumerRemove[L.ConsumerSig];
+    if (!Remove.empty())
+      continue;
+    const auto &Elts = GetSignature(Consumer, L.ConsumerSig).GetElements();
+    Remove.resize(Elts.size());
+    for (unsigned i = 0; i < Elts.size(); ++i)
+      Remove[i] = Elts[i]->IsArbitrary() &&
+                  !ConsumerUses.Read[L.ConsumerSig][i];
+  }
+
+  // Producer outputs that no remaining consumer input reads.
+  std::vector<bool> ProducerRemove[kNumSigs];
+  for (const SigLink &L : Links) {
+    const auto &Elts = GetSignature(Producer, L.ProducerSig).GetElements();
+    const auto &ConsumerElts =
+        GetSignature(Consumer, L.ConsumerSig).GetElements();
+    std::vector<bool> &Remove = ProducerRemove[L.ProducerSig];
+    Remove.resize(Elts.size());
+    for (unsigned i = 0; i < Elts.size(); ++i) {
+      if (!Elts[i]->IsArbitrary() || ProducerUses.Read[L.ProducerSig][i])
+        continue;
+      bool bUsed = false;
+      for (unsigned C = 0; C < ConsumerElts.size() && !bUsed; ++C)
+        bUsed = !ConsumerRemove[L.ConsumerSig][C] &&
+                SemanticsOverlap(*Elts[i], *ConsumerElts[C]);
+      Remove[i] = !bUsed;
+    }
+  }
+
+  unsigned NumRemoved = 0;
+  bool bRemoved[kNumSigs][2] = {};
+  for (unsigned S = 0; S < kNumSigs; ++S) {
+    const std::vector<bool> *Removes[2] = {&ProducerRemove[S],
+                                           &ConsumerRemove[S]};
+    DxilModule *Modules[2] = {&Producer, &Consumer};
+    StageSigUses *Uses[2] = {&ProducerUses, &ConsumerUses};
+    for (unsigned Side = 0; Side < 2; ++Side) {
+      unsigned Count = std::count(Removes[Side]->begin(), Removes[Side]->end(),
+                                  true);
+      if (!Count)
+        continue;
+      RemoveSignatureElements(GetSignature(*Modules[Side], S),
+                              Uses[Side]->Calls[S], *Removes[Side]);
+      NumRemoved += Count;
+      bRemoved[S][Side] = true;
+    }
+  }
+  if (!NumRemoved)
+    return 0;
+
+  for (const SigLink &L : Links) {
+    if (!L.bRepack ||
+        (!bRemoved[L.ProducerSig][0] && !bRemoved[L.ConsumerSig][1]))
+      continue;
+    RepackLinkedSignatures(GetSignature(Producer, L.ProducerSig),
+                           GetSignature(Consumer, L.ConsumerSig), Packing);
+  }
+
+  for (unsigned S = 0; S < kNumSigs; ++S) {
+    bProducerChanged |= bRemoved[S][0];
+    bConsumerChanged |= bRemoved[S][1];
+  }
+  if (bProducerChanged)
+    RunCleanupPasses(*Producer.GetModule());
+  return NumRemoved;
+}
+
+} // namespace
+
+namespace hlsl {
+
+unsigned PrunePipelineSignatures(ArrayRef<Module *> Stages,
+                                 DXIL::PackingStrategy Packing,
+                                 std::vector<bool> &Changed) {
+  Changed.assign(Stages.size(), false);
+  std::vector<SmallVector<SigLink, 2>> Links(Stages.size());
+  for (unsigned i = 1; i < Stages.size(); ++i) {
+    DXIL::ShaderKind Producer =
+        Stages[i - 1]->GetOrCreateDxilModule().GetShaderModel()->GetKind();
+    DXIL::ShaderKind Consumer =
+        Stages[i]->GetOrCreateDxilModule().GetShaderModel()->GetKind();
+    IFTBOOLMSG(GetSigLinks(Producer, Consumer, Links[i]), E_INVALIDARG,
+               "pipeline stages are not in pipeline order");
+  }
+
+  // Walk backwards so that inputs left unread by pruning a stage's outputs
+  // are pruned from the stage before it.
+  unsigned NumRemoved = 0;
+  for (unsigned i = Stages.size(); i-- > 1;) {
+    bool bProducerChanged = false, bConsumerChanged = false;
+    NumRemoved += PruneStagePair(
+        Stages[i - 1]->GetDxilModule(), Stages[i]->GetDxilModule(), Links[i],
+        Packing, bProducerChanged, bConsumerChanged);
+    if (bProducerChanged)
+      Changed[i - 1] = true;
+    if (bConsumerChanged)
+      Changed[i] = true;
+  }
+
+  for (unsigned i = 0; i < Stages.size(); ++i) {
+    if (Changed[i])
+      UpdateModuleState(*Stages[i]);
+  }
+  return NumRemoved;
+}
+
+} // namespace hlsl
@@ -656,6 +656,10 @@ public:
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<PostDominatorTree>();
     AU.addRequired<DominatorTreeWrapperPass>();
+    // The trees are recomputed here when a branch is removed, so that the
+    // cleanup passes that follow at -Od can reuse them.
+    AU.addPreserved<PostDominatorTree>();
+    AU.addPreserved<DominatorTreeWrapperPass>();
   }
 };
 
@@ -773,6 +777,11 @@ bool DxilSimpleGVNEliminateRegion::runOnFunction(Function &F) {
     bChanged |= ProcessBB(BB, VT, DT, PDT);
   }
 
+  if (bChanged) {
+    DT->recalculate(F);
+    PDT->DT->recalculate(F);
+  }
+
   return bChanged;
 }
 
@@ -6416,13 +6416,10 @@ HRESULT ValidateDxilContainerParts(llvm::Module *pModule,
         std::string diagStr;
         raw_string_ostream DiagStream(diagStr);
         try {
-          RootSignatureHandle RS;
-          RS.LoadSerialized(
-              (const uint8_t *)GetDxilPartData(pRootSignaturePart),
-              pRootSignaturePart->PartSize);
-          RS.Deserialize();
-          IFTBOOL(VerifyRootSignatureWithShaderPSV(
-                      RS.GetDesc(), pDxilModule->GetShaderModel()->GetKind(),
+          IFTBOOL(VerifySerializedRootSignatureWithShaderPSV(
+                      GetDxilPartData(pRootSignaturePart),
+                      pRootSignaturePart->PartSize,
+                      pDxilModule->GetShaderModel()->GetKind(),
                       GetDxilPartData(pPSVPart), pPSVPart->PartSize,
                       DiagStream),
                   DXC_E_INCORRECT_ROOT_SIGNATURE);
@@ -6474,7 +6471,8 @@ static HRESULT FindDxilPart(const void *pContainerBytes, uint32_t ContainerSize,
 
 HRESULT ValidateLoadModule(const char *pIL, uint32_t ILLength,
                            unique_ptr<llvm::Module> &pModule, LLVMContext &Ctx,
-                           llvm::raw_ostream &DiagStream, unsigned bLazyLoad) {
+                           llvm::raw_ostream &DiagStream, unsigned bLazyLoad,
+                           bool bSkipDebugInfo) {
 
   llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
   PrintDiagnosticContext DiagContext(DiagPrinter);
@@ -6488,9 +6486,10 @@ HRESULT ValidateLoadModule(const char *pIL, uint32_t ILLength,
   ErrorOr<std::unique_ptr<Module>> loadedModuleResult =
       bLazyLoad == 0
           ? llvm::parseBitcodeFile(pBitcodeBuf->getMemBufferRef(), Ctx, nullptr,
-                                   true /*Track Bitstream*/)
+                                   true /*Track Bitstream*/, bSkipDebugInfo)
           : llvm::getLazyBitcodeModule(std::move(pBitcodeBuf), Ctx, nullptr,
-                                       false, true /*Track Bitstream*/);
+                                       false, true /*Track Bitstream*/,
+                                       bSkipDebugInfo);
 
   // DXIL disallows some LLVM bitcode constructs, like unaccounted-for
   // sub-blocks. These appear as warnings, which the validator should reject.
@@ -6530,15 +6529,10 @@ HRESULT ValidateDxilBitcode(const char *pIL, uint32_t ILLength,
     IFT(CreateMemoryStream(DxcGetThreadMallocNoRef(), &pOutputStream));
     pOutputStream->Reserve(pWriter->size());
     pWriter->write(pOutputStream);
-    DxilVersionedRootSignature desc;
     try {
-      DeserializeRootSignature(SerializedRootSig.data(),
-                               SerializedRootSig.size(), desc.get_address_of());
-      if (!desc.get()) {
-        return DXC_E_INCORRECT_ROOT_SIGNATURE;
-      }
-      IFTBOOL(VerifyRootSignatureWithShaderPSV(
-                  desc.get(), dxilModule.GetShaderModel()->GetKind(),
+      IFTBOOL(VerifySerializedRootSignatureWithShaderPSV(
+                  SerializedRootSig.data(), SerializedRootSig.size(),
+                  dxilModule.GetShaderModel()->GetKind(),
                   pOutputStream->GetPtr(), pWriter->size(), DiagStream),
               DXC_E_INCORRECT_ROOT_SIGNATURE);
     } catch (...) {
@@ -6557,7 +6551,8 @@ static HRESULT ValidateLoadModuleFromContainer(
     const void *pContainer, uint32_t ContainerSize,
     std::unique_ptr<llvm::Module> &pModule,
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
-    LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream, unsigned bLazyLoad) {
+    LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream, unsigned bLazyLoad,
+    bool bSkipProgramDebugInfo) {
   llvm::DiagnosticPrinterRawOStream DiagPrinter(DiagStream);
   PrintDiagnosticContext DiagContext(DiagPrinter);
   DiagRestore DR(Ctx, &DiagContext);
@@ -6572,7 +6567,8 @@ static HRESULT ValidateLoadModuleFromContainer(
       reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart)), &pIL,
       &ILLength);
 
-  IFR(ValidateLoadModule(pIL, ILLength, pModule, Ctx, DiagStream, bLazyLoad));
+  IFR(ValidateLoadModule(pIL, ILLength, pModule, Ctx, DiagStream, bLazyLoad,
+                         bSkipProgramDebugInfo));
 
   HRESULT hr;
   const DxilPartHeader *pDbgPart = nullptr;
@@ -6602,17 +6598,20 @@ HRESULT ValidateLoadModuleFromContainer(
     llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream) {
   return ValidateLoadModuleFromContainer(pContainer, ContainerSize, pModule,
                                          pDebugModule, Ctx, DbgCtx, DiagStream,
-                                         /*bLazyLoad*/ false);
+                                         /*bLazyLoad*/ false,
+                                         /*bSkipProgramDebugInfo*/ false);
 }
 // Lazy loads module from container, validating load, but not module.
 HRESULT ValidateLoadModuleFromContainerLazy(
     const void *pContainer, uint32_t ContainerSize,
     std::unique_ptr<llvm::Module> &pModule,
     std::unique_ptr<llvm::Module> &pDebugModule, llvm::LLVMContext &Ctx,
-    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream) {
+    llvm::LLVMContext &DbgCtx, llvm::raw_ostream &DiagStream,
+    bool bSkipProgramDebugInfo) {
   return ValidateLoadModuleFromContainer(pContainer, ContainerSize, pModule,
                                          pDebugModule, Ctx, DbgCtx, DiagStream,
-                                         /*bLazyLoad*/ true);
+                                         /*bLazyLoad*/ true,
+                                         bSkipProgramDebugInfo);
 }
 
 HRESULT ValidateDxilContainer(const void *pContainer, uint32_t ContainerSize,
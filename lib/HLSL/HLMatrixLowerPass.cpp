@@ -121,6 +121,11 @@ void TempOverloadPool::clear() {
 // 2a. Lower all matrix and matrix array allocas, just like global variables.
 // 2b. Lower all other instructions producing or consuming matrices
 //
+// Step 1 is the only one with module-wide effects. Step 2 only touches the
+// body of the function being lowered: mat-to-vec stubs are pooled per
+// function and must all be gone by the time the function is done, so a
+// function never depends on the lowering state of another one.
+//
 // Conversion stubs are used to allow converting instructions in isolation,
 // and in an order-independent manner:
 //
@@ -137,6 +142,7 @@ public:
   bool runOnModule(Module &M) override;
 
 private:
+  void lowerGlobals(Module &M);
   void runOnFunction(Function &Func);
   void addToDeadInsts(Instruction *Inst) { m_deadInsts.emplace_back(Inst); }
   void deleteDeadInsts();
@@ -195,7 +201,9 @@ private:
   HLModule *m_pHLModule;
   bool m_HasDbgInfo;
 
-  // Pools for the translation stubs
+  // Pools for the translation stubs. Vec-to-mat stubs are shared by the
+  // whole module because global lowering introduces them in every function,
+  // mat-to-vec stubs only live while a single function is lowered.
   TempOverloadPool *m_matToVecStubs = nullptr;
   TempOverloadPool *m_vecToMatStubs = nullptr;
 
@@ -211,7 +219,6 @@ INITIALIZE_PASS(HLMatrixLowerPass, "hlmatrixlower",
                 "HLSL High-Level Matrix Lower", false, false)
 
 bool HLMatrixLowerPass::runOnModule(Module &M) {
-  TempOverloadPool matToVecStubs(M, "hlmatrixlower.mat2vec");
   TempOverloadPool vecToMatStubs(M, "hlmatrixlower.vec2mat");
 
   m_pModule = &M;
@@ -219,33 +226,23 @@ bool HLMatrixLowerPass::runOnModule(Module &M) {
   // Load up debug information, to cross-reference values and the instructions
   // used to load them.
   m_HasDbgInfo = hasDebugInfo(M);
-  m_matToVecStubs = &matToVecStubs;
   m_vecToMatStubs = &vecToMatStubs;
 
   // First, lower static global variables.
-  // We need to accumulate them locally because we'll be creating new ones as we
-  // lower them.
-  std::vector<GlobalVariable *> Globals;
-  for (GlobalVariable &Global : M.globals()) {
-    if ((dxilutil::IsStaticGlobal(&Global) ||
-         dxilutil::IsSharedMemoryGlobal(&Global)) &&
-        HLMatrixType::isMatrixPtrOrArrayPtr(Global.getType())) {
-      Globals.emplace_back(&Global);
-    }
-  }
-
-  for (GlobalVariable *Global : Globals)
-    lowerGlobal(Global);
+  lowerGlobals(M);
 
+  // Then lower function bodies, each of which is self-contained.
+  // Gather them first since lowering may add stub declarations to the module.
+  std::vector<Function *> Funcs;
   for (Function &F : M.functions()) {
-    if (F.isDeclaration())
-      continue;
-    runOnFunction(F);
+    if (!F.isDeclaration())
+      Funcs.emplace_back(&F);
   }
+  for (Function *F : Funcs)
+    runOnFunction(*F);
 
   m_pModule = nullptr;
   m_pHLModule = nullptr;
-  m_matToVecStubs = nullptr;
   m_vecToMatStubs = nullptr;
 
   // If you hit an assert during TempOverloadPool destruction,
@@ -257,11 +254,33 @@ bool HLMatrixLowerPass::runOnModule(Module &M) {
   return true;
 }
 
+void HLMatrixLowerPass::lowerGlobals(Module &M) {
+  // We need to accumulate them locally because we'll be creating new ones as we
+  // lower them.
+  std::vector<GlobalVariable *> Globals;
+  for (GlobalVariable &Global : M.globals()) {
+    if ((dxilutil::IsStaticGlobal(&Global) ||
+         dxilutil::IsSharedMemoryGlobal(&Global)) &&
+        HLMatrixType::isMatrixPtrOrArrayPtr(Global.getType())) {
+      Globals.emplace_back(&Global);
+    }
+  }
+
+  for (GlobalVariable *Global : Globals)
+    lowerGlobal(Global);
+}
+
 void HLMatrixLowerPass::runOnFunction(Function &Func) {
   // Skip hl function definition (like createhandle)
   if (hlsl::GetHLOpcodeGroupByName(&Func) != HLOpcodeGroup::NotHL)
     return;
 
+  // Stubs created while lowering this function are consumed before it's done.
+  // If you hit an assert during the pool destruction, a matrix producer or
+  // consumer of this function was not (properly) lowered.
+  TempOverloadPool matToVecStubs(*m_pModule, "hlmatrixlower.mat2vec");
+  m_matToVecStubs = &matToVecStubs;
+
   // Save the matrix instructions first since the translation process
   // will temporarily create other instructions consuming/producing matrix
   // types.
@@ -281,6 +300,7 @@ void HLMatrixLowerPass::runOnFunction(Function &Func) {
     lowerInstruction(MatInst);
 
   deleteDeadInsts();
+  m_matToVecStubs = nullptr;
 }
 
 void HLMatrixLowerPass::deleteDeadInsts() {
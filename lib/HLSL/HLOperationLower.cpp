@@ -233,8 +233,9 @@ public:
 
 private:
   ResAttribute &FindCreateHandleResourceBase(Value *Handle) {
-    if (HandleMetaMap.count(Handle))
-      return HandleMetaMap[Handle];
+    auto It = HandleMetaMap.find(Handle);
+    if (It != HandleMetaMap.end())
+      return It->second;
 
     // Add invalid first to avoid dead loop.
     HandleMetaMap[Handle] = {
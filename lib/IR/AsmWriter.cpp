@@ -580,6 +580,13 @@ private:
   /// asMap - The slot map for attribute sets.
   DenseMap<AttributeSet, unsigned> asMap;
   unsigned asNext;
+
+  // HLSL Change Begin
+  /// ModuleSlots - When set, the module level slots (globals, metadata and
+  /// attribute sets) are looked up in this tracker instead, and only the
+  /// function level slots are kept here.
+  const SlotTracker *ModuleSlots = nullptr;
+  // HLSL Change End
 public:
   /// Construct from a module.
   ///
@@ -595,6 +602,16 @@ public:
   /// within a function (even if no functions have been initialized).
   explicit SlotTracker(const Function *F,
                        bool ShouldInitializeAllMetadata = false);
+  // HLSL Change Begin
+  /// Construct for a function, sharing the module level slots of
+  /// \p ModuleSlots, which must have numbered every function (see
+  /// processAllFunctions) and must outlive this tracker.
+  SlotTracker(const SlotTracker &ModuleSlots, const Function *F);
+
+  /// Number the metadata and call attributes used by every function of \p M,
+  /// in the order printing all of the functions would number them.
+  void processAllFunctions(const Module &M);
+  // HLSL Change End
 
   /// Return the slot number of the specified value in it's type
   /// plane.  If something is not in the SlotTracker, return -1.
@@ -741,6 +758,34 @@ SlotTracker::SlotTracker(const Function *F, bool ShouldInitializeAllMetadata)
       ShouldInitializeAllMetadata(ShouldInitializeAllMetadata), mNext(0),
       fNext(0), mdnNext(0), asNext(0) {}
 
+// HLSL Change Begin
+SlotTracker::SlotTracker(const SlotTracker &ModuleSlots, const Function *F)
+    : TheModule(nullptr), TheFunction(F), FunctionProcessed(false),
+      ShouldInitializeAllMetadata(false), mNext(0), fNext(0), mdnNext(0),
+      asNext(0), ModuleSlots(&ModuleSlots) {}
+
+void SlotTracker::processAllFunctions(const Module &M) {
+  initialize();
+
+  for (const Function &F : M) {
+    if (!ShouldInitializeAllMetadata)
+      processFunctionMetadata(F);
+
+    for (auto &BB : F) {
+      for (auto &I : BB) {
+        AttributeSet Attrs;
+        if (const CallInst *CI = dyn_cast<CallInst>(&I))
+          Attrs = CI->getAttributes().getFnAttributes();
+        else if (const InvokeInst *II = dyn_cast<InvokeInst>(&I))
+          Attrs = II->getAttributes().getFnAttributes();
+        if (Attrs.hasAttributes(AttributeSet::FunctionIndex))
+          CreateAttributeSetSlot(Attrs);
+      }
+    }
+  }
+}
+// HLSL Change End
+
 inline void SlotTracker::initialize() {
   if (TheModule) {
     processModule();
@@ -805,7 +850,7 @@ void SlotTracker::processFunction() {
   ST_DEBUG("Inserting Instructions:\n");
 
   // Process function metadata if it wasn't hit at the module-level.
-  if (!ShouldInitializeAllMetadata)
+  if (!ShouldInitializeAllMetadata && !ModuleSlots) // HLSL Change
     processFunctionMetadata(*TheFunction);
 
   // Add all of the basic blocks and instructions with no names.
@@ -817,6 +862,10 @@ void SlotTracker::processFunction() {
       if (!I.getType()->isVoidTy() && !I.hasName())
         CreateFunctionSlot(&I);
 
+      // HLSL Change - call attributes are already in the module slots.
+      if (ModuleSlots)
+        continue;
+
       // We allow direct calls to any llvm.foo function here, because the
       // target may not be linked into the optimizer.
       if (const CallInst *CI = dyn_cast<CallInst>(&I)) {
@@ -884,6 +933,13 @@ int SlotTracker::getGlobalSlot(const GlobalValue *V) {
   // Check for uninitialized state and do lazy initialization.
   initialize();
 
+  // HLSL Change Begin
+  if (ModuleSlots) {
+    ValueMap::const_iterator MI = ModuleSlots->mMap.find(V);
+    return MI == ModuleSlots->mMap.end() ? -1 : (int)MI->second;
+  }
+  // HLSL Change End
+
   // Find the value in the module map
   ValueMap::iterator MI = mMap.find(V);
   return MI == mMap.end() ? -1 : (int)MI->second;
@@ -894,6 +950,13 @@ int SlotTracker::getMetadataSlot(const MDNode *N) {
   // Check for uninitialized state and do lazy initialization.
   initialize();
 
+  // HLSL Change Begin
+  if (ModuleSlots) {
+    auto MI = ModuleSlots->mdnMap.find(N);
+    return MI == ModuleSlots->mdnMap.end() ? -1 : (int)MI->second;
+  }
+  // HLSL Change End
+
   // Find the MDNode in the module map
   mdn_iterator MI = mdnMap.find(N);
   return MI == mdnMap.end() ? -1 : (int)MI->second;
@@ -915,6 +978,13 @@ int SlotTracker::getAttributeGroupSlot(AttributeSet AS) {
   // Check for uninitialized state and do lazy initialization.
   initialize();
 
+  // HLSL Change Begin
+  if (ModuleSlots) {
+    auto AI = ModuleSlots->asMap.find(AS);
+    return AI == ModuleSlots->asMap.end() ? -1 : (int)AI->second;
+  }
+  // HLSL Change End
+
   // Find the AttributeSet in the module map.
   as_iterator AI = asMap.find(AS);
   return AI == asMap.end() ? -1 : (int)AI->second;
@@ -1998,7 +2068,8 @@ class AssemblyWriter {
   const Module *TheModule;
   std::unique_ptr<SlotTracker> SlotTrackerStorage;
   SlotTracker &Machine;
-  TypePrinting TypePrinter;
+  TypePrinting TypePrinterStorage; // HLSL Change
+  TypePrinting &TypePrinter;       // HLSL Change
   AssemblyAnnotationWriter *AnnotationWriter;
   SetVector<const Comdat *> Comdats;
   bool ShouldPreserveUseListOrder;
@@ -2016,10 +2087,20 @@ public:
                  AssemblyAnnotationWriter *AAW,
                  bool ShouldPreserveUseListOrder = false);
 
+  // HLSL Change Begin
+  /// Construct an AssemblyWriter that only prints functions, sharing the
+  /// types of the module already incorporated in \p Types.
+  AssemblyWriter(formatted_raw_ostream &o, SlotTracker &Mac,
+                 TypePrinting &Types, const Module *M,
+                 AssemblyAnnotationWriter *AAW);
+  // HLSL Change End
+
   void printMDNodeBody(const MDNode *MD);
   void printNamedMDNode(const NamedMDNode *NMD);
 
   void printModule(const Module *M);
+  void printModuleHeader(const Module *M);  // HLSL Change
+  void printModuleTrailer(const Module *M); // HLSL Change
 
   void writeOperand(const Value *Op, bool PrintType);
   void writeParamOperand(const Value *Operand, AttributeSet Attrs,unsigned Idx);
@@ -2078,17 +2159,28 @@ void AssemblyWriter::init() {
 AssemblyWriter::AssemblyWriter(formatted_raw_ostream &o, SlotTracker &Mac,
                                const Module *M, AssemblyAnnotationWriter *AAW,
                                bool ShouldPreserveUseListOrder)
-    : Out(o), TheModule(M), Machine(Mac), AnnotationWriter(AAW),
+    : Out(o), TheModule(M), Machine(Mac),
+      TypePrinter(TypePrinterStorage), // HLSL Change
+      AnnotationWriter(AAW),
       ShouldPreserveUseListOrder(ShouldPreserveUseListOrder) {
   init();
 }
 
+// HLSL Change Begin
+AssemblyWriter::AssemblyWriter(formatted_raw_ostream &o, SlotTracker &Mac,
+                               TypePrinting &Types, const Module *M,
+                               AssemblyAnnotationWriter *AAW)
+    : Out(o), TheModule(M), Machine(Mac), TypePrinter(Types),
+      AnnotationWriter(AAW), ShouldPreserveUseListOrder(false) {}
+// HLSL Change End
+
 #if 0 // HLSL Change - Unused
 AssemblyWriter::AssemblyWriter(formatted_raw_ostream &o, const Module *M,
                                AssemblyAnnotationWriter *AAW,
                                bool ShouldPreserveUseListOrder)
     : Out(o), TheModule(M), SlotTrackerStorage(createSlotTracker(M)),
-      Machine(*SlotTrackerStorage), AnnotationWriter(AAW),
+      Machine(*SlotTrackerStorage), TypePrinter(TypePrinterStorage),
+      AnnotationWriter(AAW),
       ShouldPreserveUseListOrder(ShouldPreserveUseListOrder) {
   init();
 }
@@ -2175,7 +2267,7 @@ void AssemblyWriter::writeParamOperand(const Value *Operand,
   WriteAsOperandInternal(Out, Operand, &TypePrinter, &Machine, TheModule);
 }
 
-void AssemblyWriter::printModule(const Module *M) {
+void AssemblyWriter::printModuleHeader(const Module *M) { // HLSL Change
   Machine.initialize();
 
   if (ShouldPreserveUseListOrder)
@@ -2234,12 +2326,21 @@ void AssemblyWriter::printModule(const Module *M) {
 
   // Output global use-lists.
   printUseLists(nullptr);
+}
+
+// HLSL Change - split printModule into the parts around the functions.
+void AssemblyWriter::printModule(const Module *M) {
+  printModuleHeader(M);
 
   // Output all of the functions.
   for (const Function &F : *M)
     printFunction(&F);
   assert(UseListOrders.empty() && "All use-lists should have been consumed");
 
+  printModuleTrailer(M);
+}
+
+void AssemblyWriter::printModuleTrailer(const Module *M) {
   // Output all attribute groups.
   if (!Machine.as_empty()) {
     Out << '\n';
@@ -3356,6 +3457,45 @@ void Metadata::print(raw_ostream &OS, ModuleSlotTracker &MST,
 }
 
 // HLSL Change Begin
+struct StreamingModulePrinter::Impl {
+  Impl(const Module &M, AssemblyAnnotationWriter *AAW)
+      : M(M), AAW(AAW), Slots(&M) {
+    Slots.processAllFunctions(M);
+    Types.incorporateTypes(M);
+  }
+
+  const Module &M;
+  AssemblyAnnotationWriter *AAW;
+  SlotTracker Slots;
+  TypePrinting Types;
+};
+
+StreamingModulePrinter::StreamingModulePrinter(const Module &M,
+                                               AssemblyAnnotationWriter *AAW)
+    : PImpl(new Impl(M, AAW)) {}
+
+StreamingModulePrinter::~StreamingModulePrinter() {}
+
+void StreamingModulePrinter::printHeader(raw_ostream &ROS) {
+  formatted_raw_ostream OS(ROS);
+  AssemblyWriter W(OS, PImpl->Slots, &PImpl->M, PImpl->AAW);
+  W.printModuleHeader(&PImpl->M);
+}
+
+void StreamingModulePrinter::printFunction(const Function &F,
+                                           raw_ostream &ROS) const {
+  SlotTracker FunctionSlots(PImpl->Slots, &F);
+  formatted_raw_ostream OS(ROS);
+  AssemblyWriter W(OS, FunctionSlots, PImpl->Types, &PImpl->M, PImpl->AAW);
+  W.printFunction(&F);
+}
+
+void StreamingModulePrinter::printTrailer(raw_ostream &ROS) {
+  formatted_raw_ostream OS(ROS);
+  AssemblyWriter W(OS, PImpl->Slots, &PImpl->M, PImpl->AAW);
+  W.printModuleTrailer(&PImpl->M);
+}
+
 void MDNode::printAsBody(raw_ostream &OS, const Module *M) const {
   ModuleSlotTracker MST(M, true);
   printAsBody(OS, MST, M);
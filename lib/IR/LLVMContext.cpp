@@ -118,6 +118,51 @@ void LLVMContext::removeModule(Module *M) {
   pImpl->OwnedModules.erase(M);
 }
 
+// HLSL Change - Begin
+bool LLVMContext::resetForReuse() {
+  if (!pImpl->OwnedModules.empty())
+    return false;
+  assert(pImpl->InstructionMetadata.empty() &&
+         pImpl->FunctionMetadata.empty() &&
+         "metadata attachments outlived their module");
+
+  pImpl->InlineAsmDiagHandler = nullptr;
+  pImpl->InlineAsmDiagContext = nullptr;
+  pImpl->DiagnosticHandler = nullptr;
+  pImpl->DiagnosticContext = nullptr;
+  pImpl->RespectDiagnosticFilters = false;
+  pImpl->YieldCallback = nullptr;
+  pImpl->YieldOpaqueHandle = nullptr;
+
+  // Struct types of earlier modules stay alive, but must not claim names or
+  // the next module would see renamed types such as "struct.S.0".
+  SmallVector<StructType *, 64> NamedTypes;
+  for (auto &Entry : pImpl->NamedStructTypes)
+    NamedTypes.push_back(Entry.getValue());
+  for (StructType *ST : NamedTypes)
+    ST->setName("");
+  pImpl->NamedStructTypesUniqueID = 0;
+
+  // Metadata kinds are numbered by registration order and the full list is
+  // written to bitcode, so only the fixed kinds may survive.
+  dropMDKindsFrom(MD_dereferenceable_or_null + 1);
+
+  pImpl->DiscriminatorTable.clear();
+  pImpl->dropTriviallyDeadConstantArrays();
+  return true;
+}
+
+void LLVMContext::dropMDKindsFrom(unsigned NumKinds) {
+  assert(NumKinds > MD_dereferenceable_or_null && "cannot drop fixed kinds");
+  SmallVector<StringRef, 16> LaterKinds;
+  for (auto &Entry : pImpl->CustomMDKindNames)
+    if (Entry.getValue() >= NumKinds)
+      LaterKinds.push_back(Entry.getKey());
+  for (StringRef Kind : LaterKinds)
+    pImpl->CustomMDKindNames.erase(Kind);
+}
+// HLSL Change - End
+
 //===----------------------------------------------------------------------===//
 // Recoverable Backend Errors
 //===----------------------------------------------------------------------===//
@@ -1432,6 +1432,7 @@ void FunctionPassManager::add(Pass *P) {
   FPM->HLSLPrintBefore = this->HLSLPrintBefore;
   FPM->HLSLPrintAfterAll = this->HLSLPrintAfterAll;
   FPM->HLSLPrintAfter = this->HLSLPrintAfter;
+  FPM->HLSLPassTimes = this->HLSLPassTimes;
   std::unique_ptr<Pass> PPtr(P); // take ownership of P, even on failure paths
   if (TrackPassOS) {
     P->dumpConfig(*TrackPassOS);
@@ -1798,6 +1799,7 @@ void PassManager::add(Pass *P) {
   PM->HLSLPrintBefore = this->HLSLPrintBefore;
   PM->HLSLPrintAfterAll = this->HLSLPrintAfterAll;
   PM->HLSLPrintAfter = this->HLSLPrintAfter;
+  PM->HLSLPassTimes = this->HLSLPassTimes;
   std::unique_ptr<Pass> PPtr(P); // take ownership of P, even on failure paths
   if (TrackPassOS) {
     P->dumpConfig(*TrackPassOS);
@@ -1839,11 +1841,43 @@ void TimingInfo::createTheTimeInfo() {
 
 /// If TimingInfo is enabled then start pass timer.
 Timer *llvm::getPassTimer(Pass *P) {
+  // HLSL Change Starts - timers of the top level manager running P come first.
+  if (AnalysisResolver *AR = P->getResolver()) {
+    PMTopLevelManager *TPM = AR->getPMDataManager().getTopLevelManager();
+    if (TPM && TPM->HLSLPassTimes)
+      return TPM->HLSLPassTimes->getPassTimer(P);
+  }
+  // HLSL Change Ends
   if (TheTimeInfo)
     return TheTimeInfo->getPassTimer(P);
   return nullptr;
 }
 
+// HLSL Change Starts
+//===----------------------------------------------------------------------===//
+// PassTimes implementation
+
+legacy::PassTimes::PassTimes() {}
+
+legacy::PassTimes::~PassTimes() {}
+
+Timer *legacy::PassTimes::getPassTimer(Pass *P) {
+  if (P->getAsPMDataManager())
+    return nullptr;
+
+  Timer *&T = PassTimers[P];
+  if (!T) {
+    // Passes that are not registered, such as printers, go by their names.
+    const PassInfo *PI =
+        PassRegistry::getPassRegistry()->getPassInfo(P->getPassID());
+    Timers.emplace_back(
+        new Timer(PI ? StringRef(PI->getPassArgument()) : P->getPassName()));
+    T = Timers.back().get();
+  }
+  return T;
+}
+// HLSL Change Ends
+
 //===----------------------------------------------------------------------===//
 // PMStack implementation
 //
@@ -151,17 +151,21 @@ TimeRecord TimeRecord::getCurrentTime(bool Start) {
   return Result;
 }
 
+#if 0 // HLSL Change Starts - ActiveTimers is never read and timers may run on
+      // several threads at once.
 static ManagedStatic<std::vector<Timer*> > ActiveTimers;
+#endif // HLSL Change Ends
 
 void Timer::startTimer() {
   Started = true;
-  ActiveTimers->push_back(this);
+  // ActiveTimers->push_back(this); // HLSL Change
   Time -= TimeRecord::getCurrentTime(true);
 }
 
 void Timer::stopTimer() {
   Time += TimeRecord::getCurrentTime(false);
 
+#if 0 // HLSL Change Starts
   if (ActiveTimers->back() == this) {
     ActiveTimers->pop_back();
   } else {
@@ -170,6 +174,7 @@ void Timer::stopTimer() {
     assert(I != ActiveTimers->end() && "stop but no startTimer?");
     ActiveTimers->erase(I);
   }
+#endif // HLSL Change Ends
 }
 
 static void printVal(double Val, double Total, raw_ostream &OS) {
@@ -106,6 +106,9 @@ public:
   static char ID;
 
   std::set<Loop *> LoopsThatFailed;
+  // Function whose loops are currently being visited. Unknown results left
+  // in the value cache by earlier passes are dropped once per function.
+  Function *CurrentFunction = nullptr;
   unsigned MaxIterationAttempt = 0;
   bool OnlyWarnOnFail = false;
   bool StructurizeLoopExits = false;
@@ -771,6 +774,10 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
   Function *F = L->getHeader()->getParent();
   ScalarEvolution *SE = &getAnalysis<ScalarEvolution>();
   DxilValueCache *DVC = &getAnalysis<DxilValueCache>();
+  if (F != CurrentFunction) {
+    CurrentFunction = F;
+    DVC->ResetUnknowns();
+  }
 
   bool HasExplicitLoopCount = false;
   int ExplicitUnrollCountSigned = 0;
@@ -910,6 +917,7 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
 
       BranchInst::Create(FakeExit, BB);
       for (BasicBlock *Succ : successors(FakeExit)) {
+        DVC->InvalidateBlock(Succ);
         for (Instruction &I : *Succ) {
           if (PHINode *PN = dyn_cast<PHINode>(&I)) {
             for (unsigned i = 0; i < PN->getNumIncomingValues(); i++) {
@@ -945,6 +953,8 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
   SmallVector<std::unique_ptr<ClonedIteration>, 16>
       Iterations; // List of cloned iterations
   bool Succeeded = false;
+  // Blocks outside of the cloned region that gained incoming edges.
+  SmallSetVector<BasicBlock *, 8> ExternalSuccs;
 
   unsigned MaxAttempt = this->MaxIterationAttempt;
   // If we were able to figure out the definitive trip count,
@@ -998,6 +1008,7 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
       for (BasicBlock *Succ : successors(ClonedBB)) {
         if (ToBeCloned.count(Succ))
           continue;
+        ExternalSuccs.insert(Succ);
         for (Instruction &I : *Succ) {
           PHINode *PN = dyn_cast<PHINode>(&I);
           if (!PN)
@@ -1056,6 +1067,7 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
         for (unsigned i = 0; i < BI->getNumSuccessors(); i++) {
           if (BI->getSuccessor(i) == PrevIteration->Header) {
             BI->setSuccessor(i, CurIteration.Header);
+            DVC->Invalidate(BI);
             break;
           }
         }
@@ -1194,7 +1206,18 @@ bool DxilLoopUnroll::runOnLoop(Loop *L, LPPassManager &LPM) {
                      "Could not unroll loop due to out of bound array access.");
     }
 
-    DVC->ResetUnknowns();
+    // Everything that was cloned or erased is already forgotten by the cache.
+    // What's left are the blocks that were edited in place.
+    for (BasicBlock *BB : ExternalSuccs)
+      DVC->InvalidateBlock(BB);
+    if (OuterL) {
+      for (BasicBlock *BB : OuterL->getBlocks())
+        DVC->InvalidateBlock(BB);
+      SmallVector<BasicBlock *, 4> OuterExits;
+      OuterL->getExitBlocks(OuterExits);
+      for (BasicBlock *BB : OuterExits)
+        DVC->InvalidateBlock(BB);
+    }
 
     return true;
   }
@@ -1248,6 +1271,7 @@ bool DxilLoopUnroll::doFinalization() {
     // subsequent runs.
     LoopsThatFailed.clear();
   }
+  CurrentFunction = nullptr;
 
   return false;
 }
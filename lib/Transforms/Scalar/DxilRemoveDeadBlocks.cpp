@@ -11,9 +11,11 @@
 
 #include "llvm/ADT/SetVector.h"
 #include "llvm/Analysis/DxilValueCache.h"
+#include "llvm/Analysis/PostDominators.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DebugInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
@@ -51,6 +53,19 @@ struct DeadBlockDeleter {
 private:
   std::unordered_set<BasicBlock *> Seen;
   std::vector<BasicBlock *> WorkList;
+  // Live blocks whose phis were edited, to be invalidated in the value cache.
+  std::unordered_set<BasicBlock *> EditedBlocks;
+
+  void RemoveIncoming(BasicBlock *SuccBB, BasicBlock *BB) {
+    RemoveIncomingValueFrom(SuccBB, BB);
+    EditedBlocks.insert(SuccBB);
+  }
+  void InvalidateEditedBlocks(DxilValueCache *DVC) {
+    for (BasicBlock *BB : EditedBlocks)
+      if (Seen.count(BB))
+        DVC->InvalidateBlock(BB);
+    EditedBlocks.clear();
+  }
 
   void Add(BasicBlock *BB) {
     if (!Seen.count(BB)) {
@@ -63,6 +78,7 @@ private:
 bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
   Seen.clear();
   WorkList.clear();
+  EditedBlocks.clear();
 
   bool Changed = false;
 
@@ -91,7 +107,7 @@ bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
           if (!Br->getMetadata(hlsl::DXIL::kDxBreakMDName)) {
             BranchInst *NewBr = BranchInst::Create(Succ, BB);
             hlsl::DxilMDHelper::CopyMetadata(*NewBr, *Br);
-            RemoveIncomingValueFrom(NotSucc, BB);
+            RemoveIncoming(NotSucc, BB);
 
             Br->eraseFromParent();
             Br = nullptr;
@@ -118,7 +134,7 @@ bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
         for (unsigned i = 0; i < Switch->getNumSuccessors(); i++) {
           BasicBlock *NotSucc = Switch->getSuccessor(i);
           if (NotSucc != Succ) {
-            RemoveIncomingValueFrom(NotSucc, BB);
+            RemoveIncoming(NotSucc, BB);
           }
         }
 
@@ -133,8 +149,10 @@ bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
     }
   }
 
-  if (Seen.size() == F.size())
+  if (Seen.size() == F.size()) {
+    InvalidateEditedBlocks(DVC);
     return Changed;
+  }
 
   std::vector<BasicBlock *> DeadBlocks;
 
@@ -172,7 +190,7 @@ bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
       BasicBlock *SuccBB = *succ_it;
       if (!Seen.count(SuccBB))
         continue; // Don't bother fixing it if it's gonna get deleted anyway
-      RemoveIncomingValueFrom(SuccBB, BB);
+      RemoveIncoming(SuccBB, BB);
     }
 
     // Erase all instructions in block
@@ -188,7 +206,8 @@ bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
     BB->eraseFromParent();
   }
 
-  DVC->ResetUnknowns();
+  // Erased blocks and instructions have already dropped out of the cache.
+  InvalidateEditedBlocks(DVC);
 
   return true;
 }
@@ -196,6 +215,9 @@ bool DeadBlockDeleter::Run(Function &F, DxilValueCache *DVC) {
 static bool DeleteDeadBlocks(Function &F, DxilValueCache *DVC) {
   DeadBlockDeleter Deleter;
   bool Changed = false;
+  // Drop unknowns left behind by earlier passes; edits made from here on are
+  // invalidated as they happen.
+  DVC->ResetUnknowns();
   constexpr unsigned MaxIteration = 10;
   for (unsigned i = 0; i < MaxIteration; i++) {
     bool LocalChanged = Deleter.Run(F, DVC);
@@ -361,14 +383,27 @@ struct DxilRemoveDeadBlocks : public FunctionPass {
   }
   void getAnalysisUsage(AnalysisUsage &AU) const override {
     AU.addRequired<DxilValueCache>();
+    // Dominator trees computed by earlier passes are kept up to date, so the
+    // region passes that follow do not have to rebuild them.
+    AU.addPreserved<DominatorTreeWrapperPass>();
+    AU.addPreserved<PostDominatorTree>();
   }
   bool runOnFunction(Function &F) override {
     DxilValueCache *DVC = &getAnalysis<DxilValueCache>();
     EnsureDxilModule(F.getParent()); // Ensure dxil module is available for DVC
     bool Changed = false;
     Changed |= hlsl::dxilutil::DeleteDeadAllocas(F);
-    Changed |= DeleteDeadBlocks(F, DVC);
+    bool CFGChanged = DeleteDeadBlocks(F, DVC);
+    Changed |= CFGChanged;
     Changed |= DeleteNonContributingValues(F, DVC);
+
+    // Only deleting blocks changes the CFG.
+    if (CFGChanged) {
+      if (auto *DTWP = getAnalysisIfAvailable<DominatorTreeWrapperPass>())
+        DTWP->getDomTree().recalculate(F);
+      if (auto *PDT = getAnalysisIfAvailable<PostDominatorTree>())
+        PDT->DT->recalculate(F);
+    }
     return Changed;
   }
 };
@@ -606,7 +606,7 @@ struct MemcpySplitter {
 public:
   MemcpySplitter(llvm::LLVMContext &context, DxilTypeSystem &typeSys)
       : m_context(context), m_typeSys(typeSys) {}
-  void Split(llvm::Function &F);
+  void Split(llvm::Module &M);
 
   static void PatchMemCpyWithZeroIdxGEP(Module &M);
   static void PatchMemCpyWithZeroIdxGEP(MemCpyInst *MI, const DataLayout &DL);
@@ -1150,10 +1150,12 @@ void MemcpySplitter::SplitMemCpy(MemCpyInst *MI, const DataLayout &DL,
   DeleteMemcpy(MI);
 }
 
-void MemcpySplitter::Split(llvm::Function &F) {
-  const DataLayout &DL = F.getParent()->getDataLayout();
+// Split the remaining memcpys of every function in a single walk over the
+// memcpy users, rather than rescanning all of them once per function.
+void MemcpySplitter::Split(llvm::Module &M) {
+  const DataLayout &DL = M.getDataLayout();
   SmallVector<Function *, 2> memcpys;
-  for (Function &Fn : F.getParent()->functions()) {
+  for (Function &Fn : M.functions()) {
     if (Fn.getIntrinsicID() == Intrinsic::memcpy) {
       memcpys.emplace_back(&Fn);
     }
@@ -1161,8 +1163,6 @@ void MemcpySplitter::Split(llvm::Function &F) {
   for (Function *memcpy : memcpys) {
     for (auto U = memcpy->user_begin(); U != memcpy->user_end();) {
       MemCpyInst *MI = cast<MemCpyInst>(*(U++));
-      if (MI->getParent()->getParent() != &F)
-        continue;
       // Matrix is treated as scalar type, will not use memcpy.
       // So use nullptr for fieldAnnotation should be safe here.
       SplitMemCpy(MI, DL, /*fieldAnnotation*/ nullptr, m_typeSys,
@@ -1213,11 +1213,17 @@ bool markPrecise(Function &F) {
   return Changed;
 }
 
-bool Cleanup(Function &F, DxilTypeSystem &typeSys) {
+bool Cleanup(Module &M, DxilTypeSystem &typeSys) {
   // change rest memcpy into ld/st.
-  MemcpySplitter splitter(F.getContext(), typeSys);
-  splitter.Split(F);
-  return markPrecise(F);
+  MemcpySplitter splitter(M.getContext(), typeSys);
+  splitter.Split(M);
+  bool Changed = false;
+  for (Function &F : M) {
+    if (F.isDeclaration())
+      continue;
+    Changed |= markPrecise(F);
+  }
+  return Changed;
 }
 } // namespace
 
@@ -1762,12 +1768,20 @@ bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo) {
   for (GlobalVariable *GV : staticGVs)
     WorkList.push(GV);
 
+  // Dominator trees are only built for functions with allocas that reach
+  // LowerMemcpy. SROA does not change the CFG, so each tree stays valid.
   DenseMap<Function *, DominatorTree> domTreeMap;
+  auto getDomTree = [&domTreeMap](Function *F) -> DominatorTree & {
+    auto It = domTreeMap.find(F);
+    if (It != domTreeMap.end())
+      return It->second;
+    DominatorTree &DT = domTreeMap[F];
+    DT.recalculate(*F);
+    return DT;
+  };
   for (Function &F : M) {
     if (F.isDeclaration())
       continue;
-    // Collect domTree.
-    domTreeMap[&F].recalculate(F);
 
     // Scan the entry basic block, adding allocas to the worklist.
     BasicBlock &BB = F.getEntryBlock();
@@ -1810,7 +1824,7 @@ bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo) {
       }
       Function *F = AI->getParent()->getParent();
       const bool bAllowReplace = true;
-      DominatorTree &DT = domTreeMap[F];
+      DominatorTree &DT = getDomTree(F);
       if (SROA_Helper::LowerMemcpy(AI, /*annotation*/ nullptr, typeSys, DL, &DT,
                                    bAllowReplace)) {
         if (AI->use_empty())
@@ -2030,11 +2044,7 @@ bool SROAGlobalAndAllocas(HLModule &HLM, bool bHasDbgInfo) {
   // Remove unused internal global.
   RemoveUnusedInternalGlobalVariable(M);
   // Cleanup memcpy for allocas and mark precise.
-  for (Function &F : M) {
-    if (F.isDeclaration())
-      continue;
-    Cleanup(F, typeSys);
-  }
+  Cleanup(M, typeSys);
 
   return true;
 }
@@ -17,6 +17,7 @@
 #include "InitListHandler.h"
 #include "LowerTypeVisitor.h"
 #include "RawBufferMethods.h"
+#include "SpirvOptimizerCache.h"
 #include "dxc/DXIL/DxilConstants.h"
 #include "dxc/HlslIntrinsicOp.h"
 #include "spirv-tools/optimizer.hpp"
@@ -647,7 +648,9 @@ SpirvEmitter::SpirvEmitter(CompilerInstance &ci)
   spvContext.setMinorVersion(shaderModel->GetMinor());
   spirvOptions.signaturePacking =
       ci.getCodeGenOpts().HLSLSignaturePackingStrategy ==
-      (unsigned)hlsl::DXIL::PackingStrategy::Optimized;
+          (unsigned)hlsl::DXIL::PackingStrategy::Optimized ||
+      ci.getCodeGenOpts().HLSLSignaturePackingStrategy ==
+          (unsigned)hlsl::DXIL::PackingStrategy::MinimalRows;
 
   if (spirvOptions.useDxLayout) {
     spirvOptions.cBufferLayoutRule = SpirvLayoutRule::FxcCTBuffer;
@@ -931,36 +934,33 @@ void SpirvEmitter::HandleTranslationUnit(ASTContext &context) {
       }
     }
 
-    if (theCompilerInstance.getCodeGenOpts().OptimizationLevel > 0) {
-      // Run optimization passes
-      std::string messages;
-      if (!spirvToolsOptimize(&m, &messages)) {
-        emitFatalError("failed to optimize SPIR-V: %0", {}) << messages;
-        emitNote("please file a bug report on "
-                 "https://github.com/Microsoft/DirectXShaderCompiler/issues "
-                 "with source code if possible",
-                 {});
-        return;
-      }
-    }
-
-    // Trim unused capabilities.
-    // When optimizations are enabled, some optimization passes like DCE could
-    // make some capabilities useless. To avoid logic duplication between this
-    // pass, and DXC, DXC generates some capabilities unconditionally. This
-    // means we should run this pass, even when optimizations are disabled.
-    {
-      std::string messages;
-      if (!spirvToolsTrimCapabilities(&m, &messages)) {
-        emitFatalError("failed to trim capabilities: %0", {}) << messages;
-        emitNote("please file a bug report on "
-                 "https://github.com/Microsoft/DirectXShaderCompiler/issues "
-                 "with source code if possible",
-                 {});
-        return;
-      } else if (!messages.empty()) {
-        emitWarning("SPIR-V capability trimming: %0", {}) << messages;
+    // Optimization and capability trimming only depend on the legalized
+    // module and the optimizer configuration, so permutations that legalize to
+    // identical SPIR-V can reuse an earlier result.
+    if (spirvOptions.enableOptCache && !spirvOptions.printAll) {
+      const std::string config = getOptimizerCacheConfig();
+      std::vector<uint32_t> cached;
+      bool fromDisk = false;
+      const bool hit = SpirvOptimizerCache::lookup(
+          m, config, spirvOptions.optCacheDir, &cached, &fromDisk);
+      if (spirvOptions.reportOptCache)
+        emitRemark("SPIR-V optimizer cache %0", {})
+            << (!hit ? "miss" : fromDisk ? "hit (disk)" : "hit (memory)");
+      if (hit) {
+        m.swap(cached);
+      } else {
+        const std::vector<uint32_t> legalized = m;
+        bool hasWarnings = false;
+        if (!spirvToolsOptimizeAndTrim(&m, &hasWarnings))
+          return;
+        // Do not cache results that produced warnings, or later hits would
+        // silently drop them.
+        if (!hasWarnings)
+          SpirvOptimizerCache::insert(legalized, config,
+                                      spirvOptions.optCacheDir, m);
       }
+    } else if (!spirvToolsOptimizeAndTrim(&m, nullptr)) {
+      return;
     }
   }
 
@@ -14481,6 +14481,59 @@ SpirvEmitter::createFunctionScopeTempFromParameter(const ParmVarDecl *param) {
   return tempVar;
 }
 
+bool SpirvEmitter::spirvToolsOptimizeAndTrim(std::vector<uint32_t> *mod,
+                                             bool *hasWarnings) {
+  if (theCompilerInstance.getCodeGenOpts().OptimizationLevel > 0) {
+    // Run optimization passes
+    std::string messages;
+    if (!spirvToolsOptimize(mod, &messages)) {
+      emitFatalError("failed to optimize SPIR-V: %0", {}) << messages;
+      emitNote("please file a bug report on "
+               "https://github.com/Microsoft/DirectXShaderCompiler/issues "
+               "with source code if possible",
+               {});
+      return false;
+    }
+  }
+
+  // Trim unused capabilities.
+  // When optimizations are enabled, some optimization passes like DCE could
+  // make some capabilities useless. To avoid logic duplication between this
+  // pass, and DXC, DXC generates some capabilities unconditionally. This
+  // means we should run this pass, even when optimizations are disabled.
+  {
+    std::string messages;
+    if (!spirvToolsTrimCapabilities(mod, &messages)) {
+      emitFatalError("failed to trim capabilities: %0", {}) << messages;
+      emitNote("please file a bug report on "
+               "https://github.com/Microsoft/DirectXShaderCompiler/issues "
+               "with source code if possible",
+               {});
+      return false;
+    } else if (!messages.empty()) {
+      emitWarning("SPIR-V capability trimming: %0", {}) << messages;
+      if (hasWarnings)
+        *hasWarnings = true;
+    }
+  }
+
+  return true;
+}
+
+std::string SpirvEmitter::getOptimizerCacheConfig() {
+  std::string config;
+  llvm::raw_string_ostream os(config);
+  os << "commit=" << clang::getGitCommitHash()
+     << ";env=" << spirvOptions.targetEnv
+     << ";O=" << theCompilerInstance.getCodeGenOpts().OptimizationLevel
+     << ";preserveBindings=" << spirvOptions.preserveBindings
+     << ";preserveInterface=" << spirvOptions.preserveInterface
+     << ";Oconfig=";
+  for (const auto &flag : spirvOptions.optConfig)
+    os << flag << ",";
+  return os.str();
+}
+
 bool SpirvEmitter::spirvToolsTrimCapabilities(std::vector<uint32_t> *mod,
                                               std::string *messages) {
   spvtools::Optimizer optimizer(featureManager.getTargetEnv());
@@ -1206,6 +1206,16 @@ private:
   /// Returns true on success and false otherwise.
   bool spirvToolsOptimize(std::vector<uint32_t> *mod, std::string *messages);
 
+  /// \brief Runs the optimization recipe (if optimizations are enabled)
+  /// followed by capability trimming on |mod|, emitting diagnostics for any
+  /// failure. Sets |hasWarnings| (if not null) when warnings were emitted.
+  /// Returns true on success and false otherwise.
+  bool spirvToolsOptimizeAndTrim(std::vector<uint32_t> *mod, bool *hasWarnings);
+
+  /// \brief Returns a string describing every setting that affects the result
+  /// of spirvToolsOptimizeAndTrim(), used to key the optimizer cache.
+  std::string getOptimizerCacheConfig();
+
   // \brief Calls SPIRV-Tools optimizer's, but only with the capability trimming
   // pass. Removes unused capabilities from the given SPIR-V module |mod|, and
   // returns info/warning/error messages via |messages|. This pass doesn't trim
@@ -1286,6 +1296,15 @@ public:
     return diags.Report(loc, diagId);
   }
 
+  /// \brief Wrapper method to create a remark message and report it
+  /// in the diagnostic engine associated with this consumer
+  template <unsigned N>
+  DiagnosticBuilder emitRemark(const char (&message)[N], SourceLocation loc) {
+    const auto diagId =
+        diags.getCustomDiagID(clang::DiagnosticsEngine::Remark, message);
+    return diags.Report(loc, diagId);
+  }
+
 private:
   CompilerInstance &theCompilerInstance;
   ASTContext &astContext;
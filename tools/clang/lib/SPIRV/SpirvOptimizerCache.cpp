@@ -0,0 +1,261 @@
+//===--- SpirvOptimizerCache.cpp - SPIRV-Tools result cache impl -*- C++ -*-==//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "SpirvOptimizerCache.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "dxc/Support/WinIncludes.h"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MSFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+namespace clang {
+namespace spirv {
+
+namespace {
+
+/// Magic and version for on-disk cache entries. Bump the version whenever the
+/// layout of an entry changes so stale files are ignored.
+const uint32_t kDiskEntryMagic = 0x43565053; // 'SPVC'
+const uint32_t kDiskEntryVersion = 1;
+
+/// Upper bound on the total number of words held by the in-memory cache. When
+/// it is exceeded, the cache is flushed rather than growing without bound in
+/// long-lived processes.
+const size_t kMaxInMemoryWords = 64 * 1024 * 1024;
+
+struct CacheEntry {
+  std::string config;
+  std::vector<uint32_t> input;
+  std::vector<uint32_t> output;
+};
+
+struct CacheState {
+  std::mutex lock;
+  std::unordered_multimap<uint64_t, CacheEntry> entries;
+  size_t totalWords = 0;
+};
+
+CacheState &getCacheState() {
+  static CacheState state;
+  return state;
+}
+
+/// FNV-1a over the configuration string followed by the module words. Unlike
+/// llvm::hash_code, the result is stable across processes, which is required
+/// for the on-disk cache file names.
+uint64_t hashKey(const std::vector<uint32_t> &input, llvm::StringRef config) {
+  const uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : config) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= kPrime;
+  }
+  // Separator so that a configuration can never alias the first input word.
+  hash ^= 0xff;
+  hash *= kPrime;
+  for (uint32_t word : input) {
+    hash ^= word;
+    hash *= kPrime;
+  }
+  return hash;
+}
+
+std::string getDiskEntryPath(llvm::StringRef cacheDir, uint64_t hash) {
+  std::string path;
+  llvm::raw_string_ostream os(path);
+  os << cacheDir;
+  if (!cacheDir.endswith("/") && !cacheDir.endswith("\\"))
+    os << "/";
+  os << llvm::format_hex_no_prefix(hash, 16) << ".spvcache";
+  return os.str();
+}
+
+template <typename T> bool readPod(std::istream &is, T *value) {
+  return static_cast<bool>(
+      is.read(reinterpret_cast<char *>(value), sizeof(T)));
+}
+
+template <typename T> void writePod(llvm::raw_ostream &os, const T &value) {
+  os.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+bool readDiskEntry(const std::string &path, const std::vector<uint32_t> &input,
+                   llvm::StringRef config, std::vector<uint32_t> *output) {
+  std::ifstream is(path, std::ios::binary);
+  if (!is)
+    return false;
+
+  uint32_t magic = 0, version = 0, configSize = 0;
+  uint64_t inputWords = 0, outputWords = 0;
+  if (!readPod(is, &magic) || magic != kDiskEntryMagic ||
+      !readPod(is, &version) || version != kDiskEntryVersion ||
+      !readPod(is, &configSize) || configSize != config.size() ||
+      !readPod(is, &inputWords) || inputWords != input.size() ||
+      !readPod(is, &outputWords))
+    return false;
+
+  std::string storedConfig(configSize, '\0');
+  if (configSize && !is.read(&storedConfig[0], configSize))
+    return false;
+  if (storedConfig != config)
+    return false;
+
+  std::vector<uint32_t> storedInput(inputWords);
+  if (inputWords && !is.read(reinterpret_cast<char *>(storedInput.data()),
+                             inputWords * sizeof(uint32_t)))
+    return false;
+  if (storedInput != input)
+    return false;
+
+  std::vector<uint32_t> storedOutput(outputWords);
+  if (outputWords && !is.read(reinterpret_cast<char *>(storedOutput.data()),
+                              outputWords * sizeof(uint32_t)))
+    return false;
+
+  output->swap(storedOutput);
+  return true;
+}
+
+void writeDiskEntry(const std::string &path, const std::vector<uint32_t> &input,
+                    llvm::StringRef config,
+                    const std::vector<uint32_t> &output) {
+  // The file system of a compilation only serves its own inputs and outputs,
+  // so the cache directory is written through the disk file system.
+  llvm::sys::fs::MSFileSystem *msfPtr = nullptr;
+  if (FAILED(CreateMSFileSystemForDisk(&msfPtr)))
+    return;
+  std::unique_ptr<llvm::sys::fs::MSFileSystem> msf(msfPtr);
+  llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
+  if (pts.error_code())
+    return;
+
+  // Write to a uniquely named temporary file, then rename it over the entry.
+  // The rename replaces an existing entry atomically, so concurrent compilers
+  // see either the old entry or the complete new one.
+  int fd = -1;
+  llvm::SmallString<128> tmpPath;
+  if (llvm::sys::fs::createUniqueFile(path + ".%%%%%%%%.tmp", fd, tmpPath))
+    return;
+
+  bool written = false;
+  {
+    llvm::raw_fd_ostream os(fd, /*shouldClose*/ true);
+    writePod(os, kDiskEntryMagic);
+    writePod(os, kDiskEntryVersion);
+    writePod(os, static_cast<uint32_t>(config.size()));
+    writePod(os, static_cast<uint64_t>(input.size()));
+    writePod(os, static_cast<uint64_t>(output.size()));
+    os.write(config.data(), config.size());
+    os.write(reinterpret_cast<const char *>(input.data()),
+             input.size() * sizeof(uint32_t));
+    os.write(reinterpret_cast<const char *>(output.data()),
+             output.size() * sizeof(uint32_t));
+    os.close();
+    written = !os.has_error();
+    os.clear_error();
+  }
+
+  if (!written || llvm::sys::fs::rename(tmpPath, path))
+    llvm::sys::fs::remove(tmpPath);
+}
+
+void insertInMemory(CacheState &state, uint64_t hash,
+                    const std::vector<uint32_t> &input,
+                    llvm::StringRef config,
+                    const std::vector<uint32_t> &output) {
+  auto range = state.entries.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.config == config && it->second.input == input)
+      return;
+  }
+
+  const size_t words = input.size() + output.size();
+  if (state.totalWords + words > kMaxInMemoryWords) {
+    state.entries.clear();
+    state.totalWords = 0;
+  }
+
+  CacheEntry entry;
+  entry.config = config;
+  entry.input = input;
+  entry.output = output;
+  state.entries.emplace(hash, std::move(entry));
+  state.totalWords += words;
+}
+
+} // namespace
+
+bool SpirvOptimizerCache::lookup(const std::vector<uint32_t> &input,
+                                 llvm::StringRef config,
+                                 llvm::StringRef cacheDir,
+                                 std::vector<uint32_t> *output,
+                                 bool *fromDisk) {
+  const uint64_t hash = hashKey(input, config);
+  CacheState &state = getCacheState();
+  if (fromDisk)
+    *fromDisk = false;
+
+  {
+    std::lock_guard<std::mutex> guard(state.lock);
+    auto range = state.entries.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second.config == config && it->second.input == input) {
+        *output = it->second.output;
+        return true;
+      }
+    }
+  }
+
+  if (cacheDir.empty())
+    return false;
+
+  if (!readDiskEntry(getDiskEntryPath(cacheDir, hash), input, config, output))
+    return false;
+
+  if (fromDisk)
+    *fromDisk = true;
+
+  // Promote the disk entry so later compiles in this process skip the I/O.
+  std::lock_guard<std::mutex> guard(state.lock);
+  insertInMemory(state, hash, input, config, *output);
+  return true;
+}
+
+void SpirvOptimizerCache::insert(const std::vector<uint32_t> &input,
+                                 llvm::StringRef config,
+                                 llvm::StringRef cacheDir,
+                                 const std::vector<uint32_t> &output) {
+  const uint64_t hash = hashKey(input, config);
+  CacheState &state = getCacheState();
+  {
+    std::lock_guard<std::mutex> guard(state.lock);
+    insertInMemory(state, hash, input, config, output);
+  }
+
+  if (!cacheDir.empty())
+    writeDiskEntry(getDiskEntryPath(cacheDir, hash), input, config, output);
+}
+
+void SpirvOptimizerCache::clear() {
+  CacheState &state = getCacheState();
+  std::lock_guard<std::mutex> guard(state.lock);
+  state.entries.clear();
+  state.totalWords = 0;
+}
+
+} // end namespace spirv
+} // end namespace clang
@@ -0,0 +1,61 @@
+//===--- SpirvOptimizerCache.h - Cache for SPIRV-Tools optimizer results --===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+//  This file defines a cache that memoizes the result of running the
+//  SPIRV-Tools optimizer (and capability trimming) over a legalized SPIR-V
+//  module. Many shader permutations only differ in dead code and end up with
+//  identical legalized SPIR-V, so the expensive optimization recipe only needs
+//  to run once per unique input.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_CLANG_LIB_SPIRV_SPIRVOPTIMIZERCACHE_H
+#define LLVM_CLANG_LIB_SPIRV_SPIRVOPTIMIZERCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+namespace clang {
+namespace spirv {
+
+/// \brief Process-wide cache of optimized SPIR-V modules.
+///
+/// Entries are keyed by a 64-bit hash of the input words and a string that
+/// describes the optimizer configuration. The full input and configuration are
+/// stored alongside each entry and compared on lookup, so hash collisions can
+/// never return a wrong module. If a cache directory is given, entries are
+/// also persisted to and loaded from disk, one file per key.
+class SpirvOptimizerCache {
+public:
+  /// \brief Looks up the optimized module for |input| compiled with |config|.
+  /// Returns true and writes the cached result to |output| on a hit.
+  /// |cacheDir| may be empty to only consult the in-memory cache. If
+  /// |fromDisk| is not null, it is set to whether a hit was read from disk.
+  static bool lookup(const std::vector<uint32_t> &input,
+                     llvm::StringRef config, llvm::StringRef cacheDir,
+                     std::vector<uint32_t> *output, bool *fromDisk = nullptr);
+
+  /// \brief Records |output| as the optimized module for |input| compiled with
+  /// |config|. If |cacheDir| is not empty, the entry is also written to disk.
+  /// Failing to write the disk entry is not an error.
+  static void insert(const std::vector<uint32_t> &input,
+                     llvm::StringRef config, llvm::StringRef cacheDir,
+                     const std::vector<uint32_t> &output);
+
+  /// \brief Drops all in-memory entries. Disk entries are left untouched.
+  static void clear();
+};
+
+} // end namespace spirv
+} // end namespace clang
+
+#endif // LLVM_CLANG_LIB_SPIRV_SPIRVOPTIMIZERCACHE_H
@@ -0,0 +1,37 @@
+// RUN: %dxc -T ps_6_0 -E main -fspv-opt-cache %s -spirv | FileCheck %s
+// RUN: %dxc -T ps_6_0 -E main -fspv-opt-cache -DUNUSED_DEFINE %s -spirv | FileCheck %s
+
+// Both compiles share one on-disk cache. The second one runs in a new process
+// and legalizes to the same module, so it must be served from disk.
+// RUN: rm -rf %t.cache && mkdir %t.cache
+// RUN: %dxc -T ps_6_0 -E main -fspv-opt-cache-dir=%t.cache -fspv-opt-cache-report %s -spirv 2>&1 | FileCheck %s --check-prefixes=CHECK,MISS
+// RUN: %dxc -T ps_6_0 -E main -fspv-opt-cache-dir=%t.cache -fspv-opt-cache-report -DUNUSED_DEFINE %s -spirv 2>&1 | FileCheck %s --check-prefixes=CHECK,HIT
+
+// The entry is published by renaming a temporary file, which must not be left
+// behind. A third process hits the same entry.
+// RUN: ls %t.cache | FileCheck %s --check-prefix=FILES
+// RUN: %dxc -T ps_6_0 -E main -fspv-opt-cache-dir=%t.cache -fspv-opt-cache-report %s -spirv 2>&1 | FileCheck %s --check-prefixes=CHECK,HIT
+
+// The optimizer cache must not change the optimized output. Both permutations
+// legalize to the same module, so the second one may be served from the cache.
+
+// FILES:     {{^[0-9a-f]+\.spvcache$}}
+// FILES-NOT: tmp
+
+// MISS:      remark: SPIR-V optimizer cache miss
+// HIT:       remark: SPIR-V optimizer cache hit (disk)
+// CHECK:     OpEntryPoint Fragment %main "main"
+// CHECK:     [[color:%[0-9]+]] = OpLoad %v4float %in_var_COLOR
+// CHECK:     OpStore %out_var_SV_Target [[color]]
+// CHECK-NOT: OpFunctionCall
+
+float4 helper(float4 c) {
+#ifdef UNUSED_DEFINE
+  float4 unused = c * 2;
+#endif
+  return c;
+}
+
+float4 main(float4 color : COLOR) : SV_Target {
+  return helper(color);
+}
@@ -0,0 +1,23 @@
+// Vertex and pixel shader pair where the pixel shader reads only some of the
+// vertex shader outputs.
+
+struct VSOut {
+  float4 pos : SV_Position;
+  float3 normal : NORMAL;
+  float4 color : COLOR;
+  float2 uv : TEXCOORD0;
+};
+
+VSOut VSMain(float4 pos : POSITION, float3 normal : NORMAL,
+             float4 color : COLOR, float2 uv : TEXCOORD0) {
+  VSOut o;
+  o.pos = pos;
+  o.normal = normal;
+  o.color = color;
+  o.uv = uv;
+  return o;
+}
+
+float4 PSMain(VSOut i) : SV_Target {
+  return i.color * i.uv.x;
+}
@@ -0,0 +1,23 @@
+// RUN: %dxc -T lib_6_3 %s -Fo %t.dxil
+// RUN: %dxc -dumpbin %t.dxil | FileCheck %s --check-prefix=ALL
+// RUN: %dxc -dumpbin %t.dxil -disasm-threads 4 | FileCheck %s --check-prefix=ALL
+// RUN: %dxc -dumpbin %t.dxil -disasm-function bar | FileCheck %s --check-prefix=BAR
+// RUN: %dxc -dumpbin %t.dxil -disasm-function bar -disasm-function foo -disasm-threads 0 | FileCheck %s --check-prefix=ALL
+
+// Function bodies are printed in module order whatever the thread count.
+// ALL: define {{.*}}foo
+// ALL: fmul
+// ALL: define {{.*}}bar
+// ALL: fadd
+// ALL: !dx.version
+
+// Only the requested definition is printed; metadata is unchanged.
+// BAR-NOT: define {{.*}}foo
+// BAR: define {{.*}}bar
+// BAR: fadd
+// BAR-NOT: define
+// BAR: !dx.version
+
+export float foo(float a, float b) { return a * b; }
+
+export float bar(float a, float b) { return a + b; }
@@ -0,0 +1,18 @@
+// The linker skips debug info in the program part of a library that also has
+// a debug part, but the debug part is linked with all of its debug info.
+// RUN: %dxc -T lib_6_3 %s /Zi /Qembed_debug -Fo %t.lib.dxbc
+// RUN: %dxl -T ps_6_0 %t.lib.dxbc -Fo %t.linked.dxbc
+// RUN: %dxa %t.linked.dxbc -extractpart dbgmodule -o %t.linked.bc
+// RUN: %dxc -dumpbin %t.linked.bc | FileCheck %s
+
+// CHECK: define void @main()
+// CHECK: call void @llvm.dbg.{{value|declare}}
+// CHECK: !llvm.dbg.cu = !{
+// CHECK: distinct !DICompileUnit(
+// CHECK: !DISubprogram(name: "main"
+
+[shader("pixel")]
+float4 main(float4 c : COLOR) : SV_Target {
+  float4 r = c * 2;
+  return r;
+}
@@ -0,0 +1,19 @@
+// Shaders sharing a root signature within one process are still each checked
+// against it, whether or not the root signature was verified before.
+// RUN: echo "%s -T ps_6_0 -D REG=t0 -Fo %t.0.cso" > %t.batch.txt
+// RUN: echo "%s -T ps_6_0 -D REG=t7 -Fo %t.7.cso" >> %t.batch.txt
+// RUN: echo "%s -T ps_6_0 -D REG=t3 -Fo %t.3.cso" >> %t.batch.txt
+// RUN: not %dxc -batch %t.batch.txt -j 1 2>&1 | FileCheck %s
+// CHECK: batch.txt(2):
+// CHECK: Shader SRV descriptor range (RegisterSpace=0, NumDescriptors=1, BaseShaderRegister=7) is not fully bound in root signature.
+// CHECK: dxc failed : 1 of 3 batch entries failed.
+
+// RUN: %dxc -dumpbin %t.3.cso | FileCheck %s --check-prefix=OK
+// OK: define void @main()
+
+Texture2D<float4> tex : register(REG);
+
+[RootSignature("DescriptorTable(SRV(t0, numDescriptors=4))")]
+float4 main(float4 pos : SV_Position) : SV_Target {
+  return tex.Load(int3(pos.xy, 0));
+}
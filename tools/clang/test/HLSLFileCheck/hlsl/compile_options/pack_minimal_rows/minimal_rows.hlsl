@@ -0,0 +1,44 @@
+// RUN: %dxc -E main -T ps_6_0 -pack-minimal-rows %s | FileCheck %s
+// RUN: %dxc -E main -T ps_6_0 -pack-optimized %s | FileCheck %s -check-prefix=OPT
+
+// Greedy packing puts A and B beside E, leaving one free component in each of
+// rows 0 to 2, so F needs a row of its own and 5 rows are used. Putting F
+// beside E and moving A down a row fits everything in 4 rows.
+
+// CHECK:      ; Input signature:
+// CHECK:      ; Name                 Index   Mask Register SysValue  Format   Used
+// CHECK-NEXT: ; -------------------- ----- ------ -------- -------- ------- ------
+// CHECK-NEXT: ; E 0 xy 0 NONE float
+// CHECK-NEXT: ; F 0 zw 0 NONE float
+// CHECK-NEXT: ; E 1 xy 1 NONE float
+// CHECK-NEXT: ; A 0 w 1 NONE float
+// CHECK-NEXT: ; B 0 z 1 NONE float
+// CHECK-NEXT: ; A 1 w 2 NONE float
+// CHECK-NEXT: ; D 0 xyz 2 NONE float
+// CHECK-NEXT: ; C 0 x 3 NONE float
+
+// OPT:      ; Input signature:
+// OPT:      ; Name                 Index   Mask Register SysValue  Format   Used
+// OPT-NEXT: ; -------------------- ----- ------ -------- -------- ------- ------
+// OPT-NEXT: ; E 0 xy 0 NONE float
+// OPT-NEXT: ; A 0 z 0 NONE float
+// OPT-NEXT: ; B 0 w 0 NONE float
+// OPT-NEXT: ; E 1 xy 1 NONE float
+// OPT-NEXT: ; A 1 z 1 NONE float
+// OPT-NEXT: ; D 0 xyz 2 NONE float
+// OPT-NEXT: ; F 0 xy 3 NONE float
+// OPT-NEXT: ; C 0 x 4 NONE float
+
+struct PS_IN {
+  float2 e[2] : E;
+  float a[2] : A;
+  float3 d : D;
+  float2 f : F;
+  float b : B;
+  centroid float c : C;
+};
+
+float4 main(PS_IN i) : SV_Target {
+  return float4(i.e[0] + i.e[1], i.a[0] + i.a[1], i.f.x) +
+         float4(i.d, i.b) + i.c;
+}
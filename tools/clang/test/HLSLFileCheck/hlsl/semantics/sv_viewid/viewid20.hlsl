@@ -0,0 +1,27 @@
+// RUN: %dxilver 1.1 | %dxc -E main -T vs_6_1 %s | FileCheck %s
+
+// Contributions flowing around a loop-carried cycle of phis.
+
+// CHECK: Number of inputs: 9, outputs: 5
+// CHECK: Outputs dependent on ViewId: { 4 }
+// CHECK: Inputs contributing to computation of Outputs:
+// CHECK:   output 0 depends on inputs: { 0, 1, 2, 3, 4, 8 }
+// CHECK:   output 1 depends on inputs: { 0, 1, 2, 3, 4, 8 }
+// CHECK:   output 2 depends on inputs: { 0, 1, 2, 3, 4, 8 }
+// CHECK:   output 3 depends on inputs: { 0, 1, 2, 3, 4, 8 }
+// CHECK:   output 4 depends on inputs: { 0 }
+
+struct VSOut {
+  float4 pos : SV_Position;
+  float o : O;
+};
+
+VSOut main(float4 a : A, float4 b : B, uint n : N, uint vid : SV_ViewID) {
+  VSOut r;
+  float4 acc = a;
+  for (uint i = 0; i < n; ++i)
+    acc = acc.yzwx + b.x;
+  r.pos = acc;
+  r.o = a.x + vid;
+  return r;
+}
@@ -0,0 +1,46 @@
+; RUN: %opt %s -dxil-gvn-eliminate-region -dce -dxil-remove-dead-blocks -dxil-erase-dead-region -S | FileCheck %s
+; RUN: %opt %s -opt-stats -dxil-gvn-eliminate-region -dce -dxil-remove-dead-blocks -dxil-erase-dead-region | FileCheck %s --check-prefix=STATS --implicit-check-not="pass domtree" --implicit-check-not="pass postdomtree"
+
+; The -Od cleanup passes keep the dominator trees they are given, and only
+; recompute them after changing the CFG. Nothing here can be folded, so the
+; function comes out with the same blocks, and no pass has to rebuild a tree.
+; -opt-stats gives each pass instance its own line, so a tree built a second
+; time would show up twice.
+
+; CHECK-LABEL: define float @main(
+; CHECK: entry:
+; CHECK-NEXT: br i1 %cond, label %then, label %else
+; CHECK: then:
+; CHECK-NEXT: %x = fadd float %a, %b
+; CHECK-NEXT: br label %end
+; CHECK: else:
+; CHECK-NEXT: %y = fmul float %a, %b
+; CHECK-NEXT: br label %end
+; CHECK: end:
+; CHECK-NEXT: %r = phi float [ %x, %then ], [ %y, %else ]
+; CHECK-NEXT: ret float %r
+
+; STATS: OPT-STATS: instructions 7 7
+; STATS: OPT-STATS: pass postdomtree
+; STATS: OPT-STATS: pass domtree
+; STATS: OPT-STATS: pass dxil-erase-dead-region
+
+target datalayout = "e-m:e-p:32:32-i1:32-i8:32-i16:32-i32:32-i64:64-f16:32-f32:32-f64:64-n8:16:32:64"
+target triple = "dxil-ms-dx"
+
+define float @main(i1 %cond, float %a, float %b) {
+entry:
+  br i1 %cond, label %then, label %else
+
+then:
+  %x = fadd float %a, %b
+  br label %end
+
+else:
+  %y = fmul float %a, %b
+  br label %end
+
+end:
+  %r = phi float [ %x, %then ], [ %y, %else ]
+  ret float %r
+}
@@ -0,0 +1,37 @@
+// RUN: %dxc -ECSMain -Tcs_6_0 %s | %opt -S -hlsl-dxil-pix-shader-access-instrumentation,config=S0:1:1i1;U0:2:10i0;.0;0;0.,waveAggregate=1 | %FileCheck %s
+
+// The read of inBuffer always lands in the same record, so only the first lane
+// of the wave writes it:
+// CHECK: %IsFirstLane{{[0-9]*}} = call i1 @dx.op.waveIsFirstLane(i32 110)
+// CHECK: br i1 %IsFirstLane{{[0-9]*}}, label %PIXAccessTrackingStore{{[.0-9]*}}, label %PIXAccessTrackingTail{{[.0-9]*}}
+// CHECK: PIXAccessTrackingStore{{[.0-9]*}}:
+// CHECK-NEXT: call void @dx.op.bufferStore.i32(i32 69, %dx.types.Handle %PIX_CountUAV_Handle, i32 12, i32 undef, i32 1
+// CHECK: call %dx.types.ResRet.i32 @dx.op.bufferLoad.i32(i32 68
+
+// The dynamically indexed write is stored by the first lane and by the lanes
+// that access some other element of bufferArray:
+// CHECK: %slotIndex = mul i32
+// CHECK: %OffsetByteIndex = add i32 %slotIndex, 4
+// CHECK: %IsFirstLane{{[0-9]*}} = call i1 @dx.op.waveIsFirstLane(i32 110)
+// CHECK: %WaveFirstByteOffset = call i32 @dx.op.waveReadLaneFirst.i32(i32 118, i32 %OffsetByteIndex)
+// CHECK: %DiffersFromFirstLane = icmp ne i32 %OffsetByteIndex, %WaveFirstByteOffset
+// CHECK: %ShouldStore = or i1 %IsFirstLane{{[0-9]*}}, %DiffersFromFirstLane
+// CHECK: br i1 %ShouldStore, label %PIXAccessTrackingStore{{[.0-9]*}}, label %PIXAccessTrackingTail{{[.0-9]*}}
+// CHECK: PIXAccessTrackingStore{{[.0-9]*}}:
+// CHECK-NEXT: call void @dx.op.bufferStore.i32(i32 69, %dx.types.Handle %PIX_CountUAV_Handle, i32 %OffsetByteIndex, i32 undef, i32 1
+// CHECK: PIXAccessTrackingTail{{[.0-9]*}}:
+// CHECK: ret void
+
+
+ByteAddressBuffer inBuffer : register(t0);
+RWByteAddressBuffer bufferArray[] : register(u0);
+
+[numthreads(64, 1, 1)]
+void CSMain()
+{
+  // Simple read
+  uint dynamicBufferIndex = inBuffer.Load(0);
+
+  // Dynamically indexed write
+  bufferArray[dynamicBufferIndex].Store(0, 1);
+}
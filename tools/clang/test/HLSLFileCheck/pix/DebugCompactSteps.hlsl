@@ -0,0 +1,25 @@
+// RUN: %dxc -Emain -Tps_6_0 %s | %opt -S -dxil-annotate-with-virtual-regs -hlsl-dxil-debug-instrumentation,CompactSteps=1 | %FileCheck %s
+
+// Check that compact step records are written. The instructions are numbered
+// loadInput: 0, fmul: 1, storeOutput: 2, ret: 3.
+
+// The loadInput step: three dwords, since the value ordinal is the register
+// of the instruction, with the absolute instruction number 0 in the header
+// (Flags 1, Type 246, SizeDwords 1):
+// CHECK: mul i32 12, %OffsetMultiplicand
+// CHECK: call void @dx.op.bufferStore.i32(i32 69, %dx.types.Handle %PIX_DebugUAV_Handle, i32 %{{.*}}, i32 undef, i32 62993,
+// CHECK: call void @dx.op.bufferStore.i32(i32 69, %dx.types.Handle %PIX_DebugUAV_Handle, i32 %{{.*}}, i32 undef, i32 %UAVIncResult,
+// CHECK: call void @dx.op.bufferStore.f32(i32 69, %dx.types.Handle %PIX_DebugUAV_Handle, i32 %{{.*}}, i32 undef, float %{{[0-9]+}},
+
+// The fmul step is one instruction after the loadInput (Flags 0):
+// CHECK: mul i32 12, %OffsetMultiplicand
+// CHECK: call void @dx.op.bufferStore.i32(i32 69, %dx.types.Handle %PIX_DebugUAV_Handle, i32 %{{.*}}, i32 undef, i32 128513,
+
+// The ret is two instructions after the fmul (Type 244, SizeDwords 0):
+// CHECK: call void @dx.op.bufferStore.i32(i32 69, %dx.types.Handle %PIX_DebugUAV_Handle, i32 %{{.*}}, i32 undef, i32 193536,
+// CHECK: ret void
+
+
+float main(float a : A) : SV_Target {
+  return a * 3;
+}
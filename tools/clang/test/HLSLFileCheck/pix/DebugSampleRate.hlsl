@@ -0,0 +1,21 @@
+// RUN: %dxc -Emain -Tcs_6_0 %s | %opt -S -hlsl-dxil-debug-instrumentation,parameter0=10,parameter1=20,parameter2=30,SampleRate=64 | %FileCheck %s
+
+// Check that one in 64 invocations is sampled, in addition to the selected
+// thread:
+
+// CHECK: %CompareAll = and i1 %CompareXAndY, %CompareToThreadIdZ
+// CHECK: %SampleKey = mul i32 %ThreadIdX, 16777619
+// CHECK: %SampleKey1 = xor i32 %SampleKey, %ThreadIdY
+// CHECK: %SampleKey2 = mul i32 %SampleKey1, 16777619
+// CHECK: %SampleKey3 = xor i32 %SampleKey2, %ThreadIdZ
+// CHECK: %SampleHash = mul i32 %SampleKey3, -1640531535
+// CHECK: %SampleHashHigh = lshr i32 %SampleHash, 16
+// CHECK: %SampleBucket = urem i32 %SampleHashHigh, 64
+// CHECK: %IsSampled = icmp eq i32 %SampleBucket, 0
+// CHECK: %SelectedOrSampled = or i1 %CompareAll, %IsSampled
+// CHECK: %OffsetMultiplicand = zext i1 %SelectedOrSampled to i32
+
+[RootSignature("")]
+[numthreads(4, 4, 4)]
+void main() {
+}
@@ -0,0 +1,28 @@
+// RUN: %dxc -Emain -Tps_6_0 %s | %opt -S -dxil-annotate-with-virtual-regs -hlsl-dxil-debug-instrumentation,WaveAggregatedCounter=1 | %FileCheck %s
+
+// Check that the lanes of a wave share one atomic add on the counter:
+
+// CHECK: %IncrementForThisInvocation = mul i32 8, %OffsetMultiplicand
+// CHECK: %WaveIncrement = call i32 @dx.op.waveActiveOp.i32(i32 119, i32 %IncrementForThisInvocation, i8 0, i8 1)
+// CHECK: %LaneOffset = call i32 @dx.op.wavePrefixOp.i32(i32 121, i32 %IncrementForThisInvocation, i8 0, i8 1)
+// CHECK: %IsFirstLane = call i1 @dx.op.waveIsFirstLane(i32 110)
+// CHECK: br i1 %IsFirstLane, label %PIXDebugWaveAtomic, label %PIXDebugWaveTail
+
+// CHECK: PIXDebugWaveAtomic:
+// CHECK: %WaveUAVIncResult = call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %PIX_DebugUAV_Handle, i32 0, i32 {{[0-9]+}}, i32 undef, i32 undef, i32 %WaveIncrement)
+// CHECK: br label %PIXDebugWaveTail
+
+// CHECK: PIXDebugWaveTail:
+// CHECK: %FirstLaneUAVIncResult = phi i32 [ %WaveUAVIncResult, %PIXDebugWaveAtomic ], [ undef, %{{.*}} ]
+// CHECK: %WaveUAVBase = call i32 @dx.op.waveReadLaneFirst.i32(i32 118, i32 %FirstLaneUAVIncResult)
+// CHECK: %UAVIncResult = add i32 %WaveUAVBase, %LaneOffset
+// CHECK: %MaskedForUAVLimit = and i32 %UAVIncResult, 983039
+
+// The step record of the ret gets its own wave-wide atomic:
+// CHECK: %WaveUAVIncResult{{[0-9]+}} = call i32 @dx.op.atomicBinOp.i32(i32 78
+// CHECK: ret void
+
+
+float4 main() : SV_Target {
+  return float4(0, 0, 0, 0);
+}
@@ -0,0 +1,42 @@
+// RUN: %dxc -Emain -Tps_6_0 %s | %opt -S -hlsl-dxil-add-pixel-hit-instrmentation,rt-width=16,num-pixels=64,add-pixel-cost=1,wave-aggregate=1 | %FileCheck %s
+
+// Check the lanes are grouped by pixel, one group per pass of the loop, and
+// the loop runs at most as many passes as the wave has lanes:
+// CHECK: %ByteIndex = mul i32 %ElementOffset, 4
+// CHECK: %WaveLaneCount = call i32 @dx.op.waveGetLaneCount(i32 112)
+// CHECK: br label %PIXPixelHitLoop
+
+// CHECK: PIXPixelHitLoop:
+// CHECK: %PixelHitPass = phi i32 [ 0, %{{.*}} ], [ %NextPixelHitPass, %PIXPixelHitLoop ]
+// CHECK: %WaveFirstByteIndex = call i32 @dx.op.waveReadLaneFirst.i32(i32 118, i32 %ByteIndex)
+// CHECK: %SharesFirstPixel = icmp eq i32 %ByteIndex, %WaveFirstByteIndex
+// CHECK: %WaveHits = call i32 @dx.op.waveAllOp(i32 135, i1 %SharesFirstPixel)
+// CHECK: %IsFirstLane = call i1 @dx.op.waveIsFirstLane(i32 110)
+// CHECK: %NextPixelHitPass = add i32 %PixelHitPass, 1
+// CHECK: %LastPixelHitPass = icmp uge i32 %NextPixelHitPass, %WaveLaneCount
+// CHECK: %LeavesLoop = or i1 %SharesFirstPixel, %LastPixelHitPass
+// CHECK: br i1 %LeavesLoop, label %PIXPixelHitGroup, label %PIXPixelHitLoop
+
+// Check the first lane of each group counts the group, and a lane left
+// without a group counts itself:
+// CHECK: PIXPixelHitGroup:
+// CHECK: %Ungrouped = xor i1 %SharesFirstPixel, true
+// CHECK: %UpdatesCounter = or i1 %IsFirstLane, %Ungrouped
+// CHECK: %PixelHitIncrement = select i1 %SharesFirstPixel, i32 %WaveHits, i32 1
+// CHECK: br i1 %UpdatesCounter, label %PIXPixelHitAtomic, label %PIXPixelHitTail
+
+// CHECK: PIXPixelHitAtomic:
+// CHECK: %UAVIncResult = call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %PIX_CountUAV_Handle, i32 0, i32 %ByteIndex, i32 undef, i32 undef, i32 %PixelHitIncrement)
+// CHECK: %Weight = extractvalue %dx.types.ResRet.i32 %WeightStruct, 0
+// CHECK: %OffsetByteIndex = add i32 %ByteIndex, 256
+// CHECK: %WaveWeight = mul i32 %Weight, %PixelHitIncrement
+// CHECK: %UAVIncResult2 = call i32 @dx.op.atomicBinOp.i32(i32 78, %dx.types.Handle %PIX_CountUAV_Handle, i32 0, i32 %OffsetByteIndex, i32 undef, i32 undef, i32 %WaveWeight)
+// CHECK: br label %PIXPixelHitTail
+
+// CHECK: PIXPixelHitTail:
+// CHECK-NEXT: ret void
+
+
+float4 main(float4 pos : SV_Position) : SV_Target {
+  return pos;
+}
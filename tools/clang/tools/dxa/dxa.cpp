@@ -13,6 +13,7 @@
 #include "dxc/Support/Unicode.h"
 #include "dxc/Support/WinIncludes.h"
 
+#include "dxc/DXIL/DxilUtil.h"
 #include "dxc/DxilContainer/DxilContainer.h"
 #include "dxc/DxilRootSignature/DxilRootSignature.h"
 #include "dxc/Support/HLSLOptions.h"
@@ -21,11 +22,16 @@
 #include "dxc/Test/RDATDumper.h"
 #include "dxc/dxcapi.h"
 
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Support//MSFileSystem.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 
+#include <chrono>
+
 using namespace llvm;
 using namespace llvm::opt;
 using namespace dxc;
@@ -68,6 +74,17 @@ static cl::opt<bool> DumpReflection("dumpreflection",
                                     cl::desc("Dump reflection"),
                                     cl::init(false));
 
+static cl::opt<bool>
+    BenchBitcode("benchbitcode",
+                 cl::desc("Time reading and writing the DXIL and ILDB "
+                          "bitcode of the input container, or of every "
+                          "container under the input directory"),
+                 cl::init(false));
+static cl::opt<unsigned>
+    BenchIterations("benchiterations",
+                    cl::desc("Number of read/write passes for -benchbitcode"),
+                    cl::init(1));
+
 class DxaContext {
 
 private:
@@ -88,6 +105,7 @@ public:
   void DumpRS();
   void DumpRDAT();
   void DumpReflection();
+  bool BenchBitcode();
 };
 
 void DxaContext::Assemble() {
@@ -466,6 +484,151 @@ void DxaContext::DumpReflection() {
   printf("%s", ss.str().c_str());
 }
 
+namespace {
+struct BitcodeBenchTotals {
+  unsigned Modules = 0;
+  unsigned Mismatches = 0;
+  uint64_t Bytes = 0;
+  double ReadMs = 0;
+  double WriteMs = 0;
+};
+} // namespace
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point Start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - Start)
+      .count();
+}
+
+// Reads the bitcode of one program part and writes it back, checking that the
+// writer reproduces the original bits. Returns false if the bitcode could not
+// be read or did not round-trip.
+static bool BenchProgramPart(StringRef Path, const hlsl::DxilPartHeader *pPart,
+                             BitcodeBenchTotals &Totals) {
+  const hlsl::DxilProgramHeader *pProgramHeader =
+      reinterpret_cast<const hlsl::DxilProgramHeader *>(
+          hlsl::GetDxilPartData(pPart));
+  if (!hlsl::IsValidDxilProgramHeader(pProgramHeader, pPart->PartSize)) {
+    printf("%s: invalid program header\n", Path.str().c_str());
+    return false;
+  }
+  const char *pBitcode;
+  uint32_t BitcodeSize;
+  hlsl::GetDxilProgramBitcode(pProgramHeader, &pBitcode, &BitcodeSize);
+  StringRef Bitcode(pBitcode, BitcodeSize);
+
+  char KindText[5];
+  hlsl::PartKindToCharArray(pPart->PartFourCC, KindText);
+
+  double ReadMs = 0, WriteMs = 0;
+  bool Identical = true;
+  bool PreserveUseListOrder = false;
+  for (unsigned i = 0; i < BenchIterations; ++i) {
+    LLVMContext Context;
+    std::string DiagStr;
+    auto Start = std::chrono::steady_clock::now();
+    std::unique_ptr<Module> M =
+        hlsl::dxilutil::LoadModuleFromBitcode(Bitcode, Context, DiagStr);
+    ReadMs += MillisecondsSince(Start);
+    if (!M) {
+      printf("%s: %s failed to load: %s\n", Path.str().c_str(), KindText,
+             DiagStr.c_str());
+      return false;
+    }
+
+    // Containers hold bitcode written both with and without use-list order.
+    // Parts whose writer recorded no use-list changes only round-trip without
+    // it, since the reader does not rebuild the order the writer predicted;
+    // fall back to preserving it if the first write does not match.
+    SmallVector<char, 0> Buffer;
+    Buffer.reserve(BitcodeSize);
+    for (;;) {
+      Buffer.clear();
+      Start = std::chrono::steady_clock::now();
+      {
+        raw_svector_ostream OS(Buffer);
+        WriteBitcodeToFile(M.get(), OS, PreserveUseListOrder);
+      }
+      double Ms = MillisecondsSince(Start);
+      bool Matches = StringRef(Buffer.data(), Buffer.size()) == Bitcode;
+      if (!Matches && i == 0 && !PreserveUseListOrder) {
+        PreserveUseListOrder = true;
+        continue;
+      }
+      WriteMs += Ms;
+      Identical &= Matches;
+      break;
+    }
+  }
+
+  printf("%s: %s %u bytes, read %.3f ms, write %.3f ms%s\n",
+         Path.str().c_str(), KindText, BitcodeSize, ReadMs / BenchIterations,
+         WriteMs / BenchIterations, Identical ? "" : ", output differs");
+  ++Totals.Modules;
+  Totals.Bytes += BitcodeSize;
+  Totals.ReadMs += ReadMs;
+  Totals.WriteMs += WriteMs;
+  if (!Identical)
+    ++Totals.Mismatches;
+  return Identical;
+}
+
+bool DxaContext::BenchBitcode() {
+  if (BenchIterations == 0)
+    BenchIterations = 1;
+
+  // Gather the inputs; when given a directory, every regular file under it
+  // that holds a DXIL container is measured and other files are skipped.
+  std::vector<std::string> Paths;
+  if (sys::fs::is_directory(InputFilename.getValue())) {
+    std::error_code EC;
+    for (sys::fs::recursive_directory_iterator It(InputFilename.getValue(), EC),
+         End;
+         It != End && !EC; It.increment(EC)) {
+      if (sys::fs::is_regular_file(It->path()))
+        Paths.push_back(It->path());
+    }
+    if (EC) {
+      printf("Unable to read directory %s: %s\n", InputFilename.c_str(),
+             EC.message().c_str());
+      return false;
+    }
+    std::sort(Paths.begin(), Paths.end());
+  } else {
+    Paths.push_back(InputFilename.getValue());
+  }
+
+  BitcodeBenchTotals Totals;
+  bool Succeeded = true;
+  for (const std::string &Path : Paths) {
+    CComPtr<IDxcBlobEncoding> pSource;
+    ReadFileIntoBlob(m_dxcSupport, StringRefWide(Path), &pSource);
+    const hlsl::DxilContainerHeader *pContainer =
+        hlsl::IsDxilContainerLike(pSource->GetBufferPointer(),
+                                  pSource->GetBufferSize());
+    if (!pContainer || !hlsl::IsValidDxilContainer(pContainer,
+                                                    pSource->GetBufferSize()))
+      continue;
+    for (hlsl::DxilFourCC FourCC :
+         {hlsl::DFCC_DXIL, hlsl::DFCC_ShaderDebugInfoDXIL}) {
+      if (const hlsl::DxilPartHeader *pPart =
+              hlsl::GetDxilPartByType(pContainer, FourCC))
+        Succeeded &= BenchProgramPart(Path, pPart, Totals);
+    }
+  }
+
+  double MBytes = (double)Totals.Bytes * BenchIterations / (1024.0 * 1024.0);
+  printf("%u modules, %llu bytes, %u iterations\n", Totals.Modules,
+         (unsigned long long)Totals.Bytes, (unsigned)BenchIterations);
+  printf("read: %.3f ms (%.2f MB/s)\n", Totals.ReadMs,
+         Totals.ReadMs ? MBytes * 1000.0 / Totals.ReadMs : 0.0);
+  printf("write: %.3f ms (%.2f MB/s)\n", Totals.WriteMs,
+         Totals.WriteMs ? MBytes * 1000.0 / Totals.WriteMs : 0.0);
+  printf("%u modules differ after a read/write round trip\n",
+         Totals.Mismatches);
+  return Succeeded;
+}
+
 using namespace hlsl::options;
 
 #ifdef _WIN32
@@ -527,6 +690,11 @@ int main(int argc, const char **argv) {
     } else if (DumpReflection) {
       pStage = "Dump Reflection";
       context.DumpReflection();
+    } else if (BenchBitcode) {
+      pStage = "Bitcode benchmark";
+      if (!context.BenchBitcode()) {
+        return 1;
+      }
     } else {
       pStage = "Assembling";
       context.Assemble();
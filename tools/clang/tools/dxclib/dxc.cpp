@@ -37,6 +37,7 @@
 //
 
 #include "dxc.h"
+#include "dxcserver.h"
 #include "dxc/Support/Global.h"
 #include "dxc/Support/Unicode.h"
 #include "dxc/Support/WinFunctions.h"
@@ -46,9 +47,11 @@
 #include <string>
 #include <vector>
 
+#include "dxc/DXIL/DxilModule.h"
 #include "dxc/DXIL/DxilShaderModel.h"
 #include "dxc/DxilContainer/DxilContainer.h"
 #include "dxc/DxilRootSignature/DxilRootSignature.h"
+#include "dxc/HLSL/DxilSignaturePruning.h"
 #include "dxc/Support/FileIOHelper.h"
 #include "dxc/Support/HLSLOptions.h"
 #include "dxc/Support/dxcapi.use.h"
@@ -56,16 +59,29 @@
 #include "dxc/dxcapi.h"
 #include "dxc/dxcapi.internal.h"
 #include "dxc/dxctools.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Bitcode/ReaderWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
 #include "llvm/Option/ArgList.h"
 #include "llvm/Option/OptTable.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/MD5.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/StringSaver.h"
 #include "llvm/Support/raw_ostream.h"
 #ifdef _WIN32
 #include <comdef.h>
 #include <dia2.h>
 #endif
 #include <algorithm>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #ifdef _WIN32
@@ -121,11 +137,76 @@ using namespace dxc;
 using namespace llvm::opt;
 using namespace hlsl::options;
 
+namespace {
+// Results of /recompile shared by the entries of a /batch manifest, so that
+// binaries and PDBs holding the same shader are only recompiled once. Only the
+// most recently used results are kept, since each one holds a container and
+// possibly a PDB.
+class RecompileCache {
+public:
+  struct Entry {
+    // Held while the first user recompiles, so that others wait for it.
+    std::mutex Lock;
+    CComPtr<IDxcOperationResult> pCompileResult;
+    CComPtr<IDxcBlob> pDebugBlob;
+    std::wstring DebugName;
+  };
+
+  static const unsigned kDefaultMaxEntries = 64;
+
+  explicit RecompileCache(unsigned MaxEntries = kDefaultMaxEntries)
+      : m_MaxEntries(MaxEntries), m_Hits(0), m_Misses(0) {}
+
+  // Entries evicted while in use stay valid for their current users.
+  std::shared_ptr<Entry> Get(llvm::StringRef Key) {
+    std::lock_guard<std::mutex> Guard(m_Lock);
+    auto It = m_Entries.find(Key);
+    if (It != m_Entries.end()) {
+      m_Order.splice(m_Order.begin(), m_Order, It->second.Position);
+      return It->second.pEntry;
+    }
+    if (m_Entries.size() >= m_MaxEntries) {
+      m_Entries.erase(m_Order.back());
+      m_Order.pop_back();
+    }
+    m_Order.push_front(Key);
+    CachedEntry &Cached = m_Entries[Key];
+    Cached.pEntry = std::make_shared<Entry>();
+    Cached.Position = m_Order.begin();
+    return Cached.pEntry;
+  }
+
+  void CountHit() { ++m_Hits; }
+  void CountMiss() { ++m_Misses; }
+  unsigned GetHits() const { return m_Hits; }
+  unsigned GetMisses() const { return m_Misses; }
+
+private:
+  struct CachedEntry {
+    std::shared_ptr<Entry> pEntry;
+    std::list<std::string>::iterator Position;
+  };
+
+  std::mutex m_Lock;
+  unsigned m_MaxEntries;
+  // Keys from the most to the least recently used.
+  std::list<std::string> m_Order;
+  llvm::StringMap<CachedEntry> m_Entries;
+  std::atomic<unsigned> m_Hits;
+  std::atomic<unsigned> m_Misses;
+};
+} // namespace
+
 class DxcContext {
 
 private:
   DxcOpts &m_Opts;
   DxcDllSupport &m_dxcSupport;
+  // When set, compile diagnostics are collected here instead of being written
+  // to the console (used by /batch to keep per-input diagnostics together).
+  std::string *m_pCapturedDiagnostics;
+  // When set, /recompile results are looked up and stored here.
+  RecompileCache *m_pRecompileCache;
 
   int ActOnBlob(IDxcBlob *pBlob);
   int ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob, LPCWSTR pDebugBlobName);
@@ -148,6 +229,7 @@ private:
                          IDxcLibrary *pLibrary, IDxcBlob **ppTargetBlob);
   void ExtractRootSignature(IDxcBlob *pBlob, IDxcBlob **ppResult);
   int VerifyRootSignature();
+  void CaptureOperationErrors(IDxcOperationResult *pResult);
 
   template <typename TInterface>
   HRESULT CreateInstance(REFCLSID clsid, TInterface **pResult) {
@@ -155,8 +237,12 @@ private:
   }
 
 public:
-  DxcContext(DxcOpts &Opts, DxcDllSupport &dxcSupport)
-      : m_Opts(Opts), m_dxcSupport(dxcSupport) {}
+  DxcContext(DxcOpts &Opts, DxcDllSupport &dxcSupport,
+             std::string *pCapturedDiagnostics = nullptr,
+             RecompileCache *pRecompileCache = nullptr)
+      : m_Opts(Opts), m_dxcSupport(dxcSupport),
+        m_pCapturedDiagnostics(pCapturedDiagnostics),
+        m_pRecompileCache(pRecompileCache) {}
 
   int Compile();
   void Recompile(IDxcBlob *pSource, IDxcLibrary *pLibrary,
@@ -414,7 +500,27 @@ int DxcContext::ActOnBlob(IDxcBlob *pBlob, IDxcBlob *pDebugBlob,
     } else {
       CComPtr<IDxcCompiler> pCompiler;
       IFT(CreateInstance(CLSID_DxcCompiler, &pCompiler));
-      IFT(pCompiler->Disassemble(pBlob, &pDisassembleResult));
+      if (m_Opts.DisasmFunctions.empty() && m_Opts.DisasmThreads == 1) {
+        IFT(pCompiler->Disassemble(pBlob, &pDisassembleResult));
+      } else {
+        CComPtr<IDxcStreamingDisassembler> pStreaming;
+        IFT(pCompiler.QueryInterface(&pStreaming));
+        std::vector<std::wstring> names;
+        std::vector<LPCWSTR> namePtrs;
+        for (const std::string &name : m_Opts.DisasmFunctions)
+          names.push_back(Unicode::UTF8ToWideStringOrThrow(name.c_str()));
+        for (const std::wstring &name : names)
+          namePtrs.push_back(name.c_str());
+        DxcBuffer object = {pBlob->GetBufferPointer(), pBlob->GetBufferSize(),
+                            DXC_CP_ACP};
+        CComPtr<hlsl::AbstractMemoryStream> pStream;
+        IFT(hlsl::CreateMemoryStream(DxcGetThreadMallocNoRef(), &pStream));
+        IFT(pStreaming->DisassembleToStream(
+            &object, namePtrs.data(), (UINT32)namePtrs.size(),
+            m_Opts.DisasmThreads, pStream));
+        IFT(hlsl::DxcCreateBlobWithEncodingFromStream(pStream, false, CP_UTF8,
+                                                      &pDisassembleResult));
+      }
     }
 
     // SPIRV Change Starts
@@ -783,20 +889,66 @@ void DxcContext::Recompile(IDxcBlob *pSource, IDxcLibrary *pLibrary,
     }
   }
 
-  CComPtr<IDxcOperationResult> pResult;
+  // The shader hash alone does not cover debug information, so the cache key
+  // also includes everything the recompilation reads.
+  std::shared_ptr<RecompileCache::Entry> pCached;
+  std::unique_lock<std::mutex> CachedLock;
+  CComPtr<IDxcBlob> pHash;
+  if (m_pRecompileCache && SUCCEEDED(pPdbUtils->GetHash(&pHash)) && pHash) {
+    llvm::MD5 Hash;
+    auto HashBytes = [&Hash](const void *pData, size_t Size) {
+      Hash.update(llvm::StringRef((const char *)&Size, sizeof(Size)));
+      Hash.update(llvm::StringRef((const char *)pData, Size));
+    };
+    auto HashString = [&HashBytes](const wchar_t *pStr) {
+      HashBytes(pStr, pStr ? wcslen(pStr) * sizeof(wchar_t) : 0);
+    };
+    HashString(pMainFileName);
+    HashString(pTargetProfile);
+    HashString(pEntryPoint);
+    for (const std::wstring &Flag : NewArgsStorage)
+      HashString(Flag.c_str());
+    for (const DxcDefine &Define : NewDefines) {
+      HashString(Define.Name);
+      HashString(Define.Value);
+    }
+    for (UINT32 i = 0; i < uSourceCount; i++) {
+      CComPtr<IDxcBlobEncoding> pSourceFile;
+      CComBSTR pFileName;
+      IFT(pPdbUtils->GetSource(i, &pSourceFile));
+      IFT(pPdbUtils->GetSourceName(i, &pFileName));
+      HashString(pFileName);
+      HashBytes(pSourceFile->GetBufferPointer(), pSourceFile->GetBufferSize());
+    }
+    llvm::MD5::MD5Result Digest;
+    Hash.final(Digest);
+
+    std::string Key((const char *)pHash->GetBufferPointer(),
+                    pHash->GetBufferSize());
+    Key.append((const char *)Digest, sizeof(Digest));
+    Key += m_Opts.DebugFile.empty() ? 'c' : 'd';
+    pCached = m_pRecompileCache->Get(Key);
+    CachedLock = std::unique_lock<std::mutex>(pCached->Lock);
+  }
 
-  if (!m_Opts.DebugFile.empty()) {
+  CComPtr<IDxcOperationResult> pResult;
+  std::wstring DebugName;
+
+  if (pCached && pCached->pCompileResult) {
+    m_pRecompileCache->CountHit();
+    pResult = pCached->pCompileResult;
+    pDebugBlob = pCached->pDebugBlob;
+    DebugName = pCached->DebugName;
+  } else if (!m_Opts.DebugFile.empty()) {
     CComPtr<IDxcCompiler2> pCompiler2;
     CComHeapPtr<WCHAR> pDebugName;
-    Unicode::UTF8ToWideString(m_Opts.DebugFile.str().c_str(), &outputPDBPath);
     IFT(pCompiler->QueryInterface(&pCompiler2));
     IFT(pCompiler2->CompileWithDebug(
         pCompileSource, pMainFileName, pEntryPoint, pTargetProfile,
         NewArgs.data(), NewArgs.size(), NewDefines.data(), NewDefines.size(),
         pIncludeHandler, &pResult, &pDebugName, &pDebugBlob));
-    if (pDebugName.m_pData && m_Opts.DebugFileIsDirectory()) {
-      outputPDBPath += pDebugName.m_pData;
-    }
+    if (pDebugName.m_pData)
+      DebugName = pDebugName.m_pData;
   } else {
     IFT(pCompiler->Compile(pCompileSource, pMainFileName, pEntryPoint,
                            pTargetProfile, NewArgs.data(), NewArgs.size(),
@@ -804,6 +956,20 @@ void DxcContext::Recompile(IDxcBlob *pSource, IDxcLibrary *pLibrary,
                            pIncludeHandler, &pResult));
   }
 
+  if (pCached && !pCached->pCompileResult) {
+    m_pRecompileCache->CountMiss();
+    pCached->pCompileResult = pResult;
+    pCached->pDebugBlob = pDebugBlob;
+    pCached->DebugName = DebugName;
+  }
+
+  if (!m_Opts.DebugFile.empty()) {
+    Unicode::UTF8ToWideString(m_Opts.DebugFile.str().c_str(), &outputPDBPath);
+    if (!DebugName.empty() && m_Opts.DebugFileIsDirectory()) {
+      outputPDBPath += DebugName;
+    }
+  }
+
   *ppCompileResult = pResult.Detach();
 }
 
@@ -847,7 +1013,10 @@ int DxcContext::Compile() {
         TargetProfile = hlsl::ShaderModel::Get(SM->GetKind(), 6, 0)->GetName();
         std::string versionWarningString =
             "warning: Promoting older shader model profile to 6.0 version.";
-        fprintf(stderr, "%s\n", versionWarningString.data());
+        if (m_pCapturedDiagnostics)
+          *m_pCapturedDiagnostics += versionWarningString + "\n";
+        else
+          fprintf(stderr, "%s\n", versionWarningString.data());
         if (!SM->IsSM51Plus()) {
           // Add flag for backcompat with SM 5.0 resource reservation
           args.push_back(L"-flegacy-resource-reservation");
@@ -891,6 +1060,8 @@ int DxcContext::Compile() {
     IFT(pCompileResult->GetErrorBuffer(&pErrors));
     WriteBlobToFile(pErrors, m_Opts.OutputWarningsFile,
                     m_Opts.DefaultTextCodePage);
+  } else if (m_pCapturedDiagnostics) {
+    CaptureOperationErrors(pCompileResult);
   } else {
     WriteOperationErrorsToConsole(pCompileResult, m_Opts.OutputWarnings);
   }
@@ -933,6 +1104,21 @@ int DxcContext::Compile() {
   return status;
 }
 
+void DxcContext::CaptureOperationErrors(IDxcOperationResult *pResult) {
+  HRESULT status;
+  IFT(pResult->GetStatus(&status));
+  if (SUCCEEDED(status) && !m_Opts.OutputWarnings)
+    return;
+  CComPtr<IDxcBlobEncoding> pErrors;
+  IFT(pResult->GetErrorBuffer(&pErrors));
+  if (pErrors.p == nullptr)
+    return;
+  CComPtr<IDxcBlobUtf8> pErrorsUtf8;
+  IFT(hlsl::DxcGetBlobAsUtf8(pErrors, DxcGetThreadMallocNoRef(), &pErrorsUtf8));
+  m_pCapturedDiagnostics->append(pErrorsUtf8->GetStringPointer(),
+                                 pErrorsUtf8->GetStringLength());
+}
+
 int DxcContext::Link() {
   CComPtr<IDxcLinker> pLinker;
   IFT(CreateInstance(CLSID_DxcLinker, &pLinker));
@@ -1329,6 +1515,474 @@ void DxcContext::GetCompilerVersionInfo(llvm::raw_string_ostream &OS) {
   WriteDXILVersionInfo(OS, DxilSupport);
 }
 
+namespace {
+// A single compilation listed in a /batch manifest. Entries are never moved
+// once created, because the parsed options refer into the argument storage.
+struct BatchEntry {
+  BatchEntry(unsigned line, llvm::ArrayRef<llvm::StringRef> args)
+      : Line(line), Args(args) {}
+  unsigned Line;
+  MainArgs Args;
+  DxcOpts Opts;
+  std::string Diagnostics;
+  int RetVal = 0;
+};
+} // namespace
+
+static void RunBatchEntry(BatchEntry &Entry, DxcDllSupport &dxcSupport,
+                          RecompileCache *pRecompileCache = nullptr) {
+  llvm::raw_string_ostream OS(Entry.Diagnostics);
+  try {
+    DxcContext context(Entry.Opts, dxcSupport, &Entry.Diagnostics,
+                       pRecompileCache);
+    Entry.RetVal = context.Compile();
+    return;
+  } catch (const ::hlsl::Exception &hlslException) {
+    const char *msg = hlslException.what();
+    if (msg != nullptr && *msg != '\0')
+      OS << "dxc failed : " << msg << "\n";
+    else
+      OS << "dxc failed : error code "
+         << llvm::format_hex((uint32_t)hlslException.hr, 10) << "\n";
+  } catch (std::bad_alloc &) {
+    OS << "Compilation failed - out of memory.\n";
+  } catch (...) {
+    OS << "Compilation failed - unknown error.\n";
+  }
+  OS.flush();
+  Entry.RetVal = 1;
+}
+
+// Reads the command lines listed in a /batch or /pipeline manifest. Each
+// non-empty line that does not start with '#' holds the arguments for one
+// compilation, quoted like a response file. CheckEntry returns an error message
+// for entries the caller cannot compile, or nullptr. Returns the number of
+// lines that failed.
+static unsigned
+ReadManifest(llvm::StringRef ManifestFile, DxcDllSupport &dxcSupport,
+             const OptTable *optionTable,
+             llvm::function_ref<const char *(const DxcOpts &)> CheckEntry,
+             std::vector<std::unique_ptr<BatchEntry>> &Entries) {
+  CComPtr<IDxcBlobEncoding> pManifest;
+  ReadFileIntoBlob(dxcSupport, StringRefWide(ManifestFile), &pManifest);
+  llvm::StringRef Text((const char *)pManifest->GetBufferPointer(),
+                       pManifest->GetBufferSize());
+  if (Text.startswith("\xEF\xBB\xBF"))
+    Text = Text.drop_front(3);
+
+  unsigned ParseFailures = 0;
+  llvm::SmallVector<llvm::StringRef, 64> Lines;
+  Text.split(Lines, "\n");
+  for (unsigned i = 0; i < Lines.size(); ++i) {
+    llvm::StringRef Line = Lines[i].trim();
+    if (Line.empty() || Line.startswith("#"))
+      continue;
+
+    llvm::BumpPtrAllocator Alloc;
+    llvm::BumpPtrStringSaver Saver(Alloc);
+    llvm::SmallVector<const char *, 32> Tokens;
+    llvm::cl::TokenizeGNUCommandLine(Line, Saver, Tokens);
+    std::vector<llvm::StringRef> Args(Tokens.begin(), Tokens.end());
+    std::unique_ptr<BatchEntry> Entry(new BatchEntry(i + 1, Args));
+
+    std::string ErrorString;
+    llvm::raw_string_ostream ErrorStream(ErrorString);
+    int OptResult = ReadDxcOpts(optionTable, DxcFlags, Entry->Args,
+                                Entry->Opts, ErrorStream);
+    if (OptResult == 0) {
+      if (const char *pError = CheckEntry(Entry->Opts)) {
+        ErrorStream << pError;
+        OptResult = 1;
+      }
+    }
+    ErrorStream.flush();
+    if (OptResult != 0) {
+      fprintf(stderr, "%s(%u): dxc failed : %s\n", ManifestFile.str().c_str(),
+              i + 1, ErrorString.c_str());
+      ++ParseFailures;
+      continue;
+    }
+    if (!ErrorString.empty())
+      fprintf(stderr, "%s(%u): dxc warning : %s\n", ManifestFile.str().c_str(),
+              i + 1, ErrorString.c_str());
+    if (Entry->Opts.EntryPoint.empty() && !Entry->Opts.RecompileFromBinary)
+      Entry->Opts.EntryPoint = "main";
+    Entries.push_back(std::move(Entry));
+  }
+  return ParseFailures;
+}
+
+// Writes the diagnostics of a manifest entry, prefixed with the manifest line
+// it belongs to.
+static void WriteEntryDiagnostics(llvm::StringRef ManifestFile,
+                                  const BatchEntry &Entry) {
+  std::string Message;
+  llvm::raw_string_ostream OS(Message);
+  OS << ManifestFile << "(" << Entry.Line << "): " << Entry.Opts.InputFile
+     << ":\n"
+     << Entry.Diagnostics;
+  if (!llvm::StringRef(Entry.Diagnostics).endswith("\n"))
+    OS << "\n";
+  OS.flush();
+  WriteUtf8ToConsoleSizeT(Message.data(), Message.size(), STD_ERROR_HANDLE);
+}
+
+// Compiles every command line in the /batch manifest on a pool of threads
+// that share the loaded compiler and a cache of /recompile results.
+// Diagnostics of one entry are written together. Returns non-zero if any entry
+// failed.
+static int RunBatch(const DxcOpts &BatchOpts, DxcDllSupport &dxcSupport,
+                    const OptTable *optionTable) {
+  std::vector<std::unique_ptr<BatchEntry>> Entries;
+  unsigned ParseFailures = ReadManifest(
+      BatchOpts.BatchFile, dxcSupport, optionTable,
+      [](const DxcOpts &Opts) -> const char * {
+        if (!Opts.BatchFile.empty() || !Opts.PipelineFile.empty())
+          return "/batch cannot be nested.";
+        if (Opts.DumpBin || Opts.Link || !Opts.Preprocess.empty())
+          return "only compilation is supported in /batch entries.";
+        if (Opts.OutputObject.empty() && Opts.AssemblyCode.empty() &&
+            Opts.OutputHeader.empty())
+          return "/batch entries must write their output with /Fo, /Fc or "
+                 "/Fh.";
+        return nullptr;
+      },
+      Entries);
+
+  unsigned NumJobs = BatchOpts.BatchJobs;
+  if (NumJobs == 0)
+    NumJobs = std::max(1u, std::thread::hardware_concurrency());
+  NumJobs = (unsigned)std::min<size_t>(NumJobs, Entries.size());
+
+  std::atomic<size_t> NextEntry(0);
+  std::atomic<unsigned> CompileFailures(0);
+  std::mutex ConsoleLock;
+  RecompileCache Recompiled;
+  auto Worker = [&]() {
+    DxcSetThreadMallocToDefault();
+    for (size_t i = NextEntry++; i < Entries.size(); i = NextEntry++) {
+      BatchEntry &Entry = *Entries[i];
+      RunBatchEntry(Entry, dxcSupport, &Recompiled);
+      if (Entry.RetVal != 0)
+        ++CompileFailures;
+      if (Entry.Diagnostics.empty())
+        continue;
+      std::lock_guard<std::mutex> Guard(ConsoleLock);
+      WriteEntryDiagnostics(BatchOpts.BatchFile, Entry);
+    }
+    DxcClearThreadMalloc();
+  };
+
+  std::vector<std::thread> Threads;
+  Threads.reserve(NumJobs);
+  for (unsigned i = 0; i < NumJobs; ++i)
+    Threads.emplace_back(Worker);
+  for (std::thread &T : Threads)
+    T.join();
+
+  if (Recompiled.GetHits() || Recompiled.GetMisses()) {
+    std::string Summary;
+    llvm::raw_string_ostream OS(Summary);
+    OS << BatchOpts.BatchFile << ": recompiled " << Recompiled.GetMisses()
+       << " of " << Recompiled.GetHits() + Recompiled.GetMisses()
+       << " /recompile entries.\n";
+    OS.flush();
+    WriteUtf8ToConsoleSizeT(Summary.data(), Summary.size());
+  }
+
+  unsigned Failures = ParseFailures + CompileFailures;
+  if (Failures) {
+    fprintf(stderr, "dxc failed : %u of %u batch entries failed.\n", Failures,
+            (unsigned)Entries.size() + ParseFailures);
+    return 1;
+  }
+  return 0;
+}
+
+// Throws with the errors of a failed assembler or validator operation.
+static void CheckPipelineResult(IDxcOperationResult *pResult,
+                                const llvm::Twine &Step) {
+  HRESULT status;
+  IFT(pResult->GetStatus(&status));
+  if (SUCCEEDED(status))
+    return;
+  std::string Message = (Step + " failed").str();
+  CComPtr<IDxcBlobEncoding> pErrors;
+  if (SUCCEEDED(pResult->GetErrorBuffer(&pErrors)) && pErrors &&
+      pErrors->GetBufferSize()) {
+    Message += ": ";
+    Message.append((const char *)pErrors->GetBufferPointer(),
+                   pErrors->GetBufferSize());
+  }
+  throw hlsl::Exception(status, Message);
+}
+
+// Loads the DXIL module of a compiled stage. The root signature is only kept
+// in the container, so it is restored on the module.
+static std::unique_ptr<llvm::Module>
+LoadPipelineStage(IDxcBlob *pContainer, llvm::LLVMContext &Context,
+                  llvm::StringRef Name) {
+  const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
+      pContainer->GetBufferPointer(), pContainer->GetBufferSize());
+  IFTBOOL(pHeader && hlsl::IsValidDxilContainer(pHeader,
+                                                pContainer->GetBufferSize()),
+          DXC_E_CONTAINER_INVALID);
+  const hlsl::DxilPartHeader *pDxilPart =
+      hlsl::GetDxilPartByType(pHeader, hlsl::DFCC_DXIL);
+  IFTBOOL(pDxilPart != nullptr, DXC_E_CONTAINER_MISSING_DXIL);
+  const char *pBitcode;
+  uint32_t BitcodeSize;
+  hlsl::GetDxilProgramBitcode(
+      (const hlsl::DxilProgramHeader *)hlsl::GetDxilPartData(pDxilPart),
+      &pBitcode, &BitcodeSize);
+  llvm::ErrorOr<std::unique_ptr<llvm::Module>> M = llvm::parseBitcodeFile(
+      llvm::MemoryBufferRef(llvm::StringRef(pBitcode, BitcodeSize), Name),
+      Context);
+  IFTBOOLMSG(M, DXC_E_CONTAINER_INVALID,
+             ("unable to load DXIL from " + Name).str());
+
+  hlsl::DxilModule &DM = M.get()->GetOrCreateDxilModule();
+  if (const hlsl::DxilPartHeader *pRootSigPart =
+          hlsl::GetDxilPartByType(pHeader, hlsl::DFCC_RootSignature)) {
+    const uint8_t *pData = (const uint8_t *)hlsl::GetDxilPartData(pRootSigPart);
+    std::vector<uint8_t> RootSig(pData, pData + pRootSigPart->PartSize);
+    DM.ResetSerializedRootSignature(RootSig);
+  }
+  return std::move(M.get());
+}
+
+// Removes or copies the parts that the assembler cannot derive from the
+// module, so a rewritten stage keeps the container options of its entry:
+// reflection is dropped under /Qstrip_reflect, /setprivate data is carried
+// over and /Qstrip_rootsignature stays in effect.
+static void MatchPipelineStageParts(IDxcBlob *pOriginal,
+                                    CComPtr<IDxcBlob> &pContainer,
+                                    DxcDllSupport &dxcSupport) {
+  const hlsl::DxilContainerHeader *pOriginalHeader =
+      (const hlsl::DxilContainerHeader *)pOriginal->GetBufferPointer();
+  const hlsl::DxilContainerHeader *pHeader =
+      (const hlsl::DxilContainerHeader *)pContainer->GetBufferPointer();
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcContainerBuilder> pBuilder;
+  for (uint32_t FourCC : {(uint32_t)hlsl::DFCC_ShaderStatistics,
+                          (uint32_t)hlsl::DFCC_RootSignature,
+                          (uint32_t)hlsl::DFCC_PrivateData}) {
+    const hlsl::DxilPartHeader *pOriginalPart =
+        hlsl::GetDxilPartByType(pOriginalHeader, (hlsl::DxilFourCC)FourCC);
+    const hlsl::DxilPartHeader *pPart =
+        hlsl::GetDxilPartByType(pHeader, (hlsl::DxilFourCC)FourCC);
+    if (!pOriginalPart == !pPart)
+      continue;
+    if (!pBuilder) {
+      IFT(dxcSupport.CreateInstance(CLSID_DxcContainerBuilder, &pBuilder));
+      IFT(pBuilder->Load(pContainer));
+    }
+    if (pPart) {
+      IFT(pBuilder->RemovePart(FourCC));
+      continue;
+    }
+    CComPtr<IDxcBlobEncoding> pPartBlob;
+    if (!pLibrary)
+      IFT(dxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+    IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
+        hlsl::GetDxilPartData(pOriginalPart), pOriginalPart->PartSize, CP_ACP,
+        &pPartBlob));
+    IFT(pBuilder->AddPart(FourCC, pPartBlob));
+  }
+  if (!pBuilder)
+    return;
+  CComPtr<IDxcOperationResult> pResult;
+  IFT(pBuilder->SerializeContainer(&pResult));
+  CheckPipelineResult(pResult, "Updating parts of the container");
+  pContainer.Release();
+  IFT(pResult->GetResult(&pContainer));
+}
+
+// Creates the validator a compilation with Opts would use: dxil.dll, so the
+// rewritten stage is signed, unless /select-validator internal was given.
+// /select-validator external fails when dxil.dll cannot be loaded.
+static void CreatePipelineValidator(const DxcOpts &Opts,
+                                    DxcDllSupport &dxcSupport,
+                                    DxcDllSupport &dxilSupport,
+                                    IDxcValidator **ppValidator) {
+  if (Opts.SelectValidator != hlsl::options::ValidatorSelection::Internal &&
+      dxilSupport.IsEnabled()) {
+    IFT(dxilSupport.CreateInstance(CLSID_DxcValidator, ppValidator));
+    return;
+  }
+  IFTBOOLMSG(Opts.SelectValidator !=
+                 hlsl::options::ValidatorSelection::External,
+             DXC_E_VALIDATOR_MISSING,
+             "DXIL signing library (dxil.dll,libdxil.so) is required by "
+             "/select-validator external but could not be loaded.");
+  IFT(dxcSupport.CreateInstance(CLSID_DxcValidator, ppValidator));
+}
+
+// Assembles and validates a pruned stage and overwrites its /Fo output.
+static void WritePipelineStage(llvm::Module &M, IDxcBlob *pOriginal,
+                               const DxcOpts &Opts, DxcDllSupport &dxcSupport,
+                               DxcDllSupport &dxilSupport) {
+  std::string Bitcode;
+  {
+    llvm::raw_string_ostream OS(Bitcode);
+    llvm::WriteBitcodeToFile(&M, OS);
+  }
+  CComPtr<IDxcLibrary> pLibrary;
+  CComPtr<IDxcBlobEncoding> pBitcode;
+  IFT(dxcSupport.CreateInstance(CLSID_DxcLibrary, &pLibrary));
+  IFT(pLibrary->CreateBlobWithEncodingOnHeapCopy(
+      (LPBYTE)&Bitcode[0], Bitcode.size(), CP_ACP, &pBitcode));
+
+  CComPtr<IDxcAssembler> pAssembler;
+  CComPtr<IDxcOperationResult> pResult;
+  CComPtr<IDxcBlob> pContainer;
+  IFT(dxcSupport.CreateInstance(CLSID_DxcAssembler, &pAssembler));
+  IFT(pAssembler->AssembleToContainer(pBitcode, &pResult));
+  CheckPipelineResult(pResult, "Assembling " + Opts.OutputObject);
+  IFT(pResult->GetResult(&pContainer));
+  MatchPipelineStageParts(pOriginal, pContainer, dxcSupport);
+
+  CComPtr<IDxcValidator> pValidator;
+  pResult.Release();
+  CreatePipelineValidator(Opts, dxcSupport, dxilSupport, &pValidator);
+  IFT(pValidator->Validate(pContainer, DxcValidatorFlags_InPlaceEdit,
+                           &pResult));
+  CheckPipelineResult(pResult, "Validating " + Opts.OutputObject);
+
+  WriteBlobToFile(pContainer, Opts.OutputObject, Opts.DefaultTextCodePage);
+}
+
+// Instruction and signature row counts of a stage, reported by /pipeline
+// before and after pruning.
+struct PipelineStageSize {
+  unsigned Instructions = 0;
+  unsigned InputRows = 0;
+  unsigned OutputRows = 0;
+  unsigned PatchConstantRows = 0;
+  bool IsMeshShader = false;
+
+  explicit PipelineStageSize(llvm::Module &M) {
+    for (llvm::Function &F : M)
+      for (llvm::BasicBlock &BB : F)
+        Instructions += BB.size();
+    hlsl::DxilModule &DM = M.GetOrCreateDxilModule();
+    InputRows = DM.GetInputSignature().GetRowCount();
+    OutputRows = DM.GetOutputSignature().GetRowCount();
+    PatchConstantRows = DM.GetPatchConstOrPrimSignature().GetRowCount();
+    IsMeshShader = DM.GetShaderModel()->IsMS();
+  }
+};
+
+// Compiles the stages listed in the /pipeline manifest, in pipeline order,
+// then removes the signature elements that no later stage reads and rewrites
+// the /Fo output of every stage that changed. Stages are compiled one at a
+// time, since they are loaded back together. Returns non-zero if any stage
+// failed.
+static int RunPipeline(const DxcOpts &PipelineOpts, DxcDllSupport &dxcSupport,
+                       const OptTable *optionTable) {
+  std::vector<std::unique_ptr<BatchEntry>> Entries;
+  unsigned ParseFailures = ReadManifest(
+      PipelineOpts.PipelineFile, dxcSupport, optionTable,
+      [](const DxcOpts &Opts) -> const char * {
+        if (!Opts.BatchFile.empty() || !Opts.PipelineFile.empty())
+          return "/pipeline cannot be nested.";
+        if (Opts.DumpBin || Opts.Link || !Opts.Preprocess.empty() ||
+            Opts.CodeGenHighLevel)
+          return "only compilation to DXIL is supported in /pipeline "
+                 "entries.";
+#ifdef ENABLE_SPIRV_CODEGEN
+        if (Opts.GenSPIRV)
+          return "only compilation to DXIL is supported in /pipeline "
+                 "entries.";
+#endif
+        if (Opts.OutputObject.empty())
+          return "/pipeline entries must write their output with /Fo.";
+        if (!Opts.AssemblyCode.empty() || !Opts.OutputHeader.empty() ||
+            !Opts.OutputReflectionFile.empty() || !Opts.DebugFile.empty() ||
+            Opts.DebugInfo || Opts.EmbedDebug)
+          return "/pipeline entries cannot write /Fc, /Fh, /Fre or debug "
+                 "information, which would not match the pruned output.";
+        return nullptr;
+      },
+      Entries);
+
+  unsigned CompileFailures = 0;
+  for (auto &Entry : Entries) {
+    RunBatchEntry(*Entry, dxcSupport);
+    if (Entry->RetVal != 0)
+      ++CompileFailures;
+    if (!Entry->Diagnostics.empty())
+      WriteEntryDiagnostics(PipelineOpts.PipelineFile, *Entry);
+  }
+  unsigned Failures = ParseFailures + CompileFailures;
+  if (Failures) {
+    fprintf(stderr, "dxc failed : %u of %u pipeline stages failed.\n",
+            Failures, (unsigned)Entries.size() + ParseFailures);
+    return 1;
+  }
+
+  // Repack with the strongest strategy any stage asked for.
+  hlsl::DXIL::PackingStrategy Packing =
+      hlsl::DXIL::PackingStrategy::PrefixStable;
+  for (auto &Entry : Entries) {
+    if (Entry->Opts.PackMinimalRows)
+      Packing = hlsl::DXIL::PackingStrategy::MinimalRows;
+    else if (Entry->Opts.PackOptimized &&
+             Packing != hlsl::DXIL::PackingStrategy::MinimalRows)
+      Packing = hlsl::DXIL::PackingStrategy::Optimized;
+  }
+
+  llvm::LLVMContext Context;
+  std::vector<CComPtr<IDxcBlobEncoding>> Containers(Entries.size());
+  std::vector<std::unique_ptr<llvm::Module>> Modules;
+  std::vector<llvm::Module *> Stages;
+  std::vector<PipelineStageSize> SizesBefore;
+  for (unsigned i = 0; i < Entries.size(); ++i) {
+    llvm::StringRef OutputObject = Entries[i]->Opts.OutputObject;
+    ReadFileIntoBlob(dxcSupport, StringRefWide(OutputObject), &Containers[i]);
+    Modules.push_back(LoadPipelineStage(Containers[i], Context, OutputObject));
+    Stages.push_back(Modules.back().get());
+    SizesBefore.emplace_back(*Stages.back());
+  }
+
+  std::vector<bool> Changed;
+  unsigned NumRemoved =
+      hlsl::PrunePipelineSignatures(Stages, Packing, Changed);
+  // Rewritten stages are signed like a regular compilation would sign them.
+  DxcDllSupport DxilSupport;
+  DxilSupport.InitializeForDll(kDxilLib, "DxcCreateInstance");
+  unsigned NumChanged = 0;
+  for (unsigned i = 0; i < Stages.size(); ++i) {
+    if (!Changed[i])
+      continue;
+    WritePipelineStage(*Stages[i], Containers[i], Entries[i]->Opts, dxcSupport,
+                       DxilSupport);
+    ++NumChanged;
+  }
+
+  std::string Summary;
+  llvm::raw_string_ostream OS(Summary);
+  OS << PipelineOpts.PipelineFile << ": removed " << NumRemoved
+     << " signature elements, rewrote " << NumChanged << " of "
+     << Stages.size() << " stages.\n";
+  for (unsigned i = 0; i < Stages.size(); ++i) {
+    const PipelineStageSize &Before = SizesBefore[i];
+    PipelineStageSize After(*Stages[i]);
+    OS << "  " << Entries[i]->Opts.OutputObject << ": " << Before.Instructions
+       << " -> " << After.Instructions << " instructions, input rows "
+       << Before.InputRows << " -> " << After.InputRows << ", output rows "
+       << Before.OutputRows << " -> " << After.OutputRows;
+    if (Before.PatchConstantRows)
+      OS << (Before.IsMeshShader ? ", primitive rows "
+                                 : ", patch constant rows ")
+         << Before.PatchConstantRows << " -> " << After.PatchConstantRows;
+    OS << "\n";
+  }
+  OS.flush();
+  WriteUtf8ToConsoleSizeT(Summary.data(), Summary.size());
+  return 0;
+}
+
 #ifndef VERSION_STRING_SUFFIX
 #define VERSION_STRING_SUFFIX ""
 #endif
@@ -1496,6 +2150,15 @@ int dxc::main(int argc, const char **argv_) {
     } else if (dxcOpts.Link) {
       pStage = "Linking";
       retVal = context.Link();
+    } else if (!dxcOpts.BatchFile.empty()) {
+      pStage = "Batch compilation";
+      retVal = RunBatch(dxcOpts, dxcSupport, optionTable);
+    } else if (!dxcOpts.PipelineFile.empty()) {
+      pStage = "Pipeline compilation";
+      retVal = RunPipeline(dxcOpts, dxcSupport, optionTable);
+    } else if (dxcOpts.Server) {
+      pStage = "Server";
+      retVal = RunServer(dxcOpts, dxcSupport, optionTable);
     } else {
       pStage = "Compilation";
       retVal = context.Compile();
@@ -0,0 +1,560 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcserver.cpp                                                             //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides a long-lived request/response mode for the dxc console program.  //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "dxcserver.h"
+#include "dxc/Support/Global.h"
+#include "dxc/Support/Unicode.h"
+#include "dxc/Support/WinIncludes.h"
+
+#include "dxc/Support/FileIOHelper.h"
+#include "dxc/Support/HLSLOptions.h"
+#include "dxc/Support/dxcapi.use.h"
+#include "dxc/Support/microcom.h"
+#include "dxc/dxcapi.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Option/OptTable.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <sys/stat.h>
+#endif
+
+using namespace dxc;
+using namespace llvm::opt;
+using namespace hlsl::options;
+
+namespace {
+
+// Size and modification time of a file on disk, used to detect cached files
+// that changed between requests.
+struct FileStamp {
+  uint64_t Size = 0;
+  uint64_t ModTime = 0;
+  bool operator==(const FileStamp &Other) const {
+    return Size == Other.Size && ModTime == Other.ModTime;
+  }
+};
+
+bool GetFileStamp(LPCWSTR pFileName, FileStamp &Stamp) {
+#ifdef _WIN32
+  WIN32_FILE_ATTRIBUTE_DATA Data;
+  if (!GetFileAttributesExW(pFileName, GetFileExInfoStandard, &Data))
+    return false;
+  Stamp.Size = ((uint64_t)Data.nFileSizeHigh << 32) | Data.nFileSizeLow;
+  Stamp.ModTime = ((uint64_t)Data.ftLastWriteTime.dwHighDateTime << 32) |
+                  Data.ftLastWriteTime.dwLowDateTime;
+#else
+  std::string FileName;
+  struct stat Status;
+  if (!Unicode::WideToUTF8String(pFileName, &FileName) ||
+      stat(FileName.c_str(), &Status) != 0)
+    return false;
+  Stamp.Size = (uint64_t)Status.st_size;
+#ifdef __APPLE__
+  Stamp.ModTime = (uint64_t)Status.st_mtimespec.tv_sec * 1000000000ull +
+                  Status.st_mtimespec.tv_nsec;
+#else
+  Stamp.ModTime = (uint64_t)Status.st_mtim.tv_sec * 1000000000ull +
+                  Status.st_mtim.tv_nsec;
+#endif
+#endif
+  return true;
+}
+
+// Source and include files shared by all workers. Every lookup compares the
+// size and modification time of the file on disk with the cached entry and
+// reloads files that changed, so edits between requests are always seen. A
+// 'reset' request drops all entries.
+class ServerFileCache {
+public:
+  explicit ServerFileCache(DxcDllSupport &dxcSupport)
+      : m_dxcSupport(dxcSupport) {}
+
+  HRESULT Load(LPCWSTR pFileName, IDxcBlobEncoding **ppBlob) {
+    std::wstring key(pFileName);
+    FileStamp Stamp;
+    bool HasStamp = GetFileStamp(pFileName, Stamp);
+    if (HasStamp) {
+      std::lock_guard<std::mutex> guard(m_lock);
+      auto it = m_files.find(key);
+      if (it != m_files.end() && it->second.Stamp == Stamp)
+        return it->second.Blob.QueryInterface(ppBlob);
+    }
+
+    CComPtr<IDxcUtils> pUtils;
+    IFR(m_dxcSupport.CreateInstance(CLSID_DxcUtils, &pUtils));
+    CComPtr<IDxcBlobEncoding> pBlob;
+    IFR(pUtils->LoadFile(pFileName, nullptr, &pBlob));
+
+    // Files whose stamp cannot be read are served but never cached.
+    if (HasStamp) {
+      std::lock_guard<std::mutex> guard(m_lock);
+      Entry &E = m_files[key];
+      E.Blob = pBlob;
+      E.Stamp = Stamp;
+    }
+    return pBlob.QueryInterface(ppBlob);
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_files.clear();
+  }
+
+private:
+  struct Entry {
+    CComPtr<IDxcBlobEncoding> Blob;
+    FileStamp Stamp;
+  };
+  DxcDllSupport &m_dxcSupport;
+  std::mutex m_lock;
+  std::unordered_map<std::wstring, Entry> m_files;
+};
+
+class DxcIncludeHandlerForServerCache : public IDxcIncludeHandler {
+private:
+  DXC_MICROCOM_REF_FIELD(m_dwRef)
+  ServerFileCache &m_cache;
+
+public:
+  DXC_MICROCOM_ADDREF_RELEASE_IMPL(m_dwRef)
+  DxcIncludeHandlerForServerCache(ServerFileCache &cache)
+      : m_dwRef(0), m_cache(cache) {}
+
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
+                                           void **ppvObject) override {
+    return DoBasicQueryInterface<IDxcIncludeHandler>(this, iid, ppvObject);
+  }
+
+  HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR pFilename,
+                                       IDxcBlob **ppIncludeSource) override {
+    if (ppIncludeSource == nullptr)
+      return E_INVALIDARG;
+    *ppIncludeSource = nullptr;
+    if (pFilename == nullptr)
+      return E_INVALIDARG;
+    try {
+      CComPtr<IDxcBlobEncoding> pBlob;
+      IFR(m_cache.Load(pFilename, &pBlob));
+      return pBlob.QueryInterface(ppIncludeSource);
+    }
+    CATCH_CPP_RETURN_HRESULT();
+  }
+};
+
+struct ServerRequest {
+  std::string Id;
+  std::string Command;
+  std::vector<llvm::StringRef> Args;
+  // Owns the strings referenced by Args.
+  std::unique_ptr<llvm::BumpPtrAllocator> Storage;
+};
+
+struct ServerResponse {
+  HRESULT Status = S_OK;
+  CComPtr<IDxcBlob> Output;
+  std::string Diagnostics;
+};
+
+// Per-thread state. Compiler and validator instances are created once and
+// reused for every request the worker serves.
+class ServerWorker {
+public:
+  ServerWorker(DxcDllSupport &dxcSupport, ServerFileCache &cache,
+               const OptTable *optionTable)
+      : m_dxcSupport(dxcSupport), m_cache(cache), m_optionTable(optionTable) {}
+
+  void Handle(const ServerRequest &Request, ServerResponse &Response) {
+    if (Request.Command == "compile")
+      Compile(Request, Response);
+    else if (Request.Command == "link")
+      Link(Request, Response);
+    else if (Request.Command == "validate")
+      Validate(Request, Response);
+    else if (Request.Command == "disassemble")
+      Disassemble(Request, Response);
+    else {
+      Response.Status = E_INVALIDARG;
+      Response.Diagnostics = "unknown request '" + Request.Command + "'";
+    }
+  }
+
+private:
+  DxcDllSupport &m_dxcSupport;
+  ServerFileCache &m_cache;
+  const OptTable *m_optionTable;
+  CComPtr<IDxcCompiler> m_pCompiler;
+  CComPtr<IDxcValidator> m_pValidator;
+  // Library files and their contents, in registration order.
+  typedef std::vector<std::pair<std::wstring, CComPtr<IDxcBlobEncoding>>>
+      LinkedLibs;
+  CComPtr<IDxcLinker> m_pLinker;
+  LinkedLibs m_linkedLibs;
+
+  IDxcCompiler *GetCompiler() {
+    if (!m_pCompiler)
+      IFT(m_dxcSupport.CreateInstance(CLSID_DxcCompiler, &m_pCompiler));
+    return m_pCompiler;
+  }
+
+  IDxcValidator *GetValidator() {
+    if (!m_pValidator)
+      IFT(m_dxcSupport.CreateInstance(CLSID_DxcValidator, &m_pValidator));
+    return m_pValidator;
+  }
+
+  bool ParseOpts(const ServerRequest &Request, MainArgs &Args, DxcOpts &Opts,
+                 ServerResponse &Response) {
+    Args = MainArgs(Request.Args);
+    llvm::raw_string_ostream ErrorStream(Response.Diagnostics);
+    int OptResult =
+        ReadDxcOpts(m_optionTable, DxcFlags, Args, Opts, ErrorStream);
+    ErrorStream.flush();
+    if (OptResult != 0) {
+      Response.Status = E_INVALIDARG;
+      return false;
+    }
+    // Outputs are returned in the response, so options that would have dxc
+    // write files are rejected rather than silently ignored.
+    static const OptSpecifier OutputFileOpts[] = {
+        OPT_Fo, OPT_Fc,  OPT_Fh,         OPT_Fd,
+        OPT_Fe, OPT_Fre, OPT_Frs,        OPT_Fsh,
+        OPT_Fi, OPT_P,   OPT_getprivate, OPT_write_dependencies_to};
+    for (OptSpecifier Id : OutputFileOpts) {
+      if (const Arg *A = Opts.Args.getLastArg(Id)) {
+        Response.Status = E_INVALIDARG;
+        Response.Diagnostics = "option '" + A->getAsString(Opts.Args) +
+                               "' writes a file and is not supported by " +
+                               Request.Command + " requests";
+        return false;
+      }
+    }
+    if (Opts.EntryPoint.empty())
+      Opts.EntryPoint = "main";
+    return true;
+  }
+
+  static bool SameLibs(const LinkedLibs &A, const LinkedLibs &B) {
+    if (A.size() != B.size())
+      return false;
+    for (size_t i = 0; i < A.size(); ++i)
+      if (A[i].first != B[i].first || A[i].second.p != B[i].second.p)
+        return false;
+    return true;
+  }
+
+  static void CopyCoreArgs(const DxcOpts &Opts, std::vector<std::wstring> &Wide,
+                           std::vector<LPCWSTR> &Ptrs) {
+    CopyArgsToWStrings(Opts.Args, CoreOption, Wide);
+    Ptrs.reserve(Wide.size());
+    for (const std::wstring &a : Wide)
+      Ptrs.push_back(a.data());
+  }
+
+  static void TakeResult(IDxcOperationResult *pResult,
+                         ServerResponse &Response) {
+    IFT(pResult->GetStatus(&Response.Status));
+    CComPtr<IDxcBlobEncoding> pErrors;
+    IFT(pResult->GetErrorBuffer(&pErrors));
+    if (pErrors.p != nullptr && pErrors->GetBufferSize() != 0) {
+      CComPtr<IDxcBlobUtf8> pErrorsUtf8;
+      IFT(hlsl::DxcGetBlobAsUtf8(pErrors, DxcGetThreadMallocNoRef(),
+                                 &pErrorsUtf8));
+      Response.Diagnostics.append(pErrorsUtf8->GetStringPointer(),
+                                  pErrorsUtf8->GetStringLength());
+    }
+    if (SUCCEEDED(Response.Status))
+      IFT(pResult->GetResult(&Response.Output));
+  }
+
+  void Compile(const ServerRequest &Request, ServerResponse &Response) {
+    MainArgs Args;
+    DxcOpts Opts;
+    if (!ParseOpts(Request, Args, Opts, Response))
+      return;
+
+    CComPtr<IDxcBlobEncoding> pSource;
+    IFT(m_cache.Load(StringRefWide(Opts.InputFile), &pSource));
+    CComPtr<IDxcIncludeHandler> pIncludeHandler(
+        new DxcIncludeHandlerForServerCache(m_cache));
+
+    std::vector<std::wstring> WideArgs;
+    std::vector<LPCWSTR> ArgPtrs;
+    CopyCoreArgs(Opts, WideArgs, ArgPtrs);
+
+    CComPtr<IDxcOperationResult> pResult;
+    IFT(GetCompiler()->Compile(
+        pSource, StringRefWide(Opts.InputFile), StringRefWide(Opts.EntryPoint),
+        StringRefWide(Opts.TargetProfile), ArgPtrs.data(), ArgPtrs.size(),
+        Opts.Defines.data(), Opts.Defines.size(), pIncludeHandler, &pResult));
+    TakeResult(pResult, Response);
+  }
+
+  void Link(const ServerRequest &Request, ServerResponse &Response) {
+    MainArgs Args;
+    DxcOpts Opts;
+    if (!ParseOpts(Request, Args, Opts, Response))
+      return;
+
+    llvm::SmallVector<llvm::StringRef, 4> InputFileList;
+    Opts.InputFile.split(InputFileList, ";");
+    LinkedLibs Libs;
+    for (llvm::StringRef File : InputFileList) {
+      std::wstring Name = Unicode::UTF8ToWideStringOrThrow(File.str().c_str());
+      CComPtr<IDxcBlobEncoding> pLib;
+      IFT(m_cache.Load(Name.c_str(), &pLib));
+      Libs.emplace_back(std::move(Name), pLib);
+    }
+
+    // A linker keeps its libraries parsed and each link only attaches the
+    // ones it names. Libraries add their metadata kinds to the linker's
+    // context, which are all written to the output, so a linker is only
+    // reused for the same files in the same order; output then matches a
+    // fresh link.
+    if (!m_pLinker || !SameLibs(Libs, m_linkedLibs)) {
+      m_pLinker.Release();
+      m_linkedLibs.clear();
+      CComPtr<IDxcLinker> pLinker;
+      IFT(m_dxcSupport.CreateInstance(CLSID_DxcLinker, &pLinker));
+      for (auto &Lib : Libs)
+        IFT(pLinker->RegisterLibrary(Lib.first.c_str(), Lib.second));
+      m_pLinker = pLinker;
+      m_linkedLibs = Libs;
+    }
+
+    std::vector<LPCWSTR> InputPtrs;
+    for (auto &Lib : m_linkedLibs)
+      InputPtrs.push_back(Lib.first.c_str());
+    std::vector<std::wstring> WideArgs;
+    std::vector<LPCWSTR> ArgPtrs;
+    CopyCoreArgs(Opts, WideArgs, ArgPtrs);
+
+    CComPtr<IDxcOperationResult> pResult;
+    IFT(m_pLinker->Link(StringRefWide(Opts.EntryPoint),
+                        StringRefWide(Opts.TargetProfile), InputPtrs.data(),
+                        InputPtrs.size(), ArgPtrs.data(), ArgPtrs.size(),
+                        &pResult));
+    TakeResult(pResult, Response);
+  }
+
+  // Containers are read from disk for every request rather than the cache,
+  // since they are usually outputs of earlier requests.
+  bool LoadContainer(const ServerRequest &Request, ServerResponse &Response,
+                     CComPtr<IDxcBlobEncoding> &pContainer) {
+    if (Request.Args.size() != 1) {
+      Response.Status = E_INVALIDARG;
+      Response.Diagnostics = Request.Command + " expects a single file";
+      return false;
+    }
+    ReadFileIntoBlob(m_dxcSupport, StringRefWide(Request.Args[0]),
+                     &pContainer);
+    return true;
+  }
+
+  void Validate(const ServerRequest &Request, ServerResponse &Response) {
+    CComPtr<IDxcBlobEncoding> pContainer;
+    if (!LoadContainer(Request, Response, pContainer))
+      return;
+    CComPtr<IDxcOperationResult> pResult;
+    IFT(GetValidator()->Validate(pContainer, DxcValidatorFlags_Default,
+                                 &pResult));
+    IFT(pResult->GetStatus(&Response.Status));
+    CComPtr<IDxcBlobEncoding> pErrors;
+    IFT(pResult->GetErrorBuffer(&pErrors));
+    if (pErrors.p != nullptr && pErrors->GetBufferSize() != 0) {
+      CComPtr<IDxcBlobUtf8> pErrorsUtf8;
+      IFT(hlsl::DxcGetBlobAsUtf8(pErrors, DxcGetThreadMallocNoRef(),
+                                 &pErrorsUtf8));
+      Response.Diagnostics.append(pErrorsUtf8->GetStringPointer(),
+                                  pErrorsUtf8->GetStringLength());
+    }
+  }
+
+  void Disassemble(const ServerRequest &Request, ServerResponse &Response) {
+    CComPtr<IDxcBlobEncoding> pContainer;
+    if (!LoadContainer(Request, Response, pContainer))
+      return;
+    CComPtr<IDxcBlobEncoding> pDisassembly;
+    Response.Status = GetCompiler()->Disassemble(pContainer, &pDisassembly);
+    Response.Output = pDisassembly;
+  }
+};
+
+// Runs a request on the calling worker, converting exceptions into failed
+// responses so a single bad request never takes the server down.
+void ServeRequest(ServerWorker &Worker, const ServerRequest &Request,
+                  ServerResponse &Response) {
+  try {
+    Worker.Handle(Request, Response);
+  } catch (const ::hlsl::Exception &hlslException) {
+    Response.Status = FAILED(hlslException.hr) ? hlslException.hr : E_FAIL;
+    Response.Output.Release();
+    Response.Diagnostics += hlslException.what();
+  } catch (std::bad_alloc &) {
+    Response.Status = E_OUTOFMEMORY;
+    Response.Output.Release();
+  } catch (...) {
+    Response.Status = E_FAIL;
+    Response.Output.Release();
+  }
+}
+
+void WriteResponse(std::mutex &OutputLock, const std::string &Id,
+                   const ServerResponse &Response, uint64_t Micros) {
+  const char *pOutput = nullptr;
+  size_t OutputSize = 0;
+  if (Response.Output) {
+    pOutput = (const char *)Response.Output->GetBufferPointer();
+    OutputSize = Response.Output->GetBufferSize();
+  }
+  std::lock_guard<std::mutex> Guard(OutputLock);
+  fprintf(stdout, "%s 0x%08x %llu %llu %llu\n", Id.c_str(),
+          (unsigned)Response.Status, (unsigned long long)Micros,
+          (unsigned long long)OutputSize,
+          (unsigned long long)Response.Diagnostics.size());
+  if (OutputSize)
+    fwrite(pOutput, 1, OutputSize, stdout);
+  if (!Response.Diagnostics.empty())
+    fwrite(Response.Diagnostics.data(), 1, Response.Diagnostics.size(),
+           stdout);
+  fflush(stdout);
+}
+
+bool ParseRequestLine(llvm::StringRef Line, ServerRequest &Request) {
+  Request.Storage.reset(new llvm::BumpPtrAllocator());
+  llvm::BumpPtrStringSaver Saver(*Request.Storage);
+  llvm::SmallVector<const char *, 32> Tokens;
+  llvm::cl::TokenizeGNUCommandLine(Line, Saver, Tokens);
+  if (Tokens.size() < 2)
+    return false;
+  Request.Id = Tokens[0];
+  Request.Command = Tokens[1];
+  Request.Args.assign(Tokens.begin() + 2, Tokens.end());
+  return true;
+}
+
+} // namespace
+
+int dxc::RunServer(const DxcOpts &Opts, DxcDllSupport &DxcSupport,
+                   const OptTable *OptionTable) {
+#ifdef _WIN32
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+  unsigned NumWorkers = Opts.BatchJobs;
+  if (NumWorkers == 0)
+    NumWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+  ServerFileCache Cache(DxcSupport);
+  std::mutex QueueLock;
+  std::condition_variable QueueCV;
+  std::deque<std::unique_ptr<ServerRequest>> Queue;
+  // Requests queued or being served; 'reset' waits for this to drain so it
+  // never races with requests that were sent before it.
+  unsigned Pending = 0;
+  bool Done = false;
+  std::mutex OutputLock;
+
+  auto Worker = [&]() {
+    DxcSetThreadMallocToDefault();
+    {
+      ServerWorker State(DxcSupport, Cache, OptionTable);
+      for (;;) {
+        std::unique_ptr<ServerRequest> Request;
+        {
+          std::unique_lock<std::mutex> Lock(QueueLock);
+          QueueCV.wait(Lock, [&]() { return Done || !Queue.empty(); });
+          if (Queue.empty())
+            break;
+          Request = std::move(Queue.front());
+          Queue.pop_front();
+        }
+        auto Start = std::chrono::steady_clock::now();
+        ServerResponse Response;
+        ServeRequest(State, *Request, Response);
+        auto Micros = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - Start)
+                          .count();
+        WriteResponse(OutputLock, Request->Id, Response, (uint64_t)Micros);
+        {
+          std::lock_guard<std::mutex> Lock(QueueLock);
+          --Pending;
+        }
+        QueueCV.notify_all();
+      }
+    }
+    DxcClearThreadMalloc();
+  };
+
+  std::vector<std::thread> Workers;
+  Workers.reserve(NumWorkers);
+  for (unsigned i = 0; i < NumWorkers; ++i)
+    Workers.emplace_back(Worker);
+
+  std::string Line;
+  while (std::getline(std::cin, Line)) {
+    llvm::StringRef Trimmed = llvm::StringRef(Line).trim();
+    if (Trimmed.empty())
+      continue;
+    std::unique_ptr<ServerRequest> Request(new ServerRequest());
+    if (!ParseRequestLine(Trimmed, *Request)) {
+      ServerResponse Response;
+      Response.Status = E_INVALIDARG;
+      Response.Diagnostics = "malformed request";
+      WriteResponse(OutputLock, Request->Id.empty() ? "-" : Request->Id,
+                    Response, 0);
+      continue;
+    }
+    if (Request->Command == "quit")
+      break;
+    if (Request->Command == "reset") {
+      std::unique_lock<std::mutex> Lock(QueueLock);
+      QueueCV.wait(Lock, [&]() { return Pending == 0; });
+      Cache.Clear();
+      WriteResponse(OutputLock, Request->Id, ServerResponse(), 0);
+      continue;
+    }
+    {
+      std::lock_guard<std::mutex> Lock(QueueLock);
+      Queue.push_back(std::move(Request));
+      ++Pending;
+    }
+    QueueCV.notify_all();
+  }
+
+  {
+    std::lock_guard<std::mutex> Lock(QueueLock);
+    Done = true;
+  }
+  QueueCV.notify_all();
+  for (std::thread &T : Workers)
+    T.join();
+  return 0;
+}
@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+// dxcserver.h                                                               //
+// Copyright (C) Microsoft Corporation. All rights reserved.                 //
+// This file is distributed under the University of Illinois Open Source     //
+// License. See LICENSE.TXT for details.                                     //
+//                                                                           //
+// Provides a long-lived request/response mode for the dxc console program.  //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#ifndef __DXC_DXCSERVER__
+#define __DXC_DXCSERVER__
+
+namespace llvm {
+namespace opt {
+class OptTable;
+}
+} // namespace llvm
+
+namespace hlsl {
+namespace options {
+class DxcOpts;
+}
+} // namespace hlsl
+
+namespace dxc {
+class DxcDllSupport;
+
+// Serves compile, link, validate and disassemble requests read from stdin
+// until end of input or a 'quit' request, writing framed responses to stdout.
+//
+// Each request is a single line:
+//   <id> <command> <arguments...>
+// where <command> is one of compile, link, validate, disassemble, reset or
+// quit, and arguments are quoted like a response file. compile and link take
+// the same arguments as the dxc command line (link inputs are separated by
+// ';'), validate and disassemble take a container file.
+//
+// Each response is a header line followed by two byte ranges:
+//   <id> <hresult> <microseconds> <output-size> <diagnostics-size>\n
+//   <output bytes><diagnostics bytes>
+//
+// Requests are served concurrently by a pool of workers that keep their
+// compiler and validator instances alive between requests. Source and include
+// files are cached in memory and reloaded when their size or modification
+// time changes; a 'reset' request drops the cache. A worker keeps its link
+// libraries parsed while consecutive link requests name the same unchanged
+// files. Options that write output files are rejected. The frontend still
+// builds its builtin declarations for each compile.
+int RunServer(const hlsl::options::DxcOpts &Opts, DxcDllSupport &DxcSupport,
+              const llvm::opt::OptTable *OptionTable);
+} // namespace dxc
+
+#endif // __DXC_DXCSERVER__
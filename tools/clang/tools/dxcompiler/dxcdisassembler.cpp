@@ -35,9 +35,13 @@
 #include "llvm/IR/DiagnosticInfo.h"
 #include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/IR/ModuleSlotTracker.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/FormattedStream.h"
 #include <assert.h> // Needed for DxilPipelineStateValidation.h
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace llvm;
 using namespace hlsl;
@@ -54,7 +58,7 @@ bool SigElementHasStream(const DxilProgramSignatureElement &pSignature) {
 }
 
 void PrintSignature(LPCSTR pName, const DxilProgramSignature *pSignature,
-                    bool bIsInput, raw_string_ostream &OS, StringRef comment) {
+                    bool bIsInput, raw_ostream &OS, StringRef comment) {
   OS << comment << "\n"
      << comment << " " << pName << " signature:\n"
      << comment << "\n"
@@ -267,7 +271,7 @@ void PrintSignature(LPCSTR pName, const DxilProgramSignature *pSignature,
   OS << comment << "\n";
 }
 
-void PintCompMaskNameCompact(raw_string_ostream &OS, unsigned CompMask) {
+void PintCompMaskNameCompact(raw_ostream &OS, unsigned CompMask) {
   char Mask[5];
   memset(Mask, '\0', sizeof(Mask));
   unsigned idx = 0;
@@ -283,7 +287,7 @@ void PintCompMaskNameCompact(raw_string_ostream &OS, unsigned CompMask) {
 }
 
 void PrintDxilSignature(LPCSTR pName, const DxilSignature &Signature,
-                        raw_string_ostream &OS, StringRef comment) {
+                        raw_ostream &OS, StringRef comment) {
   const std::vector<std::unique_ptr<DxilSignatureElement>> &sigElts =
       Signature.GetElements();
   if (sigElts.size() == 0)
@@ -354,7 +358,7 @@ static_assert(_countof(g_pFeatureInfoNames) == ShaderFeatureInfoCount,
               "g_pFeatureInfoNames needs to be updated");
 
 void PrintFeatureInfo(const DxilShaderFeatureInfo *pFeatureInfo,
-                      raw_string_ostream &OS, StringRef comment) {
+                      raw_ostream &OS, StringRef comment) {
   uint64_t featureFlags = pFeatureInfo->FeatureFlags;
   if (!featureFlags)
     return;
@@ -368,7 +372,7 @@ void PrintFeatureInfo(const DxilShaderFeatureInfo *pFeatureInfo,
 }
 
 void PrintResourceFormat(DxilResourceBase &res, unsigned alignment,
-                         raw_string_ostream &OS) {
+                         raw_ostream &OS) {
   switch (res.GetClass()) {
   case DxilResourceBase::Class::CBuffer:
   case DxilResourceBase::Class::Sampler:
@@ -398,7 +402,7 @@ void PrintResourceFormat(DxilResourceBase &res, unsigned alignment,
 }
 
 void PrintResourceDim(DxilResourceBase &res, unsigned alignment,
-                      raw_string_ostream &OS) {
+                      raw_ostream &OS) {
   switch (res.GetClass()) {
   case DxilResourceBase::Class::CBuffer:
   case DxilResourceBase::Class::Sampler:
@@ -440,7 +444,7 @@ void PrintResourceDim(DxilResourceBase &res, unsigned alignment,
   }
 }
 
-void PrintResourceBinding(DxilResourceBase &res, raw_string_ostream &OS,
+void PrintResourceBinding(DxilResourceBase &res, raw_ostream &OS,
                           StringRef comment) {
   OS << comment << " " << left_justify(res.GetGlobalName(), 31);
 
@@ -466,7 +470,7 @@ void PrintResourceBinding(DxilResourceBase &res, raw_string_ostream &OS,
     OS << right_justify("unbounded", 6) << "\n";
 }
 
-void PrintResourceBindings(DxilModule &M, raw_string_ostream &OS,
+void PrintResourceBindings(DxilModule &M, raw_ostream &OS,
                            StringRef comment) {
   OS << comment << "\n"
      << comment << " Resource Bindings:\n"
@@ -533,7 +537,7 @@ void PrintInputsContributingToOutputs(
   }
 }
 
-void PrintViewIdState(DxilModule &M, raw_string_ostream &OS,
+void PrintViewIdState(DxilModule &M, raw_ostream &OS,
                       StringRef comment) {
   if (!M.GetModule()->getNamedMetadata("dx.viewIdState"))
     return;
@@ -668,7 +672,7 @@ static const char *HitGroupTypeToString(DXIL::HitGroupType type) {
   return "<invalid HitGroupType>";
 }
 
-template <typename _T> void PrintFlags(raw_string_ostream &OS, uint32_t Flags) {
+template <typename _T> void PrintFlags(raw_ostream &OS, uint32_t Flags) {
   if (!Flags) {
     OS << "0";
     return;
@@ -683,7 +687,7 @@ template <typename _T> void PrintFlags(raw_string_ostream &OS, uint32_t Flags) {
   }
 }
 
-void PrintSubobjects(const DxilSubobjects &subobjects, raw_string_ostream &OS,
+void PrintSubobjects(const DxilSubobjects &subobjects, raw_ostream &OS,
                      StringRef comment) {
   if (subobjects.GetSubobjects().empty())
     return;
@@ -803,7 +807,7 @@ void PrintSubobjects(const DxilSubobjects &subobjects, raw_string_ostream &OS,
 }
 
 void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
-                       const DataLayout *DL, raw_string_ostream &OS,
+                       const DataLayout *DL, raw_ostream &OS,
                        StringRef comment, StringRef varName, unsigned offset,
                        unsigned indent, unsigned arraySize,
                        unsigned sizeOfStruct = 0);
@@ -844,7 +848,7 @@ void PrintTypeAndName(llvm::Type *Ty, DxilFieldAnnotation &annotation,
 
 void PrintFieldLayout(llvm::Type *Ty, DxilFieldAnnotation &annotation,
                       DxilTypeSystem &typeSys, const DataLayout *DL,
-                      raw_string_ostream &OS, StringRef comment,
+                      raw_ostream &OS, StringRef comment,
                       unsigned offset, unsigned indent, unsigned offsetIndent,
                       unsigned sizeToPrint = 0) {
   if (Ty->isStructTy() && !annotation.HasMatrixAnnotation()) {
@@ -914,7 +918,7 @@ void PrintFieldLayout(llvm::Type *Ty, DxilFieldAnnotation &annotation,
 
 // null DataLayout => assume constant buffer layout
 void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
-                       const DataLayout *DL, raw_string_ostream &OS,
+                       const DataLayout *DL, raw_ostream &OS,
                        StringRef comment, StringRef varName, unsigned offset,
                        unsigned indent, unsigned offsetIndent,
                        unsigned sizeOfStruct) {
@@ -961,7 +965,7 @@ void PrintStructLayout(StructType *ST, DxilTypeSystem &typeSys,
 }
 
 void PrintStructBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
-                                 const DataLayout &DL, raw_string_ostream &OS,
+                                 const DataLayout &DL, raw_ostream &OS,
                                  StringRef comment) {
   const unsigned offsetIndent = 50;
 
@@ -1008,7 +1012,7 @@ void PrintStructBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
 }
 
 void PrintTBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
-                            raw_string_ostream &OS, StringRef comment) {
+                            raw_ostream &OS, StringRef comment) {
   const unsigned offsetIndent = 50;
   llvm::Type *Ty = buf->GetHLSLType()->getPointerElementType();
   // For TextureBuffer<> buf[2], the array size is in Resource binding count
@@ -1034,7 +1038,7 @@ void PrintTBufferDefinition(DxilResource *buf, DxilTypeSystem &typeSys,
 }
 
 void PrintCBufferDefinition(DxilCBuffer *buf, DxilTypeSystem &typeSys,
-                            raw_string_ostream &OS, StringRef comment) {
+                            raw_ostream &OS, StringRef comment) {
   const unsigned offsetIndent = 50;
   llvm::Type *Ty = buf->GetHLSLType()->getPointerElementType();
   // For ConstantBuffer<> buf[2], the array size is in Resource binding count
@@ -1060,7 +1064,7 @@ void PrintCBufferDefinition(DxilCBuffer *buf, DxilTypeSystem &typeSys,
   OS << comment << "\n";
 }
 
-void PrintBufferDefinitions(DxilModule &M, raw_string_ostream &OS,
+void PrintBufferDefinitions(DxilModule &M, raw_ostream &OS,
                             StringRef comment) {
   OS << comment << "\n"
      << comment << " Buffer Definitions:\n"
@@ -1331,7 +1335,7 @@ public:
 void PrintPipelineStateValidationRuntimeInfo(const char *pBuffer,
                                              const uint32_t uBufferSize,
                                              DXIL::ShaderKind shaderKind,
-                                             raw_string_ostream &OS,
+                                             raw_ostream &OS,
                                              StringRef comment) {
   OS << comment << "\n"
      << comment << " Pipeline Runtime Information: \n"
@@ -1610,11 +1614,126 @@ void PrintPipelineStateValidationRuntimeInfo(const char *pBuffer,
 
   OS << comment << "\n";
 }
+
+// Prints the given functions on up to NumThreads threads. Each function is
+// printed into its own buffer, and the buffers are written to the stream in
+// order as soon as the functions before them are done; only a window of
+// functions past the last one written is printed ahead.
+void PrintFunctionsInParallel(const StreamingModulePrinter &Printer,
+                              ArrayRef<const Function *> Functions,
+                              unsigned NumThreads, raw_ostream &OS) {
+  const size_t Window = NumThreads * 4;
+  std::vector<std::string> Buffers(Functions.size());
+  std::vector<bool> Printed(Functions.size());
+  size_t Next = 0;
+  size_t Written = 0;
+  std::exception_ptr Error;
+  std::mutex Mutex;
+  std::condition_variable Changed;
+
+  IMalloc *pMalloc = DxcGetThreadMallocNoRef();
+  auto PrintFunctions = [&]() {
+    DxcThreadMalloc TM(pMalloc);
+    for (;;) {
+      size_t Index;
+      {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        Changed.wait(Lock, [&]() {
+          return Error || Next == Functions.size() || Next < Written + Window;
+        });
+        if (Error || Next == Functions.size())
+          return;
+        Index = Next++;
+      }
+      std::string Text;
+      try {
+        raw_string_ostream TextStream(Text);
+        Printer.printFunction(*Functions[Index], TextStream);
+        TextStream.flush();
+      } catch (...) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        if (!Error)
+          Error = std::current_exception();
+        Changed.notify_all();
+        return;
+      }
+      std::lock_guard<std::mutex> Lock(Mutex);
+      Buffers[Index].swap(Text);
+      Printed[Index] = true;
+      Changed.notify_all();
+    }
+  };
+
+  std::vector<std::thread> Threads;
+  for (unsigned i = 0; i < NumThreads; ++i)
+    Threads.emplace_back(PrintFunctions);
+
+  try {
+    for (size_t i = 0; i < Functions.size(); ++i) {
+      std::string Text;
+      {
+        std::unique_lock<std::mutex> Lock(Mutex);
+        Changed.wait(Lock, [&]() { return Error || Printed[i]; });
+        if (Error)
+          break;
+        Text.swap(Buffers[i]);
+        Written = i + 1;
+        Changed.notify_all();
+      }
+      OS << Text;
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    if (!Error)
+      Error = std::current_exception();
+    Changed.notify_all();
+  }
+
+  for (std::thread &T : Threads)
+    T.join();
+  if (Error)
+    std::rethrow_exception(Error);
+}
+
+// Prints the module like Module::print, except that only the definitions
+// selected by Opts are printed, and their bodies may be printed in parallel.
+void PrintModule(const Module &M, AssemblyAnnotationWriter *AAW,
+                 const dxcutil::DisassembleOptions &Opts, raw_ostream &OS) {
+  StreamingModulePrinter Printer(M, AAW);
+
+  std::vector<const Function *> Functions;
+  for (const Function &F : M) {
+    if (!F.isDeclaration() && !Opts.Functions.empty() &&
+        std::none_of(Opts.Functions.begin(), Opts.Functions.end(),
+                     [&](const std::string &Name) {
+                       return F.getName() == Name ||
+                              dxilutil::DemangleFunctionName(F.getName()) ==
+                                  Name;
+                     }))
+      continue;
+    Functions.push_back(&F);
+  }
+
+  unsigned NumThreads = Opts.NumThreads;
+  if (NumThreads == 0)
+    NumThreads = std::max(1u, std::thread::hardware_concurrency());
+  NumThreads = std::min<size_t>(NumThreads, Functions.size());
+
+  Printer.printHeader(OS);
+  if (NumThreads <= 1) {
+    for (const Function *F : Functions)
+      Printer.printFunction(*F, OS);
+  } else {
+    PrintFunctionsInParallel(Printer, Functions, NumThreads, OS);
+  }
+  Printer.printTrailer(OS);
+}
 } // namespace
 
 namespace dxcutil {
 
-HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
+HRESULT Disassemble(IDxcBlob *pProgram, raw_ostream &Stream,
+                    const DisassembleOptions &Opts) {
   CComPtr<IDxcBlob> pPdbContainerBlob;
   {
     CComPtr<IStream> pStream;
@@ -1762,7 +1881,9 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
 
   std::unique_ptr<llvm::Module> pReflectionModule;
   if (pReflectionIL && pReflectionILLength) {
-    pReflectionModule = dxilutil::LoadModuleFromBitcode(
+    // Only metadata (resources, type annotations, ViewID state) is read from
+    // the reflection module, so function bodies are never materialized.
+    pReflectionModule = dxilutil::LoadModuleFromBitcodeLazy(
         llvm::StringRef(pReflectionIL, pReflectionILLength), llvmContext,
         DiagStr);
     if (pReflectionModule.get() == nullptr) {
@@ -1814,7 +1935,7 @@ HRESULT Disassemble(IDxcBlob *pProgram, raw_string_ostream &Stream) {
     }
   }
   DxcAssemblyAnnotationWriter w;
-  pModule->print(Stream, &w);
+  PrintModule(*pModule, &w, Opts, Stream);
   // if (pReflectionModule) {
   //   Stream << "\n========== Reflection Module from STAT part ==========\n";
   //   pReflectionModule->print(Stream, &w);
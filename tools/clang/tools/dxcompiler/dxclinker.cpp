@@ -200,13 +200,20 @@ DxcLinker::RegisterLibrary(LPCWSTR pLibName, // Name of the library.
 
     raw_stream_ostream DiagStream(pDiagStream);
 
+    // The debug module is linked instead of the program module when the
+    // library has one, so debug info in the program part would go unused.
+    const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
+        pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+    bool bHasDebugPart =
+        pHeader && hlsl::GetDxilPartByType(
+                       pHeader, hlsl::DxilFourCC::DFCC_ShaderDebugInfoDXIL);
+
     IFR(ValidateLoadModuleFromContainerLazy(
         pBlob->GetBufferPointer(), pBlob->GetBufferSize(), pModule,
-        pDebugModule, m_Ctx, m_Ctx, DiagStream));
+        pDebugModule, m_Ctx, m_Ctx, DiagStream,
+        /*bSkipProgramDebugInfo*/ bHasDebugPart));
 
     // add an entry into the library to compiler version part map
-    const hlsl::DxilContainerHeader *pHeader = hlsl::IsDxilContainerLike(
-        pBlob->GetBufferPointer(), pBlob->GetBufferSize());
     const DxilPartHeader *pDPH = hlsl::GetDxilPartByType(
         pHeader, hlsl::DxilFourCC::DFCC_CompilerVersion);
     if (pDPH) {
@@ -254,6 +261,11 @@ HRESULT STDMETHODCALLTYPE DxcLinker::Link(
   // Detach previous libraries.
   m_pLinker->DetachAll();
 
+  // Metadata kinds registered while building this output are dropped again
+  // afterwards, so they do not end up in the bitcode of later links.
+  llvm::SmallVector<llvm::StringRef, 32> MDKindNames;
+  m_Ctx.getMDKindNames(MDKindNames);
+
   HRESULT hr = S_OK;
   try {
     CComPtr<IDxcBlob> pOutputBlob;
@@ -486,6 +498,7 @@ HRESULT STDMETHODCALLTYPE DxcLinker::Link(
     IFT(pResult->QueryInterface(IID_PPV_ARGS(ppResult)));
   }
   CATCH_CPP_ASSIGN_HRESULT();
+  m_Ctx.dropMDKindsFrom(MDKindNames.size());
   return hr;
 }
 
@@ -58,6 +58,7 @@
 #include "dxillib.h"
 #include <algorithm>
 #include <cfloat>
+#include <mutex>
 
 // SPIRV change starts
 #ifdef ENABLE_SPIRV_CODEGEN
@@ -461,7 +462,94 @@ static HRESULT ErrorWithString(const std::string &error, REFIID riid,
   return S_OK;
 }
 
+// Idle LLVM contexts kept by a compiler object for compiles that request
+// /Qreuse_llvm_context, so they skip rebuilding the context's type, constant
+// and metadata tables. Each compile leases a context exclusively; concurrent
+// compiles on the same object get distinct contexts.
+class LLVMContextPool {
+public:
+  // A context is destroyed after this many compiles to bound the growth of
+  // the types and constants it retains from earlier modules.
+  static const unsigned kMaxUses = 64;
+
+  class Lease {
+  public:
+    // Leases a pooled context, or a private one if Pool is null.
+    explicit Lease(LLVMContextPool *Pool) : m_pPool(Pool), m_Uses(0) {
+      if (m_pPool)
+        m_pPool->Acquire(m_Context, m_Uses);
+      if (!m_Context)
+        m_Context.reset(new llvm::LLVMContext());
+    }
+    ~Lease() {
+      if (m_pPool && m_bReusable && m_Uses + 1 < kMaxUses &&
+          m_Context->resetForReuse())
+        m_pPool->Release(std::move(m_Context), m_Uses + 1);
+    }
+    llvm::LLVMContext &get() { return *m_Context; }
+    // Only contexts of compiles that ran to completion are returned to the
+    // pool; anything else is destroyed with the lease.
+    void SetReusable() { m_bReusable = true; }
+
+  private:
+    LLVMContextPool *m_pPool;
+    std::unique_ptr<llvm::LLVMContext> m_Context;
+    unsigned m_Uses;
+    bool m_bReusable = false;
+  };
+
+private:
+  struct Entry {
+    std::unique_ptr<llvm::LLVMContext> Context;
+    unsigned Uses;
+  };
+  std::mutex m_Lock;
+  std::vector<Entry> m_Idle;
+
+  void Acquire(std::unique_ptr<llvm::LLVMContext> &Context, unsigned &Uses) {
+    std::lock_guard<std::mutex> Guard(m_Lock);
+    if (m_Idle.empty())
+      return;
+    Context = std::move(m_Idle.back().Context);
+    Uses = m_Idle.back().Uses;
+    m_Idle.pop_back();
+  }
+  void Release(std::unique_ptr<llvm::LLVMContext> Context, unsigned Uses) {
+    std::lock_guard<std::mutex> Guard(m_Lock);
+    m_Idle.push_back(Entry{std::move(Context), Uses});
+  }
+};
+
+// Forwards the text written to it to a caller-provided stream. Short writes
+// are retried until the sink stops making progress. Writes stop at the first
+// failure, which is returned by GetStatus after flushing.
+class raw_sink_ostream : public llvm::raw_ostream {
+  IStream *m_pSink;
+  uint64_t m_Position = 0;
+  HRESULT m_Status = S_OK;
+  void write_impl(const char *Ptr, size_t Size) override {
+    m_Position += Size;
+    while (Size != 0 && SUCCEEDED(m_Status)) {
+      ULONG cbWritten = 0;
+      m_Status = m_pSink->Write(Ptr, (ULONG)Size, &cbWritten);
+      if (SUCCEEDED(m_Status) && (cbWritten == 0 || cbWritten > Size))
+        m_Status = E_FAIL;
+      Ptr += cbWritten;
+      Size -= cbWritten;
+    }
+  }
+  uint64_t current_pos() const override { return m_Position; }
+
+public:
+  raw_sink_ostream(IStream *pSink) : m_pSink(pSink) {
+    SetBufferSize(64 * 1024);
+  }
+  ~raw_sink_ostream() override { flush(); }
+  HRESULT GetStatus() const { return m_Status; }
+};
+
 class DxcCompiler : public IDxcCompiler3,
+                    public IDxcStreamingDisassembler,
                     public IDxcLangExtensions3,
                     public IDxcContainerEvent,
                     public IDxcVersionInfo3,
@@ -476,6 +564,9 @@ private:
   DxcLangExtensionsHelper m_langExtensionsHelper;
   CComPtr<IDxcContainerEventsHandler> m_pDxcContainerEventsHandler;
   DxcCompilerAdapter m_DxcCompilerAdapter;
+  // Pooled contexts are freed by the destructor, which Release runs with
+  // m_pMalloc as the thread malloc.
+  LLVMContextPool m_ContextPool;
 
 public:
   DxcCompiler(IMalloc *pMalloc)
@@ -502,7 +593,8 @@ public:
 
   HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid,
                                            void **ppvObject) override {
-    HRESULT hr = DoBasicQueryInterface<IDxcCompiler3, IDxcLangExtensions,
+    HRESULT hr = DoBasicQueryInterface<IDxcCompiler3, IDxcStreamingDisassembler,
+                                       IDxcLangExtensions,
                                        IDxcLangExtensions2, IDxcLangExtensions3,
                                        IDxcContainerEvent, IDxcVersionInfo
 #ifdef SUPPORT_QUERY_GIT_COMMIT_INFO
@@ -684,8 +776,10 @@ public:
 
       // Setup a compiler instance.
       raw_stream_ostream outStream(pOutputStream.p);
-      llvm::LLVMContext
-          llvmContext; // LLVMContext should outlive CompilerInstance
+      // LLVMContext should outlive CompilerInstance
+      LLVMContextPool::Lease contextLease(
+          opts.ReuseLLVMContext ? &m_ContextPool : nullptr);
+      llvm::LLVMContext &llvmContext = contextLease.get();
       std::unique_ptr<llvm::Module> debugModule;
       CComPtr<AbstractMemoryStream> pReflectionStream;
       CompilerInstance compiler;
@@ -1147,7 +1241,8 @@ public:
                                            // do not generate source info at all
             debugSourceInfoWriter.Write(opts.TargetProfile, opts.EntryPoint,
                                         compiler.getCodeGenOpts(),
-                                        compiler.getSourceManager());
+                                        compiler.getSourceManager(),
+                                        opts.PdbSourceBlocks);
             pSourceInfo = debugSourceInfoWriter.GetPart();
           }
 
@@ -1222,6 +1317,7 @@ public:
                                              primaryOutput.kind));
       IFT(pResult->QueryInterface(riid, ppResult));
 
+      contextLease.SetReusable();
       hr = S_OK;
     } catch (std::bad_alloc &) {
       hr = E_OUTOFMEMORY;
@@ -1324,6 +1420,55 @@ public:
     return hr;
   }
 
+  // Disassemble a program into a caller-provided stream.
+  HRESULT STDMETHODCALLTYPE DisassembleToStream(
+      _In_ const DxcBuffer *pObject, _In_opt_count_(functionCount)
+                                         LPCWSTR *pFunctionNames,
+      _In_ UINT32 functionCount, _In_ UINT32 threadCount,
+      _In_ IStream *pSink) override {
+    if (pObject == nullptr || pSink == nullptr ||
+        (pFunctionNames == nullptr && functionCount != 0))
+      return E_INVALIDARG;
+
+    HRESULT hr = S_OK;
+    DxcEtw_DXCompilerDisassemble_Start();
+    DxcThreadMalloc TM(m_pMalloc);
+    try {
+      DefaultFPEnvScope fpEnvScope;
+
+      ::llvm::sys::fs::MSFileSystem *msfPtr;
+      IFT(CreateMSFileSystemForDisk(&msfPtr));
+      std::unique_ptr<::llvm::sys::fs::MSFileSystem> msf(msfPtr);
+
+      ::llvm::sys::fs::AutoPerThreadSystem pts(msf.get());
+      IFTLLVM(pts.error_code());
+
+      dxcutil::DisassembleOptions Opts;
+      for (UINT32 i = 0; i < functionCount; ++i)
+        Opts.Functions.push_back(
+            Unicode::WideToUTF8StringOrThrow(pFunctionNames[i]));
+      Opts.NumThreads = threadCount;
+
+      CComPtr<IDxcBlobEncoding> pProgram;
+      IFT(hlsl::DxcCreateBlob(pObject->Ptr, pObject->Size, true, false, false,
+                              0, nullptr, &pProgram))
+      raw_sink_ostream Stream(pSink);
+      hr = dxcutil::Disassemble(pProgram, Stream, Opts);
+      Stream.flush();
+      if (SUCCEEDED(hr))
+        hr = Stream.GetStatus();
+    } catch (std::bad_alloc &) {
+      hr = E_OUTOFMEMORY;
+    } catch (hlsl::Exception &e) {
+      assert(DXC_FAILED(e.hr));
+      hr = e.hr;
+    } catch (...) {
+      hr = E_FAIL;
+    }
+    DxcEtw_DXCompilerDisassemble_Stop(hr);
+    return hr;
+  }
+
   void SetupCompilerForCompile(CompilerInstance &compiler,
                                DxcLangExtensionsHelper *helper,
                                LPCSTR pMainFile,
@@ -1505,6 +1650,9 @@ public:
     if (Opts.PackPrefixStable)
       compiler.getCodeGenOpts().HLSLSignaturePackingStrategy =
           (unsigned)DXIL::PackingStrategy::PrefixStable;
+    else if (Opts.PackMinimalRows)
+      compiler.getCodeGenOpts().HLSLSignaturePackingStrategy =
+          (unsigned)DXIL::PackingStrategy::MinimalRows;
     else if (Opts.PackOptimized)
       compiler.getCodeGenOpts().HLSLSignaturePackingStrategy =
           (unsigned)DXIL::PackingStrategy::Optimized;
@@ -287,6 +287,7 @@ private:
 
   struct Source_File {
     CComPtr<IDxcBlobWide> Name;
+    // Null until requested for sources read from the source info part.
     CComPtr<IDxcBlobEncoding> Content;
   };
 
@@ -294,6 +295,8 @@ private:
   CComPtr<IDxcBlob> m_pDebugProgramBlob;
   CComPtr<IDxcBlob> m_ContainerBlob;
   std::vector<Source_File> m_SourceFiles;
+  // Reads source contents from m_ContainerBlob on demand.
+  std::unique_ptr<hlsl::SourceInfoReader> m_pSourceInfoReader;
 
   CComPtr<IDxcBlobWide> m_EntryPoint;
   CComPtr<IDxcBlobWide> m_TargetProfile;
@@ -344,6 +347,7 @@ private:
     m_uCustomToolchainID = 0;
     m_pDebugProgramBlob = nullptr;
     m_InputBlob = nullptr;
+    m_pSourceInfoReader.reset();
     m_ContainerBlob = nullptr;
     m_SourceFiles.clear();
     m_Name = nullptr;
@@ -703,23 +707,29 @@ private:
       case hlsl::DFCC_ShaderSourceInfo: {
         const hlsl::DxilSourceInfo *header =
             (const hlsl::DxilSourceInfo *)(part + 1);
-        hlsl::SourceInfoReader reader;
-        if (!reader.Init(header, part->PartSize)) {
+        std::unique_ptr<hlsl::SourceInfoReader> reader(
+            new hlsl::SourceInfoReader());
+        if (!reader->Init(header, part->PartSize)) {
           Reset();
           return E_FAIL;
         }
 
         // Args
-        for (unsigned i = 0; i < reader.GetArgPairCount(); i++) {
-          const hlsl::SourceInfoReader::ArgPair &pair = reader.GetArgPair(i);
+        for (unsigned i = 0; i < reader->GetArgPairCount(); i++) {
+          const hlsl::SourceInfoReader::ArgPair &pair = reader->GetArgPair(i);
           IFR(AddArgPair(pair.Name, pair.Value));
         }
 
-        // Sources
-        for (unsigned i = 0; i < reader.GetSourcesCount(); i++) {
-          hlsl::SourceInfoReader::Source source_data = reader.GetSource(i);
-          IFR(AddSource(source_data.Name, source_data.Content));
+        // Sources. Only the names are read now; the contents are read by
+        // GetSource.
+        for (unsigned i = 0; i < reader->GetSourcesCount(); i++) {
+          Source_File source;
+          IFR(Utf8ToBlobWide(reader->GetSourceName(i), &source.Name));
+          if (m_SourceFiles.empty())
+            m_MainFileName = source.Name;
+          m_SourceFiles.push_back(std::move(source));
         }
+        m_pSourceInfoReader = std::move(reader);
 
       } break;
 
@@ -935,7 +945,19 @@ public:
     if (!ppResult)
       return E_POINTER;
     *ppResult = nullptr;
-    return m_SourceFiles[uIndex].Content.QueryInterface(ppResult);
+    Source_File &source = m_SourceFiles[uIndex];
+    if (!source.Content) {
+      DXASSERT_NOMSG(m_pSourceInfoReader);
+      DxcThreadMalloc TM(m_pMalloc);
+      StringRef content;
+      if (!m_pSourceInfoReader->GetSourceContent(uIndex, &content))
+        return E_FAIL;
+      IFR(hlsl::DxcCreateBlob(content.data(), content.size(),
+                              /*bPinned*/ false, /*bCopy*/ true,
+                              /*encodingKnown*/ true, CP_UTF8, m_pMalloc,
+                              &source.Content));
+    }
+    return source.Content.QueryInterface(ppResult);
   }
 
   virtual HRESULT STDMETHODCALLTYPE
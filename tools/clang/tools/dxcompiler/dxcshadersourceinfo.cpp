@@ -221,12 +221,106 @@ bool SourceInfoReader::Init(const hlsl::DxilSourceInfo *SourceInfo,
                      *)((const uint8_t *)entry + entry->AlignedSizeInBytes);
       }
     } break;
+    case hlsl::DxilSourceInfoSectionType::SourceContentBlocks: {
+      const hlsl::DxilSourceInfo_SourceContentBlocks *header =
+          (const hlsl::DxilSourceInfo_SourceContentBlocks *)(section + 1);
+      if (PointerByteOffset(header + 1, section) > sectionSizeInBytes)
+        return false;
+      const uint64_t tableEnd =
+          PointerByteOffset(header + 1, section) +
+          (uint64_t)header->Count *
+              sizeof(hlsl::DxilSourceInfo_SourceContentBlocksEntry) +
+          (uint64_t)header->BlockCount *
+              sizeof(hlsl::DxilSourceInfo_SourceContentBlock);
+      if (tableEnd > sectionSizeInBytes)
+        return false;
+
+      const hlsl::DxilSourceInfo_SourceContentBlocksEntry *firstEntry =
+          (const hlsl::DxilSourceInfo_SourceContentBlocksEntry *)(header + 1);
+      const hlsl::DxilSourceInfo_SourceContentBlock *firstBlock =
+          (const hlsl::DxilSourceInfo_SourceContentBlock *)(firstEntry +
+                                                             header->Count);
+      const uint8_t *blockData = (const uint8_t *)(firstBlock +
+                                                   header->BlockCount);
+      const uint64_t blockDataSize = sectionSizeInBytes - tableEnd;
+
+      m_ContentBlocks.resize(header->BlockCount);
+      for (unsigned i = 0; i < header->BlockCount; i++) {
+        const hlsl::DxilSourceInfo_SourceContentBlock *block = firstBlock + i;
+        if ((uint64_t)block->Offset + block->SizeInBytes > blockDataSize)
+          return false;
+        if (block->CompressType ==
+            hlsl::DxilSourceInfo_SourceContentsCompressType::None) {
+          if (block->SizeInBytes != block->UncompressedSizeInBytes)
+            return false;
+        } else if (block->CompressType !=
+                   hlsl::DxilSourceInfo_SourceContentsCompressType::Zlib) {
+          return false;
+        }
+        m_ContentBlocks[i].Header = block;
+        m_ContentBlocks[i].Data = blockData + block->Offset;
+        m_ContentBlocks[i].Loaded = false;
+      }
+
+      assert(m_Sources.size() == 0 || m_Sources.size() == header->Count);
+      m_Sources.resize(header->Count);
+
+      m_ContentEntries.resize(header->Count);
+      for (unsigned i = 0; i < header->Count; i++) {
+        const hlsl::DxilSourceInfo_SourceContentBlocksEntry *entry =
+            firstEntry + i;
+        if (entry->Block >= header->BlockCount ||
+            entry->ContentSizeInBytes == 0)
+          return false;
+        if ((uint64_t)entry->Offset + entry->ContentSizeInBytes >
+            firstBlock[entry->Block].UncompressedSizeInBytes)
+          return false;
+        m_ContentEntries[i] = entry;
+      }
+    } break;
     }
     section =
         (const hlsl::DxilSourceInfoSection *)((const uint8_t *)section +
                                               section->AlignedSizeInBytes);
   }
 
+  if (!m_ContentEntries.empty() && m_ContentEntries.size() != m_Sources.size())
+    return false;
+
+  return true;
+}
+
+bool SourceInfoReader::GetSourceContent(unsigned i,
+                                        llvm::StringRef *pContent) {
+  if (i >= m_ContentEntries.size() || m_Sources[i].Content.data()) {
+    *pContent = m_Sources[i].Content;
+    return true;
+  }
+
+  const hlsl::DxilSourceInfo_SourceContentBlocksEntry *entry =
+      m_ContentEntries[i];
+  ContentBlock &block = m_ContentBlocks[entry->Block];
+  const uint8_t *blockData = block.Data;
+  if (block.Header->CompressType ==
+      hlsl::DxilSourceInfo_SourceContentsCompressType::Zlib) {
+    if (!block.Loaded) {
+      block.Uncompressed.resize(block.Header->UncompressedSizeInBytes);
+      if (hlsl::ZlibResult::Success !=
+          ZlibDecompress(DxcGetThreadMallocNoRef(), block.Data,
+                         block.Header->SizeInBytes, block.Uncompressed.data(),
+                         block.Uncompressed.size()))
+        return false;
+      block.Loaded = true;
+    }
+    blockData = block.Uncompressed.data();
+  }
+
+  const char *ptr = (const char *)blockData + entry->Offset;
+  // Fail if not null terminated
+  if (ptr[entry->ContentSizeInBytes - 1] != '\0')
+    return false;
+  m_Sources[i].Content = {ptr, entry->ContentSizeInBytes - 1};
+  *pContent = m_Sources[i].Content;
   return true;
 }
 
@@ -273,6 +367,10 @@ static void AppendFileContentEntry(Buffer *buf, llvm::StringRef content) {
   assert(paddedOffset == header.AlignedSizeInBytes);
 }
 
+// Uncompressed size that source content blocks are filled up to. A source
+// larger than this gets a block of its own.
+static const size_t kSourceContentBlockSize = 64 * 1024;
+
 static size_t BeginSection(Buffer *buf) {
   const size_t sectionOffset = buf->size();
 
@@ -344,7 +442,7 @@ static std::vector<SourceFile> ComputeFileList(clang::CodeGenOptions &cgOpts,
 void SourceInfoWriter::Write(llvm::StringRef targetProfile,
                              llvm::StringRef entryPoint,
                              clang::CodeGenOptions &cgOpts,
-                             clang::SourceManager &srcMgr) {
+                             clang::SourceManager &srcMgr, bool sourceBlocks) {
   m_Buffer.clear();
 
   // Write an empty header first.
@@ -398,9 +496,78 @@ void SourceInfoWriter::Write(llvm::StringRef targetProfile,
   }
 
   ////////////////////////////////////////////////////////////////////
-  // Add all file contents in a list.
+  // Add all file contents, either in independently compressed blocks
+  // (readers older than the SourceContentBlocks section see no contents),
+  // or in a single list.
   ////////////////////////////////////////////////////////////////////
-  {
+  if (sourceBlocks) {
+    const size_t sectionOffset = BeginSection(&m_Buffer);
+
+    // Group the contents into blocks.
+    std::vector<hlsl::DxilSourceInfo_SourceContentBlocksEntry> entries;
+    std::vector<Buffer> blocks;
+    for (unsigned i = 0; i < sourceFileList.size(); i++) {
+      SourceFile &file = sourceFileList[i];
+      const size_t contentSize = file.Content.size() + 1;
+      if (blocks.empty() ||
+          (!blocks.back().empty() &&
+           blocks.back().size() + contentSize > kSourceContentBlockSize))
+        blocks.emplace_back();
+
+      hlsl::DxilSourceInfo_SourceContentBlocksEntry entry = {};
+      entry.Block = blocks.size() - 1;
+      entry.Offset = blocks.back().size();
+      entry.ContentSizeInBytes = contentSize;
+      entries.push_back(entry);
+
+      Append(&blocks.back(), file.Content.data(), file.Content.size());
+      Append(&blocks.back(), 0); // Null term
+    }
+
+    // Write the header and the entries, and leave room for the block table.
+    hlsl::DxilSourceInfo_SourceContentBlocks header = {};
+    header.Count = entries.size();
+    header.BlockCount = blocks.size();
+    Append(&m_Buffer, &header, sizeof(header));
+    if (!entries.empty())
+      Append(&m_Buffer, entries.data(), entries.size() * sizeof(entries[0]));
+    const size_t blockTableOffset = m_Buffer.size();
+    std::vector<hlsl::DxilSourceInfo_SourceContentBlock> blockTable(
+        blocks.size());
+    if (!blockTable.empty())
+      Append(&m_Buffer, blockTable.data(),
+             blockTable.size() * sizeof(blockTable[0]));
+
+    // Write each block, compressed unless that doesn't make it smaller.
+    const size_t blockDataOffset = m_Buffer.size();
+    for (unsigned i = 0; i < blocks.size(); i++) {
+      const Buffer &block = blocks[i];
+      const size_t sizeBeforeCompress = m_Buffer.size();
+      hlsl::DxilSourceInfo_SourceContentBlock &blockHeader = blockTable[i];
+      blockHeader.Offset = sizeBeforeCompress - blockDataOffset;
+      blockHeader.UncompressedSizeInBytes = block.size();
+      blockHeader.CompressType =
+          hlsl::DxilSourceInfo_SourceContentsCompressType::Zlib;
+      bool bCompressed =
+          hlsl::ZlibResult::Success ==
+          ZlibCompressAppend(DxcGetThreadMallocNoRef(), block.data(),
+                             block.size(), m_Buffer);
+      if (!bCompressed || m_Buffer.size() - sizeBeforeCompress >= block.size()) {
+        m_Buffer.resize(sizeBeforeCompress);
+        Append(&m_Buffer, block.data(), block.size());
+        blockHeader.CompressType =
+            hlsl::DxilSourceInfo_SourceContentsCompressType::None;
+      }
+      blockHeader.SizeInBytes = m_Buffer.size() - sizeBeforeCompress;
+    }
+    if (!blockTable.empty())
+      memcpy(m_Buffer.data() + blockTableOffset, blockTable.data(),
+             blockTable.size() * sizeof(blockTable[0]));
+
+    FinishSection(&m_Buffer, sectionOffset,
+                  hlsl::DxilSourceInfoSectionType::SourceContentBlocks);
+    mainHeader.SectionCount++;
+  } else {
     const size_t sectionOffset = BeginSection(&m_Buffer);
 
     // Put all the contents in a buffer
@@ -37,11 +37,26 @@ struct SourceInfoReader {
     std::string Value;
   };
 
+  // A block of source contents, decompressed on first use.
+  struct ContentBlock {
+    const hlsl::DxilSourceInfo_SourceContentBlock *Header;
+    const uint8_t *Data;
+    Buffer Uncompressed;
+    bool Loaded;
+  };
+
   std::vector<Source> m_Sources;
   std::vector<ArgPair> m_ArgPairs;
+  // Set for the block format; contents are filled in by GetSourceContent.
+  std::vector<const hlsl::DxilSourceInfo_SourceContentBlocksEntry *>
+      m_ContentEntries;
+  std::vector<ContentBlock> m_ContentBlocks;
 
-  Source GetSource(unsigned i) const { return m_Sources[i]; }
+  llvm::StringRef GetSourceName(unsigned i) const { return m_Sources[i].Name; }
   unsigned GetSourcesCount() const { return m_Sources.size(); }
+  // Only the block holding the requested source is decompressed. Returns
+  // false if the block is corrupt.
+  bool GetSourceContent(unsigned i, llvm::StringRef *pContent);
 
   const ArgPair &GetArgPair(unsigned i) const { return m_ArgPairs[i]; }
   unsigned GetArgPairCount() const { return m_ArgPairs.size(); }
@@ -57,7 +72,8 @@ struct SourceInfoWriter {
 
   const hlsl::DxilSourceInfo *GetPart() const;
   void Write(llvm::StringRef targetProfile, llvm::StringRef entryPoint,
-             clang::CodeGenOptions &cgOpts, clang::SourceManager &srcMgr);
+             clang::CodeGenOptions &cgOpts, clang::SourceManager &srcMgr,
+             bool sourceBlocks);
 };
 
 } // namespace hlsl
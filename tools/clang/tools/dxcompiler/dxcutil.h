@@ -19,6 +19,8 @@
 #include "llvm/ADT/StringRef.h"
 
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace clang {
 class DiagnosticsEngine;
@@ -28,7 +30,7 @@ namespace llvm {
 class LLVMContext;
 class MemoryBuffer;
 class Module;
-class raw_string_ostream;
+class raw_ostream;
 class Twine;
 } // namespace llvm
 
@@ -82,7 +84,17 @@ void GetValidatorVersion(unsigned *pMajor, unsigned *pMinor,
                          hlsl::options::ValidatorSelection SelectValidator =
                              hlsl::options::ValidatorSelection::Auto);
 void AssembleToContainer(AssembleInputs &inputs);
-HRESULT Disassemble(IDxcBlob *pProgram, llvm::raw_string_ostream &Stream);
+struct DisassembleOptions {
+  // Only the bodies of these functions, given by name or unmangled name, are
+  // printed; every function is printed when empty.
+  std::vector<std::string> Functions;
+  // Number of threads printing function bodies; 0 uses one per hardware
+  // thread. The output is the same for any number of threads.
+  unsigned NumThreads = 1;
+};
+// Writes the disassembly to Stream as it is produced.
+HRESULT Disassemble(IDxcBlob *pProgram, llvm::raw_ostream &Stream,
+                    const DisassembleOptions &Opts = DisassembleOptions());
 void ReadOptsAndValidate(hlsl::options::MainArgs &mainArgs,
                          hlsl::options::DxcOpts &opts,
                          hlsl::AbstractMemoryStream *pOutputStream,
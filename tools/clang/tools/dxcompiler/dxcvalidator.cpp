@@ -351,19 +351,17 @@ DxcValidator::RunRootSignatureValidation(IDxcBlob *pShader,
     IFRBOOL(pPSVPart, DXC_E_MISSING_PART);
   }
   try {
-    RootSignatureHandle RSH;
-    RSH.LoadSerialized((const uint8_t *)GetDxilPartData(pRSPart),
-                       pRSPart->PartSize);
-    RSH.Deserialize();
     raw_stream_ostream DiagStream(pDiagStream);
     if (pProgramHeader) {
-      IFRBOOL(VerifyRootSignatureWithShaderPSV(
-                  RSH.GetDesc(),
+      IFRBOOL(VerifySerializedRootSignatureWithShaderPSV(
+                  GetDxilPartData(pRSPart), pRSPart->PartSize,
                   GetVersionShaderType(pProgramHeader->ProgramVersion),
                   GetDxilPartData(pPSVPart), pPSVPart->PartSize, DiagStream),
               DXC_E_INCORRECT_ROOT_SIGNATURE);
     } else {
-      IFRBOOL(VerifyRootSignature(RSH.GetDesc(), DiagStream, false),
+      IFRBOOL(VerifySerializedRootSignature(GetDxilPartData(pRSPart),
+                                            pRSPart->PartSize, DiagStream,
+                                            false),
               DXC_E_INCORRECT_ROOT_SIGNATURE);
     }
   } catch (...) {
@@ -25,9 +25,16 @@
 #include "dxc/dxcapi.internal.h"
 #include "dxc/dxctools.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <limits>
+#include <map>
+#include <thread>
 
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/FileSystem.h"
 
 inline bool wcseq(LPCWSTR a, LPCWSTR b) {
@@ -50,6 +57,7 @@ enum class ProgramAction {
   PrintPasses,
   PrintPassesWithDetails,
   RunOptimizer,
+  RunCorpus,
 };
 
 const wchar_t *STDIN_FILE_NAME = L"-";
@@ -205,19 +213,214 @@ static void ReadFileOpts(LPCWSTR pPassFileName, IDxcBlobEncoding **ppPassOpts,
   pPassOpts->QueryInterface(ppPassOpts);
 }
 
+// A module listed in a -corpus file, and what running the pipeline on it
+// produced.
+struct CorpusEntry {
+  std::wstring FileName;
+  std::string Error;
+  uint64_t InstructionsIn = 0;
+  uint64_t InstructionsOut = 0;
+  double Milliseconds = 0;
+  std::vector<std::pair<std::string, double>> PassSeconds;
+};
+
+// Reads the file names listed in a -corpus file, one per line. Empty lines and
+// lines starting with '#' are ignored.
+static void ReadCorpusList(LPCWSTR pListFileName,
+                           std::vector<CorpusEntry> &entries) {
+  CComPtr<IDxcBlob> pListBlob;
+  CComPtr<IDxcBlobWide> pList;
+  BlobFromFile(pListFileName, &pListBlob);
+  IFT(hlsl::DxcGetBlobAsWide(pListBlob, hlsl::GetGlobalHeapMalloc(), &pList));
+  LPCWSTR pCursor = pList->GetStringPointer();
+  while (*pCursor) {
+    LPCWSTR pLineStart = pCursor;
+    while (*pCursor && *pCursor != L'\n' && *pCursor != L'\r')
+      ++pCursor;
+    std::wstring line(pLineStart, pCursor);
+    while (*pCursor == L'\n' || *pCursor == L'\r')
+      ++pCursor;
+    if (line.empty() || line[0] == L'#')
+      continue;
+    entries.emplace_back();
+    entries.back().FileName = std::move(line);
+  }
+}
+
+// Reads the 'OPT-STATS:' lines that -opt-stats adds to the optimizer output.
+static void ReadOptStats(IDxcBlobEncoding *pOutputText, CorpusEntry &entry) {
+  llvm::StringRef text((const char *)pOutputText->GetBufferPointer(),
+                       pOutputText->GetBufferSize());
+  llvm::SmallVector<llvm::StringRef, 32> lines;
+  text.split(lines, "\n", -1, false);
+  for (llvm::StringRef line : lines) {
+    if (!line.startswith("OPT-STATS: "))
+      continue;
+    line = line.drop_front(strlen("OPT-STATS: ")).rtrim();
+    if (line.startswith("instructions ")) {
+      std::pair<llvm::StringRef, llvm::StringRef> counts =
+          line.drop_front(strlen("instructions ")).split(' ');
+      counts.first.getAsInteger(10, entry.InstructionsIn);
+      counts.second.getAsInteger(10, entry.InstructionsOut);
+    } else if (line.startswith("pass ")) {
+      // Passes without an argument go by their names, which contain spaces.
+      std::pair<llvm::StringRef, llvm::StringRef> pass =
+          line.drop_front(strlen("pass ")).rsplit(' ');
+      entry.PassSeconds.emplace_back(pass.first.str(),
+                                     strtod(pass.second.str().c_str(), nullptr));
+    }
+  }
+}
+
+static void RunCorpusEntry(IDxcOptimizer *pOptimizer,
+                           const std::vector<LPCWSTR> &optArgs,
+                           CorpusEntry &entry) {
+  try {
+    CComPtr<IDxcBlob> pBlob;
+    CComPtr<IDxcBlob> pOutputModule;
+    CComPtr<IDxcBlobEncoding> pOutputText;
+    BlobFromFile(entry.FileName.c_str(), &pBlob);
+    auto start = std::chrono::steady_clock::now();
+    HRESULT hr = pOptimizer->RunOptimizer(
+        pBlob, const_cast<LPCWSTR *>(optArgs.data()), (UINT32)optArgs.size(),
+        &pOutputModule, &pOutputText);
+    entry.Milliseconds = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+    IFT(hr);
+    ReadOptStats(pOutputText, entry);
+    return;
+  } catch (const ::hlsl::Exception &hlslException) {
+    const char *msg = hlslException.what();
+    if (msg != nullptr && *msg != '\0') {
+      entry.Error = msg;
+    } else {
+      char printBuffer[64];
+      sprintf_s(printBuffer, _countof(printBuffer), "error code 0x%08x",
+                hlslException.hr);
+      entry.Error = printBuffer;
+    }
+  } catch (std::bad_alloc &) {
+    entry.Error = "out of memory";
+  } catch (...) {
+    entry.Error = "unknown error";
+  }
+}
+
+// Runs the pass pipeline over every module listed in the corpus file on a pool
+// of threads, then reports instruction counts and times for each module, and
+// in aggregate. With printModulePasses, each module's pass times are listed
+// under it as well. Returns non-zero if the pipeline failed on any module.
+static int RunCorpus(LPCWSTR pListFileName, unsigned numJobs,
+                     bool printModulePasses, const wchar_t **optArgs,
+                     UINT32 optArgCount) {
+  std::vector<CorpusEntry> entries;
+  ReadCorpusList(pListFileName, entries);
+
+  std::vector<LPCWSTR> args(optArgs, optArgs + optArgCount);
+  args.push_back(L"-opt-stats");
+
+  if (numJobs == 0)
+    numJobs = std::max(1u, std::thread::hardware_concurrency());
+  numJobs = (unsigned)std::max<size_t>(
+      1, std::min<size_t>(numJobs, entries.size()));
+
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<size_t> nextEntry(0);
+  auto worker = [&]() {
+    // Each thread uses its own optimizer; work is handed out one module at a
+    // time, as run times vary widely between modules.
+    CComPtr<IDxcOptimizer> pOptimizer;
+    HRESULT hr = g_DxcSupport.CreateInstance(CLSID_DxcOptimizer, &pOptimizer);
+    for (size_t i = nextEntry++; i < entries.size(); i = nextEntry++) {
+      if (FAILED(hr)) {
+        entries[i].Error = "unable to create the optimizer";
+        continue;
+      }
+      RunCorpusEntry(pOptimizer, args, entries[i]);
+    }
+  };
+  std::vector<std::thread> threads;
+  threads.reserve(numJobs);
+  for (unsigned i = 0; i < numJobs; ++i)
+    threads.emplace_back(worker);
+  for (std::thread &t : threads)
+    t.join();
+  double wallMilliseconds = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+
+  unsigned failures = 0;
+  uint64_t instructionsIn = 0, instructionsOut = 0;
+  double optimizerMilliseconds = 0, passSeconds = 0;
+  std::map<std::string, double> passTotals;
+  for (const CorpusEntry &entry : entries) {
+    CW2A fileName(entry.FileName.c_str(), CP_UTF8);
+    if (!entry.Error.empty()) {
+      ++failures;
+      printf("%s: failed - %s\n", fileName.m_psz, entry.Error.c_str());
+      continue;
+    }
+    printf("%s: %llu -> %llu instructions, %.3f ms\n", fileName.m_psz,
+           (unsigned long long)entry.InstructionsIn,
+           (unsigned long long)entry.InstructionsOut, entry.Milliseconds);
+    if (printModulePasses) {
+      for (const auto &pass : entry.PassSeconds)
+        printf("    %10.3f ms  %s\n", pass.second * 1000, pass.first.c_str());
+    }
+    instructionsIn += entry.InstructionsIn;
+    instructionsOut += entry.InstructionsOut;
+    optimizerMilliseconds += entry.Milliseconds;
+    for (const auto &pass : entry.PassSeconds) {
+      passTotals[pass.first] += pass.second;
+      passSeconds += pass.second;
+    }
+  }
+
+  printf("%u modules, %u failed, %u threads, %.3f ms\n",
+         (unsigned)entries.size(), failures, numJobs, wallMilliseconds);
+  printf("instructions: %llu -> %llu\n", (unsigned long long)instructionsIn,
+         (unsigned long long)instructionsOut);
+  printf("optimizer: %.3f ms\n", optimizerMilliseconds);
+
+  std::vector<std::pair<std::string, double>> passes(passTotals.begin(),
+                                                     passTotals.end());
+  std::stable_sort(passes.begin(), passes.end(),
+                   [](const std::pair<std::string, double> &a,
+                      const std::pair<std::string, double> &b) {
+                     return a.second > b.second;
+                   });
+  for (const auto &pass : passes)
+    printf("  %10.3f ms %5.1f%%  %s\n", pass.second * 1000,
+           passSeconds > 0 ? pass.second * 100 / passSeconds : 0.0,
+           pass.first.c_str());
+
+  return failures ? 1 : 0;
+}
+
 static void PrintHelp() {
   wprintf(
       L"%s",
       L"Performs optimizations on a bitcode file by running a sequence of "
       L"passes.\n\n"
       L"dxopt [-? | -passes | -pass-details | -pf [PASS-FILE] | [-o=OUT-FILE] "
-      L"| IN-FILE OPT-ARGUMENTS ...]\n\n"
+      L"| IN-FILE OPT-ARGUMENTS ...]\n"
+      L"dxopt -corpus LIST-FILE [-j COUNT] [-module-pass-times] "
+      L"[-pf PASS-FILE | OPT-ARGUMENTS ...]\n\n"
       L"Arguments:\n"
       L"  -?  Displays this help message\n"
       L"  -passes        Displays a list of pass names\n"
       L"  -pass-details  Displays a list of passes with detailed information\n"
       L"  -pf PASS-FILE  Loads passes from the specified file\n"
       L"  -o=OUT-FILE    Output file for processed module\n"
+      L"  -corpus LIST-FILE  Runs the passes on each module listed in the "
+      L"file, one\n"
+      L"                 per line, and reports instruction counts and pass "
+      L"times\n"
+      L"  -j COUNT       Number of threads for -corpus (default: hardware "
+      L"threads)\n"
+      L"  -module-pass-times  Lists each module's pass times under it in "
+      L"-corpus output\n"
       L"  IN-FILE        File with with bitcode to optimize\n"
       L"  OPT-ARGUMENTS  One or more passes to run in sequence\n"
       L"\n"
@@ -248,6 +451,9 @@ int main(int argc, const char **argv) {
     LPCWSTR externalLib = nullptr;
     LPCWSTR externalFn = nullptr;
     LPCWSTR passFileName = nullptr;
+    LPCWSTR corpusFileName = nullptr;
+    unsigned numJobs = 0;
+    bool printModulePasses = false;
     const wchar_t **optArgs = nullptr;
     UINT32 optArgCount = 0;
 
@@ -281,8 +487,30 @@ int main(int argc, const char **argv) {
           return 1;
         }
         passFileName = argv_[argIdx];
+      } else if (wcsieqopt(arg, L"corpus")) {
+        ++argIdx;
+        if (argIdx == argc) {
+          PrintHelp();
+          return 1;
+        }
+        corpusFileName = argv_[argIdx];
+        action = ProgramAction::RunCorpus;
+      } else if (wcsieqopt(arg, L"j")) {
+        ++argIdx;
+        if (argIdx == argc) {
+          PrintHelp();
+          return 1;
+        }
+        numJobs = wcstoul(argv_[argIdx], nullptr, 10);
+      } else if (wcsieqopt(arg, L"module-pass-times")) {
+        printModulePasses = true;
       } else if (wcsistarts(arg, L"-o=")) {
         outFileName = argv_[argIdx] + 3;
+      } else if (corpusFileName) {
+        // The remaining arguments are optimizer args for every module.
+        optArgs = argv_ + argIdx;
+        optArgCount = argc - argIdx;
+        break;
       } else {
         action = ProgramAction::RunOptimizer;
         // See if arg is file input specifier.
@@ -346,6 +574,12 @@ int main(int argc, const char **argv) {
                                    &pOutputText));
       PrintOptOutput(outFileName, pOutputModule, pOutputText);
       break;
+    case ProgramAction::RunCorpus:
+      pStage = "Corpus processing";
+      ReadFileOpts(passFileName, &pPassOpts, passes, &optArgs, &optArgCount);
+      retVal = RunCorpus(corpusFileName, numJobs, printModulePasses, optArgs,
+                         optArgCount);
+      break;
     }
   } catch (const ::hlsl::Exception &hlslException) {
     try {
@@ -250,13 +250,9 @@ DxcValidator::RunRootSignatureValidation(IDxcBlob *pShader,
       GetDxilPartByType(pDxilContainer, DFCC_RootSignature);
   IFRBOOL(pPSVPart && pRSPart, DXC_E_MISSING_PART);
   try {
-    RootSignatureHandle RSH;
-    RSH.LoadSerialized((const uint8_t *)GetDxilPartData(pRSPart),
-                       pRSPart->PartSize);
-    RSH.Deserialize();
     raw_stream_ostream DiagStream(pDiagStream);
-    IFRBOOL(VerifyRootSignatureWithShaderPSV(
-                RSH.GetDesc(),
+    IFRBOOL(VerifySerializedRootSignatureWithShaderPSV(
+                GetDxilPartData(pRSPart), pRSPart->PartSize,
                 GetVersionShaderType(pProgramHeader->ProgramVersion),
                 GetDxilPartData(pPSVPart), pPSVPart->PartSize, DiagStream),
             DXC_E_INCORRECT_ROOT_SIGNATURE);
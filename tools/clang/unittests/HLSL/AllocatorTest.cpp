@@ -13,6 +13,7 @@
 
 #include "dxc/HLSL/DxilSpanAllocator.h"
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <iterator>
 #include <map>
@@ -559,6 +560,7 @@ public:
   TEST_METHOD(Intersections)
   TEST_METHOD(GapFilling)
   TEST_METHOD(Allocate)
+  TEST_METHOD(ManySpans)
 
   void InitScenarios() {
     struct P {
@@ -791,3 +793,68 @@ TEST_F(AllocatorTest, Allocate) {
     TestSizesFn();
   }
 }
+
+// Insert and allocate around many small resources, as with large descriptor
+// tables, checking results and logging the time taken for each step.
+TEST_F(AllocatorTest, ManySpans) {
+  WEX::TestExecution::SetVerifyOutput verifySettings(
+      WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures);
+  typedef std::chrono::steady_clock Clock;
+  auto LogTime = [](const wchar_t *step, unsigned count,
+                    Clock::time_point start) {
+    auto dur = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - start);
+    LogCommentFmt(L"%s,%u,%u", step, count, (unsigned)dur.count());
+  };
+
+  static const unsigned counts[] = {10000, 100000};
+  for (unsigned count : counts) {
+    // Spans of size 2 with a gap of size 2 after each one.
+    ElementVector elements;
+    elements.reserve(count);
+    for (unsigned i = 0; i < count; ++i)
+      elements.emplace_back(i, i * 4, i * 4 + 1);
+    std::vector<const Element *> shuffled;
+    for (auto &e : elements)
+      shuffled.push_back(&e);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(count));
+
+    Allocator alloc(0, count * 4 - 1);
+    auto start = Clock::now();
+    for (const Element *e : shuffled)
+      VERIFY_IS_NULL(alloc.Insert(e, e->start, e->end));
+    LogTime(L"Insert", count, start);
+
+    unsigned index = 0;
+    for (auto &span : alloc.GetSpans()) {
+      VERIFY_ARE_EQUAL(span.element, &elements[index]);
+      ++index;
+    }
+    VERIFY_ARE_EQUAL(index, count);
+
+    start = Clock::now();
+    for (const Element *e : shuffled) {
+      Element probe(UINT_MAX, e->end, e->end + 2);
+      VERIFY_ARE_EQUAL(alloc.Insert(&probe, probe.start, probe.end), e);
+    }
+    LogTime(L"Conflict", count, start);
+
+    // No gap fits size 3, so every span has to be considered.
+    start = Clock::now();
+    Element tooLarge(UINT_MAX, 0, 0);
+    unsigned pos = 0;
+    VERIFY_IS_FALSE(alloc.Allocate(&tooLarge, 3, pos));
+    pos = 0;
+    VERIFY_IS_FALSE(alloc.Find(3, pos));
+    LogTime(L"FindTooLarge", count, start);
+
+    ElementVector filler(count, Element(UINT_MAX, 0, 0));
+    start = Clock::now();
+    for (unsigned i = 0; i < count; ++i) {
+      VERIFY_IS_TRUE(alloc.Allocate(&filler[i], 2, pos));
+      VERIFY_ARE_EQUAL(pos, i * 4 + 2);
+    }
+    LogTime(L"Allocate", count, start);
+    VERIFY_IS_TRUE(alloc.IsFull());
+  }
+}
@@ -140,12 +140,15 @@ public:
   TEST_METHOD(CompileWhenEmptyThenFails)
   TEST_METHOD(CompileWhenIncorrectThenFails)
   TEST_METHOD(CompileWhenWorksThenDisassembleWorks)
+  TEST_METHOD(CompileWhenReuseLLVMContextThenOutputsMatch)
   TEST_METHOD(CompileWhenDebugWorksThenStripDebug)
   TEST_METHOD(CompileWhenWorksThenAddRemovePrivate)
   TEST_METHOD(CompileThenAddCustomDebugName)
   TEST_METHOD(CompileThenTestReflectionWithProgramHeader)
   TEST_METHOD(CompileThenTestPdbUtils)
   TEST_METHOD(CompileThenTestPdbUtilsWarningOpt)
+  TEST_METHOD(CompileThenTestPdbUtilsSourceBlocks)
+  TEST_METHOD(TestPdbUtilsOldSourceContents)
   TEST_METHOD(CompileThenTestPdbInPrivate)
   TEST_METHOD(CompileThenTestPdbUtilsStripped)
   TEST_METHOD(CompileThenTestPdbUtilsEmptyEntry)
@@ -898,6 +901,61 @@ TEST_F(CompilerTest, CompileWhenWorksThenDisassembleWorks) {
   // WEX::Logging::Log::Comment(disassembleStringW.m_psz);
 }
 
+TEST_F(CompilerTest, CompileWhenReuseLLVMContextThenOutputsMatch) {
+  // Both shaders declare a struct named S and a cbuffer, so state leaking
+  // from one compile into the next would show up as renamed types or
+  // metadata in the disassembly.
+  const char *sources[] = {
+      "struct S { float4 a; int b; };\r\n"
+      "cbuffer C { S s; };\r\n"
+      "float4 main() : SV_Target { return s.a * s.b; }",
+      "struct S { float2 a; };\r\n"
+      "struct T { S x; float y; };\r\n"
+      "cbuffer C { T t; };\r\n"
+      "float4 main(float4 pos : SV_Position) : SV_Target {\r\n"
+      "  [loop] for (int i = 0; i < 4; ++i) pos.x += t.x.a.y;\r\n"
+      "  return pos * t.y;\r\n"
+      "}"};
+
+  auto compileAndDisassemble = [&](IDxcCompiler *pCompiler, const char *text,
+                                   LPCWSTR *args,
+                                   UINT32 argCount) -> std::string {
+    CComPtr<IDxcBlobEncoding> pSource;
+    CComPtr<IDxcOperationResult> pResult;
+    CreateBlobFromText(text, &pSource);
+    VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                        L"ps_6_0", args, argCount, nullptr, 0,
+                                        nullptr, &pResult));
+    HRESULT result;
+    VERIFY_SUCCEEDED(pResult->GetStatus(&result));
+    VERIFY_SUCCEEDED(result);
+    CComPtr<IDxcBlob> pProgram;
+    VERIFY_SUCCEEDED(pResult->GetResult(&pProgram));
+    CComPtr<IDxcBlobEncoding> pDisassembleBlob;
+    VERIFY_SUCCEEDED(pCompiler->Disassemble(pProgram, &pDisassembleBlob));
+    return BlobToUtf8(pDisassembleBlob);
+  };
+
+  std::string expected[_countof(sources)];
+  for (unsigned i = 0; i < _countof(sources); ++i) {
+    CComPtr<IDxcCompiler> pCompiler;
+    VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+    expected[i] = compileAndDisassemble(pCompiler, sources[i], nullptr, 0);
+  }
+
+  // Alternate between the shaders on one compiler object, long enough for
+  // pooled contexts to be recycled at least once.
+  CComPtr<IDxcCompiler> pCompiler;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+  LPCWSTR args[] = {L"-Qreuse_llvm_context"};
+  for (unsigned i = 0; i < 150; ++i) {
+    unsigned index = i % _countof(sources);
+    std::string actual = compileAndDisassemble(pCompiler, sources[index], args,
+                                               _countof(args));
+    VERIFY_ARE_EQUAL_STR(expected[index].c_str(), actual.c_str());
+  }
+}
+
 TEST_F(CompilerTest, CompileWhenDebugWorksThenStripDebug) {
   CComPtr<IDxcCompiler> pCompiler;
   CComPtr<IDxcOperationResult> pResult;
@@ -1852,6 +1910,193 @@ TEST_F(CompilerTest, CompileThenTestPdbUtils) {
                                   // its own part, and debug module is present
 }
 
+TEST_F(CompilerTest, CompileThenTestPdbUtilsSourceBlocks) {
+  if (m_ver.SkipDxilVersion(1, 5))
+    return;
+  CComPtr<IDxcCompiler> pCompiler;
+  VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
+
+  std::string main_source = R"x(
+      #include "a.h"
+      #include "big.h"
+      #include "b.h"
+      float4 main() : SV_Target { return A + BIG + B; }
+  )x";
+  std::string a_file = "#define A 1";
+  std::string b_file = "#define B 2";
+  // Large enough to need several source content blocks of its own.
+  std::string big_file = "#define BIG 3\n";
+  while (big_file.size() < 200 * 1024)
+    big_file += "// Padding to make this header larger than a block.\n";
+
+  CComPtr<IDxcBlobEncoding> pSource;
+  CreateBlobFromText(main_source.c_str(), &pSource);
+  CComPtr<TestIncludeHandler> pInclude = new TestIncludeHandler(m_dllSupport);
+  pInclude->CallResults.emplace_back(a_file.c_str());
+  pInclude->CallResults.emplace_back(big_file.c_str());
+  pInclude->CallResults.emplace_back(b_file.c_str());
+
+  const WCHAR *args[] = {L"-Zs", L"-Qstrip_debug", L"-Qpdb_source_blocks"};
+  CComPtr<IDxcOperationResult> pOperationResult;
+  VERIFY_SUCCEEDED(pCompiler->Compile(pSource, L"source.hlsl", L"main",
+                                      L"ps_6_0", args, _countof(args), nullptr,
+                                      0, pInclude, &pOperationResult));
+  HRESULT CompileStatus = S_OK;
+  VERIFY_SUCCEEDED(pOperationResult->GetStatus(&CompileStatus));
+  VERIFY_SUCCEEDED(CompileStatus);
+
+  CComPtr<IDxcResult> pResult;
+  VERIFY_SUCCEEDED(pOperationResult.QueryInterface(&pResult));
+  CComPtr<IDxcBlob> pPdbBlob;
+  VERIFY_SUCCEEDED(
+      pResult->GetOutput(DXC_OUT_PDB, IID_PPV_ARGS(&pPdbBlob), nullptr));
+
+  CComPtr<IDxcPdbUtils2> pPdbUtils;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcPdbUtils, &pPdbUtils));
+  VERIFY_SUCCEEDED(pPdbUtils->Load(pPdbBlob));
+
+  UINT32 uSourceCount = 0;
+  VERIFY_SUCCEEDED(pPdbUtils->GetSourceCount(&uSourceCount));
+  VERIFY_ARE_EQUAL(uSourceCount, 4u);
+
+  // Read the sources in reverse order, so each block is first decompressed
+  // for a source other than its first one.
+  std::multiset<std::string> contents;
+  for (UINT32 i = uSourceCount; i-- > 0;) {
+    CComPtr<IDxcBlobEncoding> pFileContent;
+    VERIFY_SUCCEEDED(pPdbUtils->GetSource(i, &pFileContent));
+    CComPtr<IDxcBlobUtf8> pFileContentUtf8;
+    VERIFY_SUCCEEDED(pFileContent.QueryInterface(&pFileContentUtf8));
+    contents.insert(std::string(pFileContentUtf8->GetStringPointer(),
+                                pFileContentUtf8->GetStringLength()));
+  }
+  std::multiset<std::string> expected = {main_source, a_file, big_file,
+                                         b_file};
+  VERIFY_IS_TRUE(contents == expected);
+}
+
+// Source info parts written before SourceContentBlocks keep every source in a
+// single SourceContents section. Build one by hand, so that the reader is
+// tested against the old layout and not against the current writer.
+TEST_F(CompilerTest, TestPdbUtilsOldSourceContents) {
+  std::vector<std::pair<std::string, std::string>> sources = {
+      {"source.hlsl", "#include \"a.h\"\nfloat4 main() : SV_Target { "
+                      "return A; }\n"},
+      {"a.h", "#define A 1\n"},
+  };
+
+  auto append = [](std::vector<uint8_t> &buf, const void *ptr, size_t size) {
+    buf.insert(buf.end(), (const uint8_t *)ptr, (const uint8_t *)ptr + size);
+  };
+  auto appendString = [](std::vector<uint8_t> &buf, const std::string &str) {
+    buf.insert(buf.end(), str.begin(), str.end());
+    buf.push_back(0);
+    while (buf.size() % 4)
+      buf.push_back(0);
+  };
+  auto appendSection = [&](std::vector<uint8_t> &part,
+                           hlsl::DxilSourceInfoSectionType type,
+                           const std::vector<uint8_t> &data) {
+    hlsl::DxilSourceInfoSection section = {};
+    section.AlignedSizeInBytes = sizeof(section) + data.size();
+    section.AlignedSizeInBytes += (4 - section.AlignedSizeInBytes % 4) % 4;
+    section.Type = type;
+    append(part, &section, sizeof(section));
+    append(part, data.data(), data.size());
+    while (part.size() % 4)
+      part.push_back(0);
+  };
+
+  std::vector<uint8_t> names;
+  std::vector<uint8_t> contents;
+  for (auto &source : sources) {
+    hlsl::DxilSourceInfo_SourceNamesEntry nameEntry = {};
+    nameEntry.NameSizeInBytes = source.first.size() + 1;
+    nameEntry.ContentSizeInBytes = source.second.size() + 1;
+    const size_t nameOffset = names.size();
+    append(names, &nameEntry, sizeof(nameEntry));
+    appendString(names, source.first);
+    nameEntry.AlignedSizeInBytes = names.size() - nameOffset;
+    memcpy(names.data() + nameOffset, &nameEntry, sizeof(nameEntry));
+
+    hlsl::DxilSourceInfo_SourceContentsEntry contentEntry = {};
+    contentEntry.ContentSizeInBytes = source.second.size() + 1;
+    const size_t contentOffset = contents.size();
+    append(contents, &contentEntry, sizeof(contentEntry));
+    appendString(contents, source.second);
+    contentEntry.AlignedSizeInBytes = contents.size() - contentOffset;
+    memcpy(contents.data() + contentOffset, &contentEntry,
+           sizeof(contentEntry));
+  }
+
+  hlsl::DxilSourceInfo_SourceNames namesHeader = {};
+  namesHeader.Count = sources.size();
+  namesHeader.EntriesSizeInBytes = names.size();
+  names.insert(names.begin(), (const uint8_t *)&namesHeader,
+               (const uint8_t *)(&namesHeader + 1));
+
+  // Stored uncompressed; the reader handles both compress types the same
+  // way once the entries are in memory.
+  hlsl::DxilSourceInfo_SourceContents contentsHeader = {};
+  contentsHeader.CompressType =
+      hlsl::DxilSourceInfo_SourceContentsCompressType::None;
+  contentsHeader.EntriesSizeInBytes = contents.size();
+  contentsHeader.UncompressedEntriesSizeInBytes = contents.size();
+  contentsHeader.Count = sources.size();
+  contents.insert(contents.begin(), (const uint8_t *)&contentsHeader,
+                  (const uint8_t *)(&contentsHeader + 1));
+
+  std::vector<uint8_t> part;
+  hlsl::DxilSourceInfo partHeader = {};
+  partHeader.SectionCount = 2;
+  append(part, &partHeader, sizeof(partHeader));
+  appendSection(part, hlsl::DxilSourceInfoSectionType::SourceNames, names);
+  appendSection(part, hlsl::DxilSourceInfoSectionType::SourceContents,
+                contents);
+  partHeader.AlignedSizeInBytes = part.size();
+  memcpy(part.data(), &partHeader, sizeof(partHeader));
+
+  // Wrap the part in a container holding nothing else.
+  std::vector<uint8_t> container(
+      hlsl::GetDxilContainerSizeFromParts(1, part.size()));
+  hlsl::DxilContainerHeader *pHeader =
+      (hlsl::DxilContainerHeader *)container.data();
+  hlsl::InitDxilContainer(pHeader, 1, container.size());
+  uint32_t *pPartOffsets = (uint32_t *)(pHeader + 1);
+  pPartOffsets[0] = sizeof(hlsl::DxilContainerHeader) + sizeof(uint32_t);
+  hlsl::DxilPartHeader *pPart =
+      (hlsl::DxilPartHeader *)(container.data() + pPartOffsets[0]);
+  pPart->PartFourCC = hlsl::DFCC_ShaderSourceInfo;
+  pPart->PartSize = part.size();
+  memcpy(pPart + 1, part.data(), part.size());
+
+  CComPtr<IDxcBlobEncoding> pContainer;
+  CreateBlobPinned(container.data(), container.size(), DXC_CP_ACP, &pContainer);
+
+  CComPtr<IDxcPdbUtils2> pPdbUtils;
+  VERIFY_SUCCEEDED(m_dllSupport.CreateInstance(CLSID_DxcPdbUtils, &pPdbUtils));
+  VERIFY_SUCCEEDED(pPdbUtils->Load(pContainer));
+
+  UINT32 uSourceCount = 0;
+  VERIFY_SUCCEEDED(pPdbUtils->GetSourceCount(&uSourceCount));
+  VERIFY_ARE_EQUAL(uSourceCount, (UINT32)sources.size());
+
+  for (UINT32 i = uSourceCount; i-- > 0;) {
+    CComPtr<IDxcBlobWide> pFileName;
+    VERIFY_SUCCEEDED(pPdbUtils->GetSourceName(i, &pFileName));
+    std::wstring expectedName(sources[i].first.begin(), sources[i].first.end());
+    VERIFY_ARE_EQUAL_WSTR(expectedName.c_str(), pFileName->GetStringPointer());
+
+    CComPtr<IDxcBlobEncoding> pFileContent;
+    VERIFY_SUCCEEDED(pPdbUtils->GetSource(i, &pFileContent));
+    CComPtr<IDxcBlobUtf8> pFileContentUtf8;
+    VERIFY_SUCCEEDED(pFileContent.QueryInterface(&pFileContentUtf8));
+    std::string content(pFileContentUtf8->GetStringPointer(),
+                        pFileContentUtf8->GetStringLength());
+    VERIFY_ARE_EQUAL_STR(content.c_str(), sources[i].second.c_str());
+  }
+}
+
 TEST_F(CompilerTest, CompileThenTestPdbUtilsWarningOpt) {
   CComPtr<IDxcCompiler> pCompiler;
   VERIFY_SUCCEEDED(CreateCompiler(&pCompiler));
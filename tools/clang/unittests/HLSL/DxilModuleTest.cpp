@@ -10,6 +10,7 @@
 #include "dxc/DXIL/DxilModule.h"
 #include "dxc/DXIL/DxilInstructions.h"
 #include "dxc/DXIL/DxilOperations.h"
+#include "dxc/DXIL/DxilUtil.h"
 #include "dxc/DxilContainer/DxilContainer.h"
 #include "dxc/HLSL/HLOperationLowerExtension.h"
 #include "dxc/HlslIntrinsicOp.h"
@@ -20,6 +21,7 @@
 #include "dxc/dxcapi.internal.h"
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/Support/ErrorOr.h"
 #include "llvm/Support/FileSystem.h"
@@ -73,6 +75,10 @@ public:
 
   TEST_METHOD(CanonicalSystemValueSemantic)
 
+  TEST_METHOD(LoadDebugModuleSkippingDebugInfo)
+
+  TEST_METHOD(MaterializeFunctionsLazily)
+
   void VerifyValidatorVersionFails(LPCWSTR shaderModel,
                                    const std::vector<LPCWSTR> &arguments,
                                    const std::vector<LPCSTR> &expectedErrors);
@@ -621,3 +627,118 @@ TEST_F(DxilModuleTest, CanonicalSystemValueSemantic) {
                      1, 4, 0, 0, 0, {0});
   VERIFY_ARE_EQUAL_STR("SV_Position", newElt->GetSemanticName().data());
 }
+
+TEST_F(DxilModuleTest, LoadDebugModuleSkippingDebugInfo) {
+  Compiler c(m_dllSupport);
+  c.Compile("float4 main(float4 c : COLOR) : SV_Target {\n"
+            "  float4 r = c * 2;\n"
+            "  return r;\n"
+            "}\n",
+            L"ps_6_0", {L"-Zi", L"-Qembed_debug"}, {});
+  CComPtr<IDxcBlob> pBlob;
+  CheckOperationSucceeded(c.pCompileResult, &pBlob);
+
+  // Get the debug module bitcode from the container.
+  const DxilContainerHeader *pContainer =
+      IsDxilContainerLike(pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+  VERIFY_IS_NOT_NULL(pContainer);
+  const DxilPartHeader *pPart =
+      GetDxilPartByType(pContainer, DFCC_ShaderDebugInfoDXIL);
+  VERIFY_IS_NOT_NULL(pPart);
+  const char *pIL;
+  uint32_t ILLength;
+  GetDxilProgramBitcode(
+      reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart)),
+      &pIL, &ILLength);
+  StringRef Bitcode(pIL, ILLength);
+
+  auto HasDebugInfo = [](Module &M) {
+    bool Found = M.getNamedMetadata("llvm.dbg.cu") != nullptr;
+    for (Function &F : M)
+      for (Instruction &I : inst_range(F))
+        Found |= I.getDebugLoc() || isa<DbgInfoIntrinsic>(&I);
+    return Found;
+  };
+
+  std::string DiagStr;
+  LLVMContext FullContext;
+  std::unique_ptr<Module> pFull =
+      dxilutil::LoadModuleFromBitcode(Bitcode, FullContext, DiagStr);
+  VERIFY_IS_NOT_NULL(pFull.get());
+  VERIFY_IS_TRUE(HasDebugInfo(*pFull));
+
+  // Skipping debug info leaves the rest of the module intact.
+  LLVMContext SkipContext;
+  std::unique_ptr<Module> pSkipped = dxilutil::LoadModuleFromBitcode(
+      Bitcode, SkipContext, DiagStr, /*bSkipDebugInfo*/ true);
+  VERIFY_IS_NOT_NULL(pSkipped.get());
+  VERIFY_IS_FALSE(HasDebugInfo(*pSkipped));
+  DxilModule &DM = pSkipped->GetOrCreateDxilModule();
+  VERIFY_IS_NOT_NULL(DM.GetEntryFunction());
+  VERIFY_ARE_EQUAL_STR("main", DM.GetEntryFunctionName().c_str());
+  auto CountNonDebugInstructions = [](Module &M) {
+    unsigned Count = 0;
+    for (Instruction &I : inst_range(M.getFunction("main")))
+      Count += !isa<DbgInfoIntrinsic>(&I);
+    return Count;
+  };
+  VERIFY_ARE_EQUAL(CountNonDebugInstructions(*pFull),
+                   CountNonDebugInstructions(*pSkipped));
+}
+
+TEST_F(DxilModuleTest, MaterializeFunctionsLazily) {
+  Compiler c(m_dllSupport);
+  c.Compile("RWBuffer<float> buf;\n"
+            "export void foo(uint i) { buf[i] = 1; }\n"
+            "export void bar(uint i) { buf[i] = 2; }\n",
+            L"lib_6_3", {}, {});
+  CComPtr<IDxcBlob> pBlob;
+  CheckOperationSucceeded(c.pCompileResult, &pBlob);
+
+  const DxilContainerHeader *pContainer =
+      IsDxilContainerLike(pBlob->GetBufferPointer(), pBlob->GetBufferSize());
+  VERIFY_IS_NOT_NULL(pContainer);
+  const DxilPartHeader *pPart = GetDxilPartByType(pContainer, DFCC_DXIL);
+  VERIFY_IS_NOT_NULL(pPart);
+  const char *pIL;
+  uint32_t ILLength;
+  GetDxilProgramBitcode(
+      reinterpret_cast<const DxilProgramHeader *>(GetDxilPartData(pPart)),
+      &pIL, &ILLength);
+
+  std::string DiagStr;
+  LLVMContext Context;
+  std::unique_ptr<Module> pModule = dxilutil::LoadModuleFromBitcodeLazy(
+      StringRef(pIL, ILLength), Context, DiagStr);
+  VERIFY_IS_NOT_NULL(pModule.get());
+
+  // Metadata-derived state is available before any body is materialized.
+  DxilModule &DM = pModule->GetOrCreateDxilModule();
+  VERIFY_ARE_EQUAL(1u, DM.GetUAVs().size());
+  VERIFY_IS_TRUE(DM.HasUnmaterializedFunctions());
+
+  Function *pFoo = nullptr;
+  Function *pBar = nullptr;
+  for (Function &F : *pModule) {
+    if (F.getName().find("foo") != StringRef::npos)
+      pFoo = &F;
+    else if (F.getName().find("bar") != StringRef::npos)
+      pBar = &F;
+  }
+  VERIFY_IS_NOT_NULL(pFoo);
+  VERIFY_IS_NOT_NULL(pBar);
+  VERIFY_IS_TRUE(pFoo->isMaterializable());
+  VERIFY_IS_TRUE(pBar->isMaterializable());
+
+  // Materializing one function leaves the others in bitcode.
+  DM.MaterializeFunction(pFoo);
+  VERIFY_IS_FALSE(pFoo->isMaterializable());
+  VERIFY_IS_FALSE(pFoo->empty());
+  VERIFY_IS_TRUE(pBar->isMaterializable());
+  VERIFY_IS_TRUE(DM.HasUnmaterializedFunctions());
+
+  DM.MaterializeAllFunctions();
+  VERIFY_IS_FALSE(pBar->isMaterializable());
+  VERIFY_IS_FALSE(pBar->empty());
+  VERIFY_IS_FALSE(DM.HasUnmaterializedFunctions());
+}
@@ -21,6 +21,8 @@
 
 #include "llvm/Support/raw_os_ostream.h"
 
+#include <chrono>
+
 #include <../lib/DxilDia/DxilDiaSession.h>
 
 #include "PixTestUtils.h"
@@ -147,6 +149,7 @@ public:
   TEST_METHOD(DiaLoadRelocatedBitcode)
   TEST_METHOD(DiaLoadBitcodePlusExtraData)
   TEST_METHOD(DiaCompileArgs)
+  TEST_METHOD(DiaFindLinesInLargeShader)
 
   TEST_METHOD(PixTypeManager_InheritancePointerStruct)
   TEST_METHOD(PixTypeManager_InheritancePointerTypedef)
@@ -1297,6 +1300,102 @@ TEST_F(PixDiaTest, DiaCompileArgs) {
   }
 }
 
+TEST_F(PixDiaTest, DiaFindLinesInLargeShader) {
+  // One statement per line, so that every line maps to a few instructions.
+  const unsigned kStatements = 500;
+  std::string source = "RWStructuredBuffer<float> buf : register(u0);\n"
+                       "[numthreads(1, 1, 1)]\n"
+                       "void main(uint id : SV_DispatchThreadID) {\n"
+                       "  float v = buf[id];\n";
+  for (unsigned i = 0; i < kStatements; ++i) {
+    source += "  v = v * " + std::to_string(i + 2) + ".0f + buf[id + " +
+              std::to_string(i + 1) + "];\n";
+  }
+  source += "  buf[id] = v;\n}\n";
+
+  CComPtr<IDiaDataSource> pDiaDataSource;
+  CompileAndRunAnnotationAndLoadDiaSource(m_dllSupport, source.c_str(),
+                                          L"cs_6_0", nullptr, &pDiaDataSource);
+  CComPtr<IDiaSession> pSession;
+  VERIFY_SUCCEEDED(pDiaDataSource->openSession(&pSession));
+  CComPtr<IDiaEnumTables> pEnumTables;
+  VERIFY_SUCCEEDED(pSession->getEnumTables(&pEnumTables));
+
+  CComPtr<IDiaEnumLineNumbers> pAllLines;
+  LONG tableCount;
+  VERIFY_SUCCEEDED(pEnumTables->get_Count(&tableCount));
+  for (LONG i = 0; i < tableCount && !pAllLines; ++i) {
+    CComPtr<IDiaTable> pTable;
+    ULONG fetched;
+    VERIFY_SUCCEEDED(pEnumTables->Next(1, &pTable, &fetched));
+    VERIFY_ARE_EQUAL(fetched, 1u);
+    pTable.QueryInterface(&pAllLines);
+  }
+  VERIFY_IS_NOT_NULL(pAllLines.p);
+
+  struct LineInfo {
+    DWORD Rva;
+    DWORD Line;
+    CComPtr<IDiaSourceFile> File;
+  };
+  std::vector<LineInfo> lines;
+  for (;;) {
+    CComPtr<IDiaLineNumber> pLine;
+    ULONG fetched = 0;
+    if (pAllLines->Next(1, &pLine, &fetched) != S_OK || fetched != 1)
+      break;
+    LineInfo info;
+    VERIFY_SUCCEEDED(pLine->get_relativeVirtualAddress(&info.Rva));
+    VERIFY_SUCCEEDED(pLine->get_lineNumber(&info.Line));
+    VERIFY_SUCCEEDED(pLine->get_sourceFile(&info.File));
+    lines.push_back(info);
+  }
+  VERIFY_IS_TRUE(lines.size() >= kStatements);
+
+  // Every lookup must find the line it was derived from; the times are
+  // logged so that regressions on large shaders are easy to spot.
+  WEX::TestExecution::SetVerifyOutput verifySettings(
+      WEX::TestExecution::VerifyOutputSettings::LogOnlyFailures);
+  auto contains = [](IDiaEnumLineNumbers *pEnum, DWORD rva, DWORD line) {
+    for (;;) {
+      CComPtr<IDiaLineNumber> pLine;
+      ULONG fetched = 0;
+      if (pEnum->Next(1, &pLine, &fetched) != S_OK || fetched != 1)
+        return false;
+      DWORD lineRva, lineNumber;
+      VERIFY_SUCCEEDED(pLine->get_relativeVirtualAddress(&lineRva));
+      VERIFY_SUCCEEDED(pLine->get_lineNumber(&lineNumber));
+      if (lineRva == rva && lineNumber == line)
+        return true;
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (const LineInfo &info : lines) {
+    CComPtr<IDiaEnumLineNumbers> pLines;
+    VERIFY_SUCCEEDED(pSession->findLinesByRVA(info.Rva, 1, &pLines));
+    VERIFY_IS_TRUE(contains(pLines, info.Rva, info.Line));
+  }
+  auto byRva = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (const LineInfo &info : lines) {
+    CComPtr<IDiaEnumLineNumbers> pLines;
+    VERIFY_SUCCEEDED(pSession->findLinesByLinenum(nullptr, info.File,
+                                                  info.Line, 0, &pLines));
+    VERIFY_IS_TRUE(contains(pLines, info.Rva, info.Line));
+  }
+  auto byLine = std::chrono::steady_clock::now() - start;
+
+  LogCommentFmt(
+      L"%u line records: findLinesByRVA %lld us, findLinesByLinenum %lld us",
+      (unsigned)lines.size(),
+      (long long)std::chrono::duration_cast<std::chrono::microseconds>(byRva)
+          .count(),
+      (long long)std::chrono::duration_cast<std::chrono::microseconds>(byLine)
+          .count());
+}
+
 TEST_F(PixDiaTest, DiaLoadBitcodePlusExtraData) {
   // Test that dia doesn't crash when bitcode has unused extra data at the end
 
@@ -0,0 +1,115 @@
+//===- DxilValueCacheTest.cpp - DxilValueCache tests ----------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/DxilValueCache.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+// %y is computed from %x, which is computed from the phi %p. The phi merges
+// two different constants, so none of them are known until it is edited.
+const char *DependentsAssembly =
+    "define i32 @test(i1 %c) {\n"
+    "entry:\n"
+    "  br i1 %c, label %a, label %b\n"
+    "a:\n"
+    "  br label %m\n"
+    "b:\n"
+    "  br label %m\n"
+    "m:\n"
+    "  %p = phi i32 [ 1, %a ], [ 2, %b ]\n"
+    "  %x = add i32 %p, %p\n"
+    "  %y = add i32 %x, 1\n"
+    "  ret i32 %y\n"
+    "}\n";
+
+class DxilValueCacheTest : public testing::Test {
+protected:
+  void ParseAssembly(const char *Assembly) {
+    SMDiagnostic Error;
+    M = parseAssemblyString(Assembly, Error, Context);
+
+    std::string errMsg;
+    raw_string_ostream os(errMsg);
+    Error.print("", os);
+
+    // A failure here means that the test itself is buggy.
+    if (!M)
+      report_fatal_error(os.str().c_str());
+
+    Function *F = M->getFunction("test");
+    for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+      if (I->getName() == "p")
+        P = cast<PHINode>(&*I);
+      else if (I->getName() == "y")
+        Y = &*I;
+    }
+    if (!P || !Y)
+      report_fatal_error("@test must have instructions %p and %y");
+  }
+
+  ConstantInt *GetInt(unsigned Value) {
+    return ConstantInt::get(Type::getInt32Ty(Context), Value);
+  }
+
+  LLVMContext Context;
+  std::unique_ptr<Module> M;
+  PHINode *P = nullptr;
+  Instruction *Y = nullptr;
+};
+
+TEST_F(DxilValueCacheTest, InvalidateRecomputesDependents) {
+  ParseAssembly(DependentsAssembly);
+  DxilValueCache DVC;
+  EXPECT_EQ(nullptr, DVC.GetConstValue(Y));
+
+  // In-place edits are not observed, so the unknown result is kept...
+  P->setIncomingValue(1, GetInt(1));
+  EXPECT_EQ(nullptr, DVC.GetConstValue(Y));
+
+  // ...until the edited value is invalidated, which also forgets everything
+  // that was computed from it.
+  DVC.Invalidate(P);
+  EXPECT_EQ(GetInt(3), DVC.GetConstValue(Y));
+}
+
+TEST_F(DxilValueCacheTest, ReplacedValueRecomputesDependents) {
+  ParseAssembly(DependentsAssembly);
+  DxilValueCache DVC;
+  EXPECT_EQ(nullptr, DVC.GetConstValue(Y));
+
+  // Replacing a value is observed by the cache without any explicit call.
+  P->replaceAllUsesWith(GetInt(5));
+  P->eraseFromParent();
+  EXPECT_EQ(GetInt(11), DVC.GetConstValue(Y));
+}
+
+TEST_F(DxilValueCacheTest, KnownResultsAreKept) {
+  ParseAssembly(DependentsAssembly);
+  DxilValueCache DVC;
+  P->setIncomingValue(1, GetInt(1));
+  EXPECT_EQ(GetInt(3), DVC.GetConstValue(Y));
+
+  // Known results are never invalidated, since edits preserve semantics.
+  DVC.Invalidate(P);
+  EXPECT_EQ(GetInt(3), DVC.GetConstValue(Y));
+}
+
+} // end anonymous namespace
@@ -0,0 +1,171 @@
+#!/usr/bin/env python
+"""A signature packing comparison program.
+
+This is a python program that compiles a set of shaders with each signature
+packing strategy and reports the number of rows used by every signature, so
+that -pack-minimal-rows can be compared against -pack-optimized (and the
+default prefix-stable packing) on a corpus of real shaders.
+
+Shaders are given on the command line, or generated with --generate: random
+pixel shader inputs with mixed widths, arrays and interpolation modes, which
+are the interfaces where greedy packing tends to waste rows, e.g.:
+
+  python compare_signature_packing.py --dxc path/to/dxc --generate 500
+  python compare_signature_packing.py --dxc dxc -T vs_6_0 shaders/*.hlsl
+"""
+
+from __future__ import print_function
+import argparse
+import os
+import random
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+STRATEGIES = [
+    ("prefix-stable", "-pack-prefix-stable"),
+    ("optimized", "-pack-optimized"),
+    ("minimal-rows", "-pack-minimal-rows"),
+]
+
+SIGNATURE_RE = re.compile(r"^; (Input|Output|Patch Constant) signature:")
+
+
+def count_signature_rows(disassembly):
+  """Returns {signature name: rows used} from dxc disassembly."""
+  rows = {}
+  current = None
+  in_table = False
+  for line in disassembly.splitlines():
+    match = SIGNATURE_RE.match(line)
+    if match:
+      current = match.group(1)
+      rows[current] = 0
+      in_table = False
+      continue
+    if current is None:
+      continue
+    if line.startswith("; ----"):
+      in_table = True
+      continue
+    if not in_table:
+      continue
+    fields = line[1:].split() if line.startswith(";") else []
+    if not fields:
+      current = None
+      continue
+    # Name Index Mask Register SysValue Format Used
+    if len(fields) >= 4 and fields[3].isdigit():
+      rows[current] = max(rows[current], int(fields[3]) + 1)
+  return rows
+
+
+def generate_shader(rand, max_fields):
+  types = ["float", "float2", "float3", "float4"]
+  modes = ["", "centroid ", "nointerpolation ", "noperspective "]
+  lines = ["struct PS_IN {"]
+  uses = []
+  for i in range(rand.randint(2, max_fields)):
+    ty = rand.choice(types)
+    array = "[%d]" % rand.randint(2, 3) if rand.random() < 0.2 else ""
+    mode = rand.choice(modes) if rand.random() < 0.3 else ""
+    lines.append("  %s%s f%d%s : F%d;" % (mode, ty, i, array, i))
+    uses.append("i.f%d%s" % (i, "[1]" if array else ""))
+  lines.append("};")
+  lines.append("float4 main(PS_IN i) : SV_Target {")
+  lines.append("  float4 r = 0;")
+  for use in uses:
+    lines.append("  r += (float4)%s.xxxx;" % use)
+  lines.append("  return r;")
+  lines.append("}")
+  return "\n".join(lines) + "\n"
+
+
+def compile_rows(dxc, path, target, entry, flag):
+  args = [dxc, "-T", target, "-E", entry, flag, path]
+  start = time.time()
+  proc = subprocess.Popen(args, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                          universal_newlines=True)
+  out, err = proc.communicate()
+  elapsed = time.time() - start
+  if proc.returncode != 0:
+    sys.stderr.write("%s failed:\n%s" % (" ".join(args), err))
+    return None, elapsed
+  return count_signature_rows(out), elapsed
+
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument("files", nargs="*", help="Shaders to compile.")
+  parser.add_argument("--dxc", default="dxc", help="Path to dxc.")
+  parser.add_argument("-T", dest="target", default="ps_6_0",
+                      help="Target profile for the given shaders.")
+  parser.add_argument("-E", dest="entry", default="main",
+                      help="Entry point for the given shaders.")
+  parser.add_argument("--generate", type=int, default=0,
+                      help="Number of random pixel shaders to add.")
+  parser.add_argument("--max-fields", type=int, default=16,
+                      help="Maximum number of inputs in generated shaders.")
+  parser.add_argument("--seed", type=int, default=0,
+                      help="Random seed for generated shaders.")
+  parser.add_argument("-v", "--verbose", action="store_true",
+                      help="Print rows for every signature that differs.")
+  args = parser.parse_args()
+
+  jobs = [(path, args.target) for path in args.files]
+  tmpdir = None
+  if args.generate:
+    tmpdir = tempfile.mkdtemp(prefix="sigpack")
+    rand = random.Random(args.seed)
+    for i in range(args.generate):
+      path = os.path.join(tmpdir, "gen%d.hlsl" % i)
+      with open(path, "w") as f:
+        f.write(generate_shader(rand, args.max_fields))
+      jobs.append((path, "ps_6_0"))
+  if not jobs:
+    parser.error("no shaders given")
+
+  totals = dict((name, 0) for name, _ in STRATEGIES)
+  times = dict((name, 0.0) for name, _ in STRATEGIES)
+  signatures = improved = failed = 0
+  try:
+    for path, target in jobs:
+      results = {}
+      for name, flag in STRATEGIES:
+        rows, elapsed = compile_rows(args.dxc, path, target, args.entry, flag)
+        times[name] += elapsed
+        if rows is None:
+          break
+        results[name] = rows
+      if len(results) != len(STRATEGIES):
+        failed += 1
+        continue
+      for sig in sorted(results["optimized"]):
+        signatures += 1
+        for name, _ in STRATEGIES:
+          totals[name] += results[name].get(sig, 0)
+        optimized = results["optimized"][sig]
+        minimal = results["minimal-rows"].get(sig, 0)
+        if minimal < optimized:
+          improved += 1
+        if args.verbose and minimal != optimized:
+          print("%s %s: optimized %d, minimal-rows %d" %
+                (path, sig, optimized, minimal))
+  finally:
+    if tmpdir:
+      shutil.rmtree(tmpdir)
+
+  print("shaders: %d (%d failed), signatures: %d" %
+        (len(jobs), failed, signatures))
+  for name, _ in STRATEGIES:
+    print("%-14s rows: %6d  compile time: %.2fs" %
+          (name, totals[name], times[name]))
+  print("signatures using fewer rows with -pack-minimal-rows: %d" % improved)
+
+
+if __name__ == "__main__":
+  main()
@@ -0,0 +1,57 @@
+#!/usr/bin/env python
+"""An intrinsic-heavy shader creation program.
+
+This is a python program that creates an HLSL pixel shader made of one long
+chain of intrinsic calls: math intrinsics, texture samples and loads and
+typed buffer loads, spread over several resources. Every statement becomes
+one or more HL intrinsic calls, so the shader stresses builtin operation
+lowering (the DXIL Generator pass) and everything that creates dx.op calls.
+
+One good use of this program is to time builtin lowering, e.g.:
+
+  python create_intrinsic_heavy_shader.py 20000 > big.hlsl
+  dxc -T ps_6_0 -ftime-report big.hlsl
+"""
+
+from __future__ import print_function
+import argparse
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument('statements', type=int,
+                      help="Number of intrinsic statements in the shader.")
+  parser.add_argument('--textures', type=int, default=8,
+                      help="Number of textures in the texture array.")
+  args = parser.parse_args()
+  if args.statements < 1 or args.textures < 1:
+    print("All counts must be positive")
+    return
+
+  print("Texture2D<float4> T[%d] : register(t0);" % args.textures)
+  print("RWBuffer<float4> B : register(u0);")
+  print("SamplerState S : register(s0);")
+  print("cbuffer C { float4 k[64]; };")
+  print("")
+  print("float4 main(float4 p : TEXCOORD0) : SV_Target {")
+  print("  float4 a = p;")
+  for i in range(args.statements):
+    kind = i % 6
+    t = i % args.textures
+    if kind == 0:
+      print("  a += sin(a * k[%d]);" % (i % 64))
+    elif kind == 1:
+      print("  a = mad(a, k[%d], cos(a));" % (i % 64))
+    elif kind == 2:
+      print("  a += T[%d].Sample(S, a.xy + %d.0);" % (t, i))
+    elif kind == 3:
+      print("  a += B.Load(%d + (uint)a.x);" % i)
+    elif kind == 4:
+      print("  a = max(sqrt(abs(a)), frac(a * %d.5));" % (i % 17))
+    else:
+      print("  a += T[%d].Load(int3((int)a.x, %d, 0));" % (t, i % 97))
+  print("  return a;")
+  print("}")
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python
+"""A large-struct shader creation program.
+
+This is a python program that creates HLSL source code with large nested
+structs, arrays of structs and struct copies between locals, static globals
+and function parameters. Shaders like these (material systems, skinning data)
+are the worst case for the HLSL scalar replacement passes, which have to
+flatten every field and split every aggregate copy.
+
+One good use of this program is to check that SROA compile time grows
+linearly with the number of fields, e.g.:
+
+  python create_large_struct_shader.py 200 > big.hlsl
+  dxc -T ps_6_0 -ftime-report big.hlsl
+"""
+
+from __future__ import print_function
+import argparse
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__)
+  parser.add_argument('fields', type=int,
+                      help="Number of fields in the outer struct.")
+  parser.add_argument('--array-size', type=int, default=4,
+                      help="Number of elements in the array of structs.")
+  parser.add_argument('--copies', type=int, default=8,
+                      help="Number of helper functions copying the struct.")
+  args = parser.parse_args()
+  if args.fields < 1 or args.array_size < 1 or args.copies < 1:
+    print("All counts must be positive")
+    return
+
+  types = ["float", "float2", "float3", "float4", "int", "uint2"]
+  print("struct Inner {")
+  print("  float4 a;")
+  print("  float3x3 m;")
+  print("  int2 b[2];")
+  print("};")
+  print("struct Material {")
+  for i in range(args.fields):
+    if i % 8 == 7:
+      print("  Inner f%d;" % i)
+    else:
+      print("  %s f%d;" % (types[i % len(types)], i))
+  print("};")
+  print("struct Skin {")
+  print("  Material mats[%d];" % args.array_size)
+  print("  float4x4 bones[%d];" % args.array_size)
+  print("};")
+  print("cbuffer CB { Material g_cbMat; uint g_idx; };")
+  print("static Skin s_skin;")
+  print("")
+
+  for c in range(args.copies):
+    print("Material Tweak%d(Material m, inout Skin s) {" % c)
+    print("  Material r = m;")
+    for i in range(c, args.fields, args.copies):
+      if i % 8 == 7:
+        print("  r.f%d.a += s.bones[%d][0];" % (i, c % args.array_size))
+      else:
+        print("  r.f%d += (%s)%d;" % (i, types[i % len(types)], c + 1))
+    print("  s.mats[%d] = r;" % (c % args.array_size))
+    print("  return r;")
+    print("}")
+    print("")
+
+  print("float4 main(float4 pos : SV_Position) : SV_Target {")
+  print("  Material m = g_cbMat;")
+  print("  for (uint i = 0; i < %d; ++i) s_skin.mats[i] = m;" % args.array_size)
+  for c in range(args.copies):
+    print("  m = Tweak%d(m, s_skin);" % c)
+  print("  Material picked = s_skin.mats[g_idx %% %d];" % args.array_size)
+  print("  float4 acc = pos;")
+  for i in range(args.fields):
+    if i % 8 == 7:
+      print("  acc += picked.f%d.a + m.f%d.a;" % (i, i))
+    elif types[i % len(types)] in ("float", "int"):
+      print("  acc.x += picked.f%d + m.f%d;" % (i, i))
+    elif types[i % len(types)] in ("float2", "uint2"):
+      print("  acc.xy += picked.f%d + m.f%d;" % (i, i))
+    else:
+      n = 3 if types[i % len(types)] == "float3" else 4
+      print("  acc.%s += picked.f%d + m.f%d;" % ("xyzw"[:n], i, i))
+  print("  return acc;")
+  print("}")
+
+if __name__ == '__main__':
+  main()
@@ -6067,6 +6067,7 @@ class db_dxil(object):
                 {"n": "rt-width", "t": "int", "c": 1},
                 {"n": "sv-position-index", "t": "int", "c": 1},
                 {"n": "num-pixels", "t": "int", "c": 1},
+                {"n": "wave-aggregate", "t": "bool", "c": 1},
             ],
         )
         add_pass(
@@ -6109,6 +6110,7 @@ class db_dxil(object):
             [
                 {"n": "config", "t": "int", "c": 1},
                 {"n": "checkForDynamicIndexing", "t": "bool", "c": 1},
+                {"n": "waveAggregate", "t": "bool", "c": 1},
             ],
         )
         add_pass(
@@ -6122,6 +6124,9 @@ class db_dxil(object):
                 {"n": "parameter0", "t": "int", "c": 1},
                 {"n": "parameter1", "t": "int", "c": 1},
                 {"n": "parameter2", "t": "int", "c": 1},
+                {"n": "WaveAggregatedCounter", "t": "bool", "c": 1},
+                {"n": "CompactSteps", "t": "bool", "c": 1},
+                {"n": "SampleRate", "t": "int", "c": 1},
             ],
         )
         add_pass(